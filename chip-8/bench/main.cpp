@@ -0,0 +1,620 @@
+// Benchmark of the interpreter, written as JSON.
+//
+// Runs a ROM headless (the built-in Pong without --rom) for a number of emulated frames and
+// reports the wall time and, where perf_event is permitted, the hardware counters per frame
+// and per opcode class. Without perf the counters are reported as unavailable with the
+// reason, and the wall time is still measured. The wall time is also measured with the
+// COSMAC VIP timing, which runs as many instructions a frame as fit its cycles. With
+// --trace it records the instructions into a compressed trace there, and reports what
+// recording and reading it back cost. With --search it also searches the key inputs that
+// many levels deep, keeping the --beam best states a level, on --threads threads (0 for a
+// thread a core), and reports the states a second. It first checks the bytes the terminal
+// renderer writes for small changes, which the viewers' rate budget is spent on, and exits
+// with 1 if they grew.
+//
+// Built with UTIL_COUNT_ALLOCATIONS it also counts the heap allocations of the frame loop
+// after a warm up, by subsystem, and exits with 2 if the steady state allocates. The loop
+// presents every frame as the demo does, packing, caching, converting and scaling the
+// screen into a pixmap with the HUD over it.
+//
+// Usage: Chip8Bench [--rom <path>] [--frames <count>] [--cycles <per frame>] [--json <path>]
+//                   [--trace <path>] [--search <depth>] [--beam <states>] [--threads <count>]
+
+#define UTL_ALLOCATION_COUNTER_IMPLEMENTATION
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <util/signal.hpp>
+#include <util/allocation-counter.h>
+#include <platform/pixmap.h>
+#include <platform/hud.h>
+#include <platform/present-cache.h>
+#include <platform/resizer.h>
+#include <chip-8/chip.hpp>
+#include <chip-8/perf-counters.h>
+#include <chip-8/trace.h>
+#include <chip-8/terminal-renderer.h>
+#include <chip-8/frame-delta.h>
+#include <chip-8/frame-sink.h>
+#include <chip-8/state-search.hpp>
+#include <chip-8/rom-file.h>
+
+namespace
+{
+
+using Spec = chip8::Chip8Spec;
+
+// Values is a std::array, so argument dependent lookup doesn't find these.
+using chip8::operator-;
+using chip8::operator+=;
+
+struct Options
+{
+	std::string rom_path;
+	uint32_t    frames           = 100000u;
+	uint32_t    cycles_per_frame = 10u;
+	std::string json_path;
+	std::string trace_path;
+	uint32_t    search_depth     = 0u;
+	uint32_t    beam             = 512u;
+	uint32_t    threads          = 0u;
+};
+
+// The per opcode class pass reads the counters twice per instruction, so it runs less.
+constexpr auto kMaxProfiledFrames = 10000u;
+
+// The frames the search holds a key for, and runs the machine before it starts.
+constexpr auto kSearchFrames       = 4u;
+constexpr auto kSearchWarmUpFrames = 60u;
+
+// Frames run before allocations count, for buffers that are allocated once.
+constexpr auto kWarmUpFrames = 60u;
+
+// The window size and the present cache of the demo.
+constexpr auto kPresentWidth         = 320u;
+constexpr auto kPresentHeight        = 160u;
+constexpr auto kPresentCacheCapacity = 16u;
+constexpr auto kChannels             = 3u;
+
+// The counts of every subsystem.
+using AllocationCounts = std::array<utl::AllocationCounter::Counts, utl::AllocationCounter::kMaxSubsystemCount>;
+
+AllocationCounts get_allocation_counts ()
+{
+	auto counts = AllocationCounts();
+	for (auto i = 0u; i != counts.size(); ++i)
+		counts[i] = utl::AllocationCounter::get_counts(i);
+
+	return counts;
+}
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--rom")
+			options.rom_path = value;
+		else if (option == "--frames")
+			options.frames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--cycles")
+			options.cycles_per_frame = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--json")
+			options.json_path = value;
+		else if (option == "--trace")
+			options.trace_path = value;
+		else if (option == "--search")
+			options.search_depth = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--beam")
+			options.beam = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--threads")
+			options.threads = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+			return false;
+	}
+
+	return options.frames > 0 && options.cycles_per_frame > 0 && options.beam > 0;
+}
+
+// The render callback of the demo, less the window: from the screen of a machine to a pixmap.
+class Presenter
+{
+	using Packed = chip8::PackedFrame<Spec>;
+
+public:
+	Presenter ()
+		:
+		size_   { kPresentWidth, kPresentHeight                                       },
+		cache_  (kPresentWidth * kPresentHeight * kChannels, kPresentCacheCapacity    ),
+		resizer_(                                                                     ),
+		screen_ (Spec::kVRamSize * kChannels                                          ),
+		sink_   (Spec::kScreenWidth, Spec::kScreenHeight, chip8::PixelFormat::kRgb24,
+		         screen_.data()                                                       ),
+		pixmap_ (size_                                                                ),
+		hud_    (                                                                     )
+	{
+		hud_.set_text("60 fps\n600 ips");
+	}
+
+	template <typename Machine>
+	bool present (const Machine& chip)
+	{
+		auto packed = std::array<uint8_t, Packed::kSize>();
+		Packed::pack(chip.get_vram().data(), packed.data());
+
+		const auto hash = chip8::hash_bytes(0u, packed.data(), packed.size());
+
+		auto image = cache_.find(hash);
+		if (nullptr == image)
+		{
+			const auto scaled = cache_.insert(hash);
+
+			sink_.write(chip);
+			if (!resizer_.resize(screen_.data(), { Spec::kScreenWidth, Spec::kScreenHeight }, scaled, size_, kChannels))
+				return false;
+
+			image = scaled;
+		}
+
+		pixmap_.update(cache_.get_image_size(), image);
+		hud_.draw(pixmap_);
+
+		return true;
+	}
+
+	const plt::PresentCache& get_cache () const noexcept
+	{
+		return cache_;
+	}
+
+private:
+	utl::Vec2<uint32_t>  size_;
+	plt::PresentCache    cache_;
+	plt::Resizer         resizer_;
+	std::vector<uint8_t> screen_;
+	chip8::FrameSink     sink_;
+	plt::Pixmap          pixmap_;
+	plt::Hud             hud_;
+};
+
+// The bytes the terminal renderer writes for one changed cell and for a run of them.
+bool check_terminal_renderer ()
+{
+	using Packed = chip8::PackedFrame<Spec>;
+
+	// A move to the top left and a glyph.
+	constexpr auto kCellBytes = 4u + 3u;
+	// A move to the second cell and seven glyphs, the cursor going along.
+	constexpr auto kRunBytes  = 6u + 7u * 3u;
+
+	auto renderer = chip8::TerminalRenderer(Spec::kScreenWidth, Spec::kScreenHeight, Spec::kPlaneCount);
+	auto frame    = std::vector<uint8_t>(Packed::kSize);
+
+	frame[0] = 0x80;
+	const auto cell_bytes = renderer.render_frame(frame.data()).size();
+
+	frame[0] = 0xFF;
+	const auto run_bytes = renderer.render_frame(frame.data()).size();
+
+	if (kCellBytes != cell_bytes || kRunBytes != run_bytes)
+	{
+		std::cerr << "The terminal renderer wrote " << cell_bytes << " bytes for a cell (" << kCellBytes << " expected) and "
+		          << run_bytes << " for a run of 7 (" << kRunBytes << " expected)" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+template <typename Machine>
+void run_frame (Machine& chip, uint32_t cycles)
+{
+	chip.run_frame(cycles);
+}
+
+// Counts the instructions the timed frames run, which the timing decides.
+struct InstructionCounter : chip8::NoHooks
+{
+	template <typename Machine>
+	constexpr void after_execute (const Machine&) noexcept
+	{
+		++count;
+	}
+
+	uint64_t count = 0u;
+};
+
+// What recording a trace of the run and reading it back cost.
+struct TraceCost
+{
+	uint64_t records   = 0u;
+	uint64_t bytes     = 0u;
+	double   record_ns = 0.0;  // The wall time of the run, the writer's flush included.
+	double   read_ns   = 0.0;  // The wall time of reading every record in order, and replaying it.
+};
+
+template <typename Image>
+bool measure_trace (const Image& image, const Options& options, TraceCost& cost)
+{
+	auto chip = chip8::Chip<Spec, chip8::DefaultQuirks<Spec>, chip8::TraceRecorder>(image);
+	chip.seed(0x1u);
+
+	const auto begin = std::chrono::steady_clock::now();
+	{
+		auto writer = chip8::TraceWriter(options.trace_path, true);
+		if (!writer.is_open())
+		{
+			std::cerr << "Fail to open the trace: " << options.trace_path << std::endl;
+			return false;
+		}
+
+		chip.hooks().attach(&writer);
+		for (auto i = 0u; i != options.frames; ++i)
+			run_frame(chip, options.cycles_per_frame);
+		chip.hooks().attach(nullptr);
+
+		cost.records = writer.get_record_count();
+	}
+	cost.record_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+	cost.bytes     = static_cast<uint64_t>(std::ifstream(options.trace_path, std::ios::binary | std::ios::ate).tellg());
+
+	auto reader = chip8::TraceReader(options.trace_path);
+	if (!reader.is_open() || reader.size() != cost.records)
+	{
+		std::cerr << "Fail to read the trace back: " << options.trace_path << std::endl;
+		return false;
+	}
+
+	// Reads every record back, and checks them against a machine run again beside them.
+	auto record  = chip8::TraceRecord();
+	auto replay  = chip8::Chip<Spec>(image);
+	auto matches = true;
+	replay.seed(0x1u);
+
+	const auto read_begin = std::chrono::steady_clock::now();
+	for (auto i = uint64_t { 0 }; i != reader.size(); ++i)
+	{
+		if (!reader.read(i, record))
+		{
+			std::cerr << "The trace is corrupt at record " << i << std::endl;
+			return false;
+		}
+
+		matches = matches && record.pc == replay.get_pc() && record.opcode == replay.fetch();
+		replay.instruction_cycle();
+	}
+	cost.read_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - read_begin).count();
+
+	if (!matches)
+	{
+		std::cerr << "The trace doesn't hold the run: " << options.trace_path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// What searching the key inputs cost.
+struct SearchCost
+{
+	uint32_t threads  = 0u;
+	uint64_t expanded = 0u;  // The states run, the ones seen before included.
+	size_t   seen     = 0u;
+	double   ns       = 0.0;
+};
+
+template <typename Image>
+bool measure_search (const Image& image, const Options& options, SearchCost& cost)
+{
+	using Machine = chip8::Chip<Spec>;
+
+	auto root = Machine(image, 0x1u);
+	for (auto i = 0u; i != kSearchWarmUpFrames; ++i)
+		run_frame(root, options.cycles_per_frame);
+
+	auto pool   = utl::ThreadPool(0 != options.threads ? options.threads : std::thread::hardware_concurrency());
+	auto search = chip8::StateSearch<Machine>(pool, options.cycles_per_frame);
+
+	// The register Pong keeps the score in, which is as good a score as any for the cost.
+	search.set_scorer([](const Machine& chip) { return chip.get_v(0xE); });
+	search.reset(root);
+
+	const auto begin = std::chrono::steady_clock::now();
+	for (auto depth = 0u; depth != options.search_depth && !search.get_level().empty(); ++depth)
+	{
+		search.expand(kSearchFrames);
+		search.prune(options.beam);
+	}
+	cost.ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+	cost.threads  = pool.get_thread_count();
+	cost.expanded = search.get_expanded_count();
+	cost.seen     = search.get_seen_count();
+
+	if (search.get_level().empty())
+		return true;
+
+	// Holding the keys of the best state from the root must reach it.
+	const auto best   = search.get_best();
+	auto       replay = root;
+	for (const auto key : search.get_keys(best))
+	{
+		replay.set_key(key);
+		for (auto i = 0u; i != kSearchFrames; ++i)
+			run_frame(replay, options.cycles_per_frame);
+	}
+
+	if (replay.get_state_hash() != search.get_level()[best].hash)
+	{
+		std::cerr << "The keys of the best state don't reach it!!!" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void write_values (std::ostream& os, const chip8::PerfCounters& counters, const chip8::PerfCounters::Values& values, double divisor)
+{
+	os << "{";
+	for (auto i = 0u; i != chip8::PerfCounters::kCounterCount; ++i)
+	{
+		const auto counter = static_cast<chip8::PerfCounters::Counter>(i);
+
+		os << (i ? ", " : "") << "\"" << chip8::PerfCounters::get_name(counter) << "\": ";
+		if (counters.is_available(counter))
+			os << values[i] / divisor;
+		else
+			os << "null";
+	}
+	os << "}";
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--rom <path>] [--frames <count>] [--cycles <per frame>] [--json <path>]" << std::endl
+		          << "       [--trace <path>] [--search <depth>] [--beam <states>] [--threads <count>]" << std::endl;
+		return 1;
+	}
+
+	auto rom = std::vector<uint8_t>(std::begin(chip8::kPong), std::end(chip8::kPong));
+	if (!options.rom_path.empty())
+	{
+		const auto error = chip8::load_rom(options.rom_path, 1u, chip8::get_max_rom_size<Spec>(), rom);
+		if (chip8::RomError::kNone != error)
+		{
+			std::cerr << chip8::get_message(error) << ": " << options.rom_path << std::endl;
+			return 1;
+		}
+	}
+
+	if (!check_terminal_renderer())
+		return 1;
+
+	const auto image = chip8::Chip<Spec>::make_image(rom.data(), rom.size());
+
+	// Wall time, nothing else running.
+	auto chip = chip8::Chip<Spec>(image);
+	chip.seed(0x1u);
+
+	const auto begin = std::chrono::steady_clock::now();
+	for (auto i = 0u; i != options.frames; ++i)
+		run_frame(chip, options.cycles_per_frame);
+	const auto wall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+	// Wall time with the COSMAC VIP timing, which runs the instructions that fit a frame.
+	auto timed = chip8::Chip<Spec, chip8::VipQuirks, InstructionCounter, chip8::FlatMemory<Spec>, chip8::VipTiming>(image);
+	timed.seed(0x1u);
+
+	const auto timed_begin = std::chrono::steady_clock::now();
+	for (auto i = 0u; i != options.frames; ++i)
+		run_frame(timed, options.cycles_per_frame);
+	const auto timed_wall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - timed_begin).count();
+	const auto timed_instructions = static_cast<double>(timed.hooks().count);
+
+	// Wall time recording a trace, and reading it back.
+	auto trace = TraceCost();
+	if (!options.trace_path.empty() && !measure_trace(image, options, trace))
+		return 1;
+
+	// States a second searching the key inputs.
+	auto search = SearchCost();
+	if (0 != options.search_depth && !measure_search(image, options, search))
+		return 1;
+
+	// The counters around every frame.
+	auto counters = chip8::PerfCounters();
+	auto frame    = chip8::PerfCounters::Values();
+	frame.fill(0u);
+
+	chip.reset(image);
+	chip.seed(0x1u);
+	counters.enable();
+	for (auto i = 0u; i != options.frames; ++i)
+	{
+		const auto before = counters.read();
+		run_frame(chip, options.cycles_per_frame);
+		frame += counters.read() - before;
+	}
+	counters.disable();
+
+	// The counters around every instruction, by opcode class.
+	const auto profiled_frames = std::min(options.frames, kMaxProfiledFrames);
+
+	auto profiled = chip8::Chip<Spec, chip8::DefaultQuirks<Spec>, chip8::OpcodeClassProfiler>(image);
+	profiled.seed(0x1u);
+	counters.enable();
+	profiled.hooks().attach(&counters);
+	profiled.hooks().calibrate();
+	for (auto i = 0u; i != profiled_frames; ++i)
+		run_frame(profiled, options.cycles_per_frame);
+	counters.disable();
+
+	// The allocations of the frame loop, which emits the signals of a frame as the window does.
+	auto presenter     = Presenter();
+	auto presented     = true;
+	auto update_signal = utl::Signal<void (void)>();
+	auto render_signal = utl::Signal<void (void)>();
+	update_signal.connect([&chip, &options]()
+	{
+		UTL_ALLOCATION_SCOPE("chip-8");
+		run_frame(chip, options.cycles_per_frame);
+	});
+	render_signal.connect([&chip, &presenter, &presented]()
+	{
+		UTL_ALLOCATION_SCOPE("present");
+		presented = presenter.present(chip) && presented;
+	});
+
+	chip.reset(image);
+	for (auto i = 0u; i != kWarmUpFrames; ++i)
+	{
+		update_signal.emit();
+		render_signal.emit();
+	}
+
+	const auto allocations_before = get_allocation_counts();
+	for (auto i = 0u; i != options.frames; ++i)
+	{
+		UTL_ALLOCATION_SCOPE("frame-loop");
+		update_signal.emit();
+		render_signal.emit();
+	}
+	const auto allocations_after = get_allocation_counts();
+
+	if (!presented)
+	{
+		std::cerr << "Fail to scale the screen" << std::endl;
+		return 1;
+	}
+
+	auto steady_allocations = uint64_t { 0 };
+	for (auto i = 0u; i != allocations_after.size(); ++i)
+		steady_allocations += allocations_after[i].allocations - allocations_before[i].allocations;
+
+	auto json = std::ofstream();
+	if (!options.json_path.empty())
+	{
+		json.open(options.json_path, std::ios::trunc);
+		if (!json)
+		{
+			std::cerr << "Fail to open the output: " << options.json_path << std::endl;
+			return 1;
+		}
+	}
+
+	auto& os = options.json_path.empty() ? std::cout : json;
+	const auto instructions = static_cast<double>(options.frames) * options.cycles_per_frame;
+
+	os << "{\n"
+	   << "  \"rom\": \"" << (options.rom_path.empty() ? "pong" : options.rom_path) << "\",\n"
+	   << "  \"frames\": " << options.frames << ",\n"
+	   << "  \"cycles_per_frame\": " << options.cycles_per_frame << ",\n"
+	   << "  \"wall_ns\": " << wall << ",\n"
+	   << "  \"ns_per_frame\": " << wall / options.frames << ",\n"
+	   << "  \"ns_per_instruction\": " << wall / instructions << ",\n"
+	   << "  \"vip_timing\": { \"ns_per_frame\": " << timed_wall / options.frames
+	   << ", \"instructions_per_frame\": " << timed_instructions / options.frames
+	   << ", \"ns_per_instruction\": " << timed_wall / std::max(timed_instructions, 1.0) << " },\n";
+
+	if (!options.trace_path.empty())
+	{
+		os << "  \"trace\": { \"records\": " << trace.records << ", \"bytes\": " << trace.bytes
+		   << ", \"bytes_per_record\": " << static_cast<double>(trace.bytes) / std::max<uint64_t>(trace.records, 1u)
+		   << ", \"record_ns_per_instruction\": " << trace.record_ns / std::max<uint64_t>(trace.records, 1u)
+		   << ", \"read_ns_per_record\": " << trace.read_ns / std::max<uint64_t>(trace.records, 1u) << " },\n";
+	}
+
+	if (0 != options.search_depth)
+	{
+		os << "  \"search\": { \"depth\": " << options.search_depth << ", \"beam\": " << options.beam
+		   << ", \"frames_per_level\": " << kSearchFrames << ", \"threads\": " << search.threads
+		   << ", \"expanded\": " << search.expanded << ", \"seen\": " << search.seen
+		   << ", \"states_per_second\": " << search.expanded / (search.ns * 1e-9) << " },\n";
+	}
+
+	os << "  \"allocations\": {\n"
+	   << "    \"enabled\": " << (utl::AllocationCounter::is_enabled() ? "true" : "false") << ",\n"
+	   << "    \"warm_up_frames\": " << kWarmUpFrames << ",\n"
+	   << "    \"steady_state\": " << steady_allocations << ",\n"
+	   << "    \"present_cache\": { \"hits\": " << presenter.get_cache().get_hit_count()
+	   << ", \"misses\": " << presenter.get_cache().get_miss_count() << " },\n"
+	   << "    \"per_frame\": {";
+
+	auto first = true;
+	for (auto i = 0u; i != allocations_after.size(); ++i)
+	{
+		const auto name = utl::AllocationCounter::get_name(i);
+		if (nullptr == name)
+			continue;
+
+		const auto allocations = allocations_after[i].allocations - allocations_before[i].allocations;
+		const auto bytes       = allocations_after[i].bytes       - allocations_before[i].bytes;
+
+		os << (first ? "\n" : ",\n")
+		   << "      \"" << name << "\": { \"allocations\": " << static_cast<double>(allocations) / options.frames
+		   << ", \"bytes\": " << static_cast<double>(bytes) / options.frames << " }";
+
+		first = false;
+	}
+
+	os << "\n    }\n"
+	   << "  },\n"
+	   << "  \"perf\": {\n"
+	   << "    \"available\": " << (counters.is_available() ? "true" : "false") << ",\n";
+
+	if (!counters.is_available())
+	{
+		os << "    \"error\": \"" << counters.get_error() << "\"\n"
+		   << "  }\n"
+		   << "}\n";
+
+		return 0 == steady_allocations ? 0 : 2;
+	}
+
+	os << "    \"per_frame\": ";
+	write_values(os, counters, frame, options.frames);
+	os << ",\n"
+	   << "    \"per_opcode_class\": [";
+
+	const auto& totals = profiled.hooks().get_totals();
+	const auto& counts = profiled.hooks().get_counts();
+
+	first = true;
+	for (auto i = 0u; i != chip8::kOpcodeClassCount; ++i)
+	{
+		if (0 == counts[i])
+			continue;
+
+		os << (first ? "\n" : ",\n")
+		   << "      { \"class\": \"" << std::hex << std::uppercase << i << std::dec << "xxx\", "
+		   << "\"count\": " << counts[i] << ", \"per_instruction\": ";
+		write_values(os, counters, totals[i], static_cast<double>(counts[i]));
+		os << " }";
+
+		first = false;
+	}
+
+	os << "\n    ]\n"
+	   << "  }\n"
+	   << "}\n";
+
+	return 0 == steady_allocations ? 0 : 2;
+}
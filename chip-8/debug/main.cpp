@@ -0,0 +1,250 @@
+// A command line stepper for the built-in Pong, on chip8::Debugger.
+//
+// Reads a command a line from the standard input, so it can be scripted, and prints the
+// machine whenever it stops:
+//
+//   b <pc> [<register> <==|!=|<|> > <value>]  sets a breakpoint, with an optional condition
+//   d <pc>                                     clears a breakpoint
+//   w <begin> <end> <r|w|rw>                   sets a watchpoint on [begin, end)
+//   c                                          continues until something stops it
+//   s                                          steps an instruction
+//   n                                          steps over a call
+//   o                                          steps out of the subroutine
+//   p                                          prints the machine
+//   q                                          quits
+//
+// Addresses and values are hexadecimal. A continue stops by itself after --limit
+// instructions, as Pong never ends.
+//
+// Usage: Chip8Debug [--limit <instructions>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <chip-8/chip.hpp>
+#include <chip-8/debugger.hpp>
+
+namespace
+{
+
+using Spec     = chip8::Chip8Spec;
+using Debugger = chip8::Debugger<Spec>;
+using Machine  = chip8::Chip<Spec, chip8::DefaultQuirks<Spec>, Debugger>;
+
+struct Options
+{
+	uint64_t limit = 1000000u;
+};
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--limit")
+			options.limit = std::strtoull(value, nullptr, 10);
+		else
+			return false;
+	}
+
+	return options.limit > 0;
+}
+
+const char* get_name (Debugger::StopReason reason)
+{
+	switch (reason)
+	{
+	case Debugger::StopReason::kBreakpoint:
+		return "breakpoint";
+
+	case Debugger::StopReason::kWatchpoint:
+		return "watchpoint";
+
+	case Debugger::StopReason::kStep:
+		return "step";
+
+	case Debugger::StopReason::kPause:
+		return "pause";
+
+	default:
+		return "running";
+	}
+}
+
+bool parse_comparison (const std::string& token, Debugger::Comparison& comparison)
+{
+	if (token == "==")
+		comparison = Debugger::Comparison::kEqual;
+	else if (token == "!=")
+		comparison = Debugger::Comparison::kNotEqual;
+	else if (token == "<")
+		comparison = Debugger::Comparison::kLess;
+	else if (token == ">")
+		comparison = Debugger::Comparison::kGreater;
+	else
+		return false;
+
+	return true;
+}
+
+bool parse_access (const std::string& token, Debugger::Access& access)
+{
+	if (token == "r")
+		access = Debugger::Access::kRead;
+	else if (token == "w")
+		access = Debugger::Access::kWrite;
+	else if (token == "rw")
+		access = Debugger::Access::kReadWrite;
+	else
+		return false;
+
+	return true;
+}
+
+void print (const Machine& chip)
+{
+	char line[64];
+	std::snprintf(line, sizeof(line), "%-10s pc %03X  opcode %04X  i %03X  sp %u  ",
+	              get_name(chip.hooks().get_stop_reason()), chip.get_pc(), chip.fetch(), chip.get_i(), chip.get_sp());
+	std::cout << line;
+
+	for (auto i = 0u; i != chip8::kGeneralRegisterCount; ++i)
+	{
+		std::snprintf(line, sizeof(line), "%s%02X", i ? " " : "v ", chip.get_v(i));
+		std::cout << line;
+	}
+
+	if (Debugger::StopReason::kWatchpoint == chip.hooks().get_stop_reason())
+	{
+		std::snprintf(line, sizeof(line), "  at %03X", chip.hooks().get_hit_address());
+		std::cout << line;
+	}
+
+	if (chip.is_halted())
+		std::cout << "  halted";
+
+	std::cout << std::endl;
+}
+
+// Runs until the debugger stops the machine, pausing it after limit instructions.
+void run (Machine& chip, uint64_t limit)
+{
+	for (auto i = uint64_t { 0 }; i != limit && !chip.hooks().is_stopped() && !chip.is_halted(); ++i)
+		chip.instruction_cycle();
+
+	if (!chip.hooks().is_stopped() && !chip.is_halted())
+	{
+		chip.hooks().pause();
+		chip.instruction_cycle();
+	}
+
+	print(chip);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--limit <instructions>]" << std::endl;
+		return 1;
+	}
+
+	auto chip = Machine(chip8::kPong.data(), chip8::kPong.size(), 0x1u);
+
+	// Stops before the first instruction.
+	chip.hooks().pause();
+	run(chip, 1u);
+
+	auto line = std::string();
+	while (std::getline(std::cin, line))
+	{
+		auto input   = std::istringstream(line);
+		auto command = std::string();
+		if (!(input >> command))
+			continue;
+
+		input >> std::hex;
+
+		if (command == "b")
+		{
+			auto pc         = 0u;
+			auto index      = 0u;
+			auto token      = std::string();
+			auto value      = 0u;
+			auto comparison = Debugger::Comparison::kEqual;
+
+			if (!(input >> pc))
+				std::cerr << "b <pc> [<register> <==|!=|<|> > <value>]" << std::endl;
+			else if (!(input >> index))
+				chip.hooks().set_breakpoint(pc);
+			else if (input >> token >> value && parse_comparison(token, comparison) && index < chip8::kGeneralRegisterCount)
+				chip.hooks().set_breakpoint(pc, Debugger::Condition { index, comparison, static_cast<uint8_t>(value) });
+			else
+				std::cerr << "b <pc> [<register> <==|!=|<|> > <value>]" << std::endl;
+		}
+		else if (command == "d")
+		{
+			auto pc = 0u;
+			if (input >> pc)
+				chip.hooks().clear_breakpoint(pc);
+			else
+				std::cerr << "d <pc>" << std::endl;
+		}
+		else if (command == "w")
+		{
+			auto begin  = 0u;
+			auto end    = 0u;
+			auto token  = std::string();
+			auto access = Debugger::Access::kReadWrite;
+
+			if (input >> begin >> end >> token && parse_access(token, access) && begin < end)
+				chip.hooks().set_watchpoint(begin, end, access);
+			else
+				std::cerr << "w <begin> <end> <r|w|rw>" << std::endl;
+		}
+		else if (command == "c")
+		{
+			chip.hooks().resume();
+			run(chip, options.limit);
+		}
+		else if (command == "s")
+		{
+			chip.hooks().step();
+			run(chip, options.limit);
+		}
+		else if (command == "n")
+		{
+			chip.hooks().step_over(chip);
+			run(chip, options.limit);
+		}
+		else if (command == "o")
+		{
+			chip.hooks().step_out(chip);
+			run(chip, options.limit);
+		}
+		else if (command == "p")
+		{
+			print(chip);
+		}
+		else if (command == "q")
+		{
+			break;
+		}
+		else
+		{
+			std::cerr << "Unknown command: " << command << std::endl;
+		}
+	}
+
+	return 0;
+}
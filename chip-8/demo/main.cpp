@@ -21,38 +21,124 @@
 // SOFTWARE.
 
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <array>
+#include <chrono>
 #include <string>
 #include <stb/stb_image.h>
-#include <stb/stb_image_resize.h>
 #include <util/singleton.hpp>
 #include <util/singleton-factory.hpp>
+#include <util/tracing.h>
 #include <platform/display.h>
 #include <platform/window.h>
 #include <platform/pixmap.h>
-#include <chip-8/chip.h>
+#include <platform/hud.h>
+#include <platform/present-cache.h>
+#include <platform/resizer.h>
+#include <chip-8/chip.hpp>
+#include <chip-8/run-ahead.hpp>
+#include <chip-8/frame-delta.h>
+#include <chip-8/frame-sink.h>
+#include <chip-8/movie.h>
+#include <chip-8/frame-ring.h>
 
 class Emulator
 {
+	using Spec        = chip8::Chip8Spec;
+	using Machine     = chip8::Chip<Spec>;
+	using PackedFrame = chip8::PackedFrame<Spec>;
+	using Screen      = std::array<uint8_t, Spec::kVRamSize * STBI_rgb>;
+
+	// About 600 instructions per second at 60 frames per second.
+	static constexpr auto kCyclesPerFrame = 10u;
+
+	// The most frames the auto tuned run ahead presents ahead.
+	static constexpr auto kMaxRunAheadFrames = 3u;
+
+	// The scaled screens kept for when the machine shows one of them again.
+	static constexpr auto kPresentCacheCapacity = 16u;
+
+	// The HUD numbers are averaged over this long, which also keeps them readable.
+	static constexpr auto kHudPeriod = std::chrono::milliseconds(500);
+
+	using Clock = std::chrono::steady_clock;
+
+	// The keypad on the left of a keyboard, in the layout of the COSMAC VIP's:
+	//
+	//   1 2 3 4        1 2 3 C
+	//   Q W E R        4 5 6 D
+	//   A S D F   ->   7 8 9 E
+	//   Z X C V        A 0 B F
+	static constexpr char kKeypad[] = "X123QWEASDZC4RFV";
+
+	static uint8_t to_chip8_key (uint32_t key) noexcept
+	{
+		for (auto i = 0u; i != sizeof(kKeypad) - 1; ++i)
+		{
+			if (static_cast<uint32_t>(kKeypad[i]) == key)
+				return static_cast<uint8_t>(i);
+		}
+
+		return chip8::kNoKey;
+	}
+
 public:
-	Emulator ()
+	Emulator (bool hud_enabled, const char* run_ahead, const char* movie_path, const char* export_name, uint64_t frame_limit)
 		:
-		title_     ("Emulator Demo"),
-		size_      { 320, 160      },
-		pixmap_ptr_(nullptr        ),
-		chip_      (               )
+		title_            ("Emulator Demo"                ),
+		size_             { 320, 160                      },
+		pixmap_ptr_       (nullptr                        ),
+		present_cache_    (size_.width * size_.height * 3,
+		                   kPresentCacheCapacity          ),
+		presented_image_  (nullptr                        ),
+		resizer_          (                               ),
+		screen_           (                               ),
+		screen_sink_      (Spec::kScreenWidth,
+		                   Spec::kScreenHeight,
+		                   chip8::PixelFormat::kRgb24,
+		                   screen_.data()                 ),
+		chip_             (                               ),
+		run_ahead_        (chip_, kCyclesPerFrame, 0u     ),
+		movie_ptr_        (nullptr                        ),
+		ring_             (                               ),
+		hud_enabled_      (hud_enabled                    ),
+		hud_              (                               ),
+		hud_time_         (Clock::now()                   ),
+		instruction_count_(0u                             ),
+		render_count_     (0u                             ),
+		frame_count_      (0u                             ),
+		frame_limit_      (frame_limit                    )
 	{
+		if (nullptr != run_ahead)
+		{
+			if (std::string(run_ahead) == "auto")
+				run_ahead_.enable_auto_tune(kMaxRunAheadFrames);
+			else
+				run_ahead_.set_frames(static_cast<uint32_t>(std::strtoul(run_ahead, nullptr, 10)));
+		}
+
+		if (nullptr != movie_path)
+			movie_ptr_ = std::make_unique<chip8::MovieWriter>(movie_path, Spec::kScreenWidth, Spec::kScreenHeight, Spec::kPlaneCount);
+
+		if (nullptr != export_name && !ring_.open(export_name, Spec::kScreenWidth, Spec::kScreenHeight, Spec::kPlaneCount))
+			std::fprintf(stderr, "Fail to export the frames to %s\n", export_name);
+
 		utl::SingletonFactory<plt::Display>::create();
 		utl::SingletonFactory<plt::Window>::create(title_, size_);
 
 		pixmap_ptr_ = std::make_unique<plt::Pixmap>(size_);
-		
+
+		utl::Singleton<plt::Window>::get().update_signal().connect(std::bind(&Emulator::update_callback, this));
 		utl::Singleton<plt::Window>::get().render_signal().connect(std::bind(&Emulator::render_callback, this));
+		utl::Singleton<plt::Window>::get().key_signal().connect(std::bind(&Emulator::key_callback, this, std::placeholders::_1, std::placeholders::_2));
 	}
 
 	~Emulator ()
 	{
+		utl::Singleton<plt::Window>::get().key_signal().disconnect(std::bind(&Emulator::key_callback, this, std::placeholders::_1, std::placeholders::_2));
 		utl::Singleton<plt::Window>::get().render_signal().disconnect(std::bind(&Emulator::render_callback, this));
+		utl::Singleton<plt::Window>::get().update_signal().disconnect(std::bind(&Emulator::update_callback, this));
 
 		pixmap_ptr_ = nullptr;
 
@@ -66,52 +152,177 @@ public:
 	}
 
 private:
+	// The machine holds one key, the one pressed last until it's released.
+	void key_callback (uint32_t key, bool down)
+	{
+		const auto chip8_key = to_chip8_key(key);
+		if (chip8::kNoKey == chip8_key)
+			return;
+
+		if (down)
+			run_ahead_.set_key(chip8_key);
+		else if (chip_.get_key() == chip8_key)
+			run_ahead_.set_key(chip8::kNoKey);
+	}
+
+	void update_callback ()
+	{
+		// A span per instruction would cost more than the instruction, so the frame's
+		// instructions are traced as one.
+		UTL_TRACE_SCOPE("chip-8", "instruction_cycle");
+
+		run_ahead_.run_frame();
+
+		// The real frames, not the ones run ahead.
+		if (movie_ptr_)
+			movie_ptr_->record(chip_);
+
+		if (ring_.is_open())
+			ring_.record(chip_);
+
+		instruction_count_ += kCyclesPerFrame;
+
+		if (++frame_count_ == frame_limit_)
+			utl::Singleton<plt::Window>::get().close();
+	}
+
+	// Formats the numbers once a period, so the HUD lays its text out at most that often.
+	void update_hud ()
+	{
+		const auto now = Clock::now();
+		if (now - hud_time_ < kHudPeriod)
+			return;
+
+		const auto elapsed = std::chrono::duration<double>(now - hud_time_).count();
+
+		const auto& scheduler = utl::Singleton<plt::Window>::get().get_scheduler();
+		const auto& histogram = scheduler.get_frame_time_histogram();
+
+		char text[256];
+		std::snprintf(text, sizeof(text),
+		              "IPS %.0f\n"
+		              "FPS %.1f\n"
+		              "FRAME %.2f MS (P99 %.2f)\n"
+		              "DROPPED %llu\n"
+		              "CACHE %llu HITS %llu MISSES",
+		              instruction_count_ / elapsed,
+		              render_count_ / elapsed,
+		              histogram.get_percentile(0.5),
+		              histogram.get_percentile(0.99),
+		              static_cast<unsigned long long>(scheduler.get_dropped_frame_count()),
+		              static_cast<unsigned long long>(present_cache_.get_hit_count()),
+		              static_cast<unsigned long long>(present_cache_.get_miss_count()));
+
+		hud_.set_text(text);
+
+		hud_time_          = now;
+		instruction_count_ = 0u;
+		render_count_      = 0u;
+	}
+
 	void render_callback ()
 	{
-		chip_.instruction_cycle();
+		// The real machine, or a copy run ahead of it.
+		const auto& chip = run_ahead_.speculate();
+
+		auto packed = std::array<uint8_t, PackedFrame::kSize>();
+		PackedFrame::pack(chip.get_vram().data(), packed.data());
 
-		auto temp = std::array<utl::Vec3<uint8_t>, chip8::kScreenHeight * chip8::kScreenWidth>();
-		for (auto y = 0; y != chip8::kScreenHeight; ++y)
+		const auto hash = chip8::hash_bytes(0u, packed.data(), packed.size());
+
+		auto image = present_cache_.find(hash);
+		if (nullptr == image)
 		{
-			for (auto x = 0; x != chip8::kScreenWidth; ++x)
+			const auto scaled = present_cache_.insert(hash);
+
+			{
+				UTL_TRACE_SCOPE("chip-8", "convert");
+
+				screen_sink_.write(chip);
+			}
+
 			{
-				const auto idx   = y * chip8::kScreenWidth + x;
-				const auto color = (chip_.get_pixel(idx) == 0) ? 0 : 255;
+				UTL_TRACE_SCOPE("chip-8", "resize");
 
-				temp[idx].r = temp[idx].g = temp[idx].b = color;
+				resizer_.resize(screen_.data(), { Spec::kScreenWidth, Spec::kScreenHeight }, scaled, size_, STBI_rgb);
 			}
+
+			image = scaled;
 		}
 
-#ifdef PLATFORM_WIN32
+		auto& pixmap = *pixmap_ptr_;
 
-		auto pixmap = plt::Pixmap(size_);
+		// The pixmap still holds the image unless the HUD was drawn over it.
+		if (image != presented_image_ || hud_enabled_)
+		{
+			UTL_TRACE_SCOPE("chip-8", "present");
 
-		stbir_resize_uint8(reinterpret_cast<uint8_t*>(temp.data()),
-			               chip8::kScreenWidth,
-			               chip8::kScreenHeight,
-			               chip8::kScreenWidth * STBI_rgb,
-			               reinterpret_cast<uint8_t*>(pixmap.get_dib_ptr()),
-			               size_.width,
-			               size_.height,
-			               size_.width * STBI_rgb,
-			               STBI_rgb);
+			pixmap.update(present_cache_.get_image_size(), image);
+			presented_image_ = image;
+		}
 
-		utl::Singleton<plt::Window>::get().draw(pixmap);
+		if (hud_enabled_)
+		{
+			UTL_TRACE_SCOPE("chip-8", "hud");
 
-#endif
+			++render_count_;
+			update_hud();
+			hud_.draw(pixmap);
+		}
 
+		utl::Singleton<plt::Window>::get().draw(pixmap);
 	}
 
 private:
-	std::string                  title_;
-	utl::Vec2<uint32_t>          size_;
-	std::unique_ptr<plt::Pixmap> pixmap_ptr_;
-	chip8::Chip                  chip_;
+	std::string                         title_;
+	utl::Vec2<uint32_t>                 size_;
+	std::unique_ptr<plt::Pixmap>        pixmap_ptr_;
+	plt::PresentCache                   present_cache_;
+	const uint8_t*                      presented_image_;
+	plt::Resizer                        resizer_;
+	Screen                              screen_;
+	chip8::FrameSink                    screen_sink_;
+	Machine                             chip_;
+	chip8::RunAhead<Machine>            run_ahead_;
+	std::unique_ptr<chip8::MovieWriter> movie_ptr_;
+	chip8::FrameRingWriter              ring_;
+	bool                                hud_enabled_;
+	plt::Hud                            hud_;
+	Clock::time_point                   hud_time_;
+	uint64_t                            instruction_count_;
+	uint64_t                            render_count_;
+	uint64_t                            frame_count_;
+	uint64_t                            frame_limit_;  // 0 for none.
 };
 
 int main(int argc, char* argv[])
 {
-	Emulator().run();
+	// CHIP8_TRACE=<path> records the session as Chrome trace events into path.
+	const auto trace_path = std::getenv("CHIP8_TRACE");
+	utl::Tracing::enable(nullptr != trace_path);
+
+	// CHIP8_HUD=1 shows the performance numbers over the screen.
+	const auto hud = std::getenv("CHIP8_HUD");
+
+	// CHIP8_RUN_AHEAD=<frames> presents the screen that many frames ahead to hide input lag,
+	// CHIP8_RUN_AHEAD=auto measures how many frames the program lags.
+	const auto run_ahead = std::getenv("CHIP8_RUN_AHEAD");
+
+	// CHIP8_MOVIE=<path> records the frames, the keys and the sound timer into a movie.
+	const auto movie_path = std::getenv("CHIP8_MOVIE");
+
+	// CHIP8_EXPORT=<name> publishes the frames into a shared memory ring, e.g. for Chip8Peek.
+	const auto export_name = std::getenv("CHIP8_EXPORT");
+
+	// CHIP8_FRAMES=<count> quits after that many frames, e.g. to record a movie headless,
+	// where nothing else but SIGINT or SIGTERM closes the window.
+	const auto frames      = std::getenv("CHIP8_FRAMES");
+	const auto frame_limit = nullptr != frames ? std::strtoull(frames, nullptr, 10) : 0u;
+
+	Emulator(nullptr != hud && '0' != hud[0], run_ahead, movie_path, export_name, frame_limit).run();
+
+	if (nullptr != trace_path)
+		utl::Tracing::write_json(trace_path);
 
 	return 0;
 }
\ No newline at end of file
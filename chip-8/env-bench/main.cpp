@@ -0,0 +1,157 @@
+// Benchmark of the vectorized environments, through their C interface (Chip8Env).
+//
+// Steps --envs environments of the ROM (the built-in Pong without --rom) with random keys
+// on --threads threads (0 for a thread a core) and reports the steps a second, which is
+// --envs frames each, and the episodes that ended. The episodes are cut at --episode
+// frames, and a reward hook reads the score, as a trainer's would.
+//
+// Built with UTIL_COUNT_ALLOCATIONS it also counts the heap allocations of the step loop
+// after a warm up, and exits with 2 if it allocates.
+//
+// Usage: Chip8EnvBench [--envs <count>] [--steps <count>] [--threads <count>] [--bytes]
+//                      [--episode <frames>] [--rom <path>]
+
+#define UTL_ALLOCATION_COUNTER_IMPLEMENTATION
+
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iterator>
+#include <util/allocation-counter.h>
+#include <chip-8/roms.h>
+#include <chip-8/rom-file.h>
+#include <chip-8/vec-env-c.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+	uint32_t    envs    = 1024u;
+	uint32_t    steps   = 2000u;
+	uint32_t    threads = 0u;
+	bool        bytes   = false;
+	uint32_t    episode = 1800u;
+	std::string rom_path;
+};
+
+// Steps run before allocations count, for buffers that are allocated once.
+constexpr auto kWarmUpSteps = 10u;
+
+// The actions are drawn up front, from this many sets, so drawing isn't measured.
+constexpr auto kActionSetCount = 64u;
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (option == "--bytes")
+		{
+			options.bytes = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--envs")
+			options.envs = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--steps")
+			options.steps = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--threads")
+			options.threads = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--episode")
+			options.episode = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--rom")
+			options.rom_path = value;
+		else
+			return false;
+	}
+
+	return options.envs > 0 && options.steps > 0;
+}
+
+// The register Pong keeps the score in, ten a point of the left player and one of the right.
+double read_score (const uint8_t* registers, const uint8_t*, void*)
+{
+	return registers[0xE];
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--envs <count>] [--steps <count>] [--threads <count>] [--bytes]" << std::endl
+		          << "       [--episode <frames>] [--rom <path>]" << std::endl;
+		return 1;
+	}
+
+	auto rom = std::vector<uint8_t>(std::begin(chip8::kPong), std::end(chip8::kPong));
+	if (!options.rom_path.empty())
+	{
+		const auto error = chip8::load_rom(options.rom_path, 1u, chip8::get_max_rom_size<chip8::Chip8Spec>(), rom);
+		if (chip8::RomError::kNone != error)
+		{
+			std::cerr << chip8::get_message(error) << ": " << options.rom_path << std::endl;
+			return 1;
+		}
+	}
+
+	const auto format = options.bytes ? CHIP8_OBSERVATION_BYTES : CHIP8_OBSERVATION_PACKED;
+	const auto envs   = chip8_vec_env_create(rom.data(), rom.size(), options.envs, 10u, format, options.threads);
+	if (nullptr == envs)
+	{
+		std::cerr << "Fail to create the environments!!!" << std::endl;
+		return 1;
+	}
+
+	chip8_vec_env_set_reward(envs, read_score, nullptr);
+	chip8_vec_env_set_max_frames(envs, options.episode);
+	chip8_vec_env_reset(envs, 1u);
+
+	auto random  = std::minstd_rand(1u);
+	auto actions = std::vector<uint8_t>(size_t { kActionSetCount } * options.envs);
+	for (auto& action : actions)
+		action = 0 == random() % 3 ? CHIP8_NO_KEY : static_cast<uint8_t>(random() % 0x10);
+
+	for (auto i = 0u; i != kWarmUpSteps; ++i)
+		chip8_vec_env_step(envs, actions.data() + i % kActionSetCount * options.envs);
+
+	const auto allocations = utl::AllocationCounter::get_total().allocations;
+	const auto begin       = Clock::now();
+
+	auto episodes = uint64_t { 0 };
+	for (auto i = 0u; i != options.steps; ++i)
+	{
+		chip8_vec_env_step(envs, actions.data() + i % kActionSetCount * options.envs);
+
+		const auto ends = chip8_vec_env_get_ends(envs);
+		for (auto j = 0u; j != options.envs; ++j)
+			episodes += CHIP8_EPISODE_NONE != ends[j];
+	}
+
+	const auto seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+	const auto steady  = utl::AllocationCounter::get_total().allocations - allocations;
+
+	std::cout << "envs " << options.envs << ", " << (options.bytes ? "byte" : "packed") << " observations of "
+	          << chip8_vec_env_get_observation_size(envs) << " bytes, " << options.steps << " steps in " << seconds << " s" << std::endl
+	          << "  " << options.steps / seconds << " steps/s, " << options.steps / seconds * options.envs << " frames/s, "
+	          << seconds * 1e9 / options.steps / options.envs << " ns a frame" << std::endl
+	          << "  " << episodes << " episodes ended, "
+	          << (utl::AllocationCounter::is_enabled() ? std::to_string(steady) : std::string("uncounted")) << " allocations" << std::endl;
+
+	chip8_vec_env_destroy(envs);
+
+	return 0 == steady ? 0 : 2;
+}
@@ -0,0 +1,73 @@
+// libFuzzer target for the interpreter.
+//
+// The first byte of the input selects the machine, the rest is loaded as the ROM and runs
+// for at most kCycleBudget instructions. Every machine is constructed once and reset for
+// each input, so an execution costs about two copies of MEM_ and a memset of GFX_ plus
+// the cycles.
+// A fault (unknown opcode, stack overflow or underflow) is a normal way to stop, anything
+// the sanitizers catch or a broken invariant below is a bug.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <chip-8/chip.hpp>
+
+namespace
+{
+
+constexpr auto kCycleBudget = 4096u;
+
+// A distinct hook type keeps the machines out of the explicit instantiations in chip.cpp,
+// so they're compiled into this target with the coverage instrumentation.
+struct FuzzHooks : chip8::NoHooks
+{
+};
+
+template <typename Spec>
+void run (const uint8_t* data, size_t size)
+{
+	using Machine = chip8::Chip<Spec, chip8::DefaultQuirks<Spec>, FuzzHooks>;
+
+	static auto chip  = Machine();
+	static auto image = typename Machine::Image();
+
+	// With FlatMemory the boot image is the memory itself, so it's built in place.
+	Machine::make_boot_memory(image, data, std::min<size_t>(size, Spec::kDRamSize - chip8::kProgramMemoryOffset));
+	chip.reset(image);
+	chip.seed(0x1u);
+
+	for (auto i = 0u; i != kCycleBudget && !chip.is_halted(); ++i)
+		chip.instruction_cycle();
+
+	if (chip.get_sp() > Spec::kStackSize)
+		std::abort();
+
+	if (chip.get_fault() != chip8::Fault::kNone && !chip.is_halted())
+		std::abort();
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t* data, size_t size)
+{
+	if (0 == size)
+		return 0;
+
+	switch (data[0] % 3)
+	{
+	case 0:
+		run<chip8::Chip8Spec>(data + 1, size - 1);
+		break;
+
+	case 1:
+		run<chip8::SuperChipSpec>(data + 1, size - 1);
+		break;
+
+	default:
+		run<chip8::XoChipSpec>(data + 1, size - 1);
+		break;
+	}
+
+	return 0;
+}
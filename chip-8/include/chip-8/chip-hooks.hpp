@@ -0,0 +1,39 @@
+#ifndef CHIP_HOOKS_H
+#define CHIP_HOOKS_H
+
+#include <cstdint>
+
+namespace chip8
+{
+
+// The hook policy Chip calls around every instruction and every data access of MEM_.
+// A policy has the same members as NoHooks, whose empty bodies compile to nothing.
+struct NoHooks
+{
+	// Called before the instruction at PC is executed, returning false stops the machine there.
+	template <typename Machine>
+	constexpr bool before_execute (const Machine&) noexcept
+	{
+		return true;
+	}
+
+	// Called after the instruction is executed, unless before_execute stopped it.
+	template <typename Machine>
+	constexpr void after_execute (const Machine&) noexcept
+	{
+	}
+
+	// Called after size bytes are read from MEM_ at address. (Instruction fetches aren't reported)
+	constexpr void on_read (uint32_t, uint32_t) noexcept
+	{
+	}
+
+	// Called after size bytes are written to MEM_ at address.
+	constexpr void on_write (uint32_t, uint32_t) noexcept
+	{
+	}
+};
+
+}  // namespace chip8
+
+#endif // CHIP_HOOKS_H
@@ -0,0 +1,312 @@
+#ifndef CHIP_MEMORY_H
+#define CHIP_MEMORY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <bitset>
+#include <memory>
+#include <vector>
+
+#include "chip-spec.h"
+
+namespace chip8
+{
+
+constexpr auto kPageShift = 8u;
+constexpr auto kPageSize  = 0x1u << kPageShift;
+constexpr auto kPageMask  = kPageSize - 1;
+
+template <typename Spec>
+using DRam = std::array<uint8_t, Spec::kDRamSize>;
+
+using Page = std::array<uint8_t, kPageSize>;
+
+// Mixes a 64 bit word into a hash of machine state. Not cryptographic, but every bit of
+// the word reaches every bit of the hash.
+inline uint64_t hash_word (uint64_t hash, uint64_t word) noexcept
+{
+	word *= 0x87C37B91114253D5ull;
+	word  = (word << 31) | (word >> 33);
+	hash ^= word * 0x4CF5AD432745937Full;
+	hash  = (hash << 27) | (hash >> 37);
+
+	return hash * 5 + 0x52DCE729;
+}
+
+// Mixes the whole words of the data, without the bytes after the last one.
+inline uint64_t hash_words (uint64_t hash, const uint8_t* data, size_t size) noexcept
+{
+	for (auto i = size_t { 0 }; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		auto word = uint64_t { 0 };
+		std::memcpy(&word, data + i, sizeof(word));
+		hash = hash_word(hash, word);
+	}
+
+	return hash;
+}
+
+// Mixes the data and its size.
+inline uint64_t hash_bytes (uint64_t hash, const uint8_t* data, size_t size) noexcept
+{
+	hash = hash_words(hash, data, size);
+
+	auto tail = uint64_t { size };
+	for (auto i = size / sizeof(uint64_t) * sizeof(uint64_t); i != size; ++i)
+		tail = tail << 8 | data[i];
+
+	return hash_word(hash, tail);
+}
+
+// The memory policy Chip stores MEM_ with. A policy is built from an Image, the memory
+// right after boot (fontset and program), and reset() restores it to the image.
+// Chip masks every address to the memory size before it reaches the policy.
+
+// One flat array, which is what every instance used to have. The only policy that works in
+// constant evaluation, so machines can be booted and run at compile time.
+template <typename Spec>
+class FlatMemory
+{
+public:
+	using Image = DRam<Spec>;
+
+	static constexpr Image make_image (const DRam<Spec>& memory)
+	{
+		return memory;
+	}
+
+	explicit constexpr FlatMemory (const Image& image)
+		:
+		data_(image)
+	{
+	}
+
+	// Restores the boot image in one bulk copy.
+	void reset (const Image& image)
+	{
+		data_ = image;
+	}
+
+	constexpr uint8_t operator[] (uint32_t address) const noexcept
+	{
+		return data_[address];
+	}
+
+	constexpr void write (uint32_t address, uint8_t value) noexcept
+	{
+		data_[address] = value;
+	}
+
+	uint64_t hash (uint64_t seed) const noexcept
+	{
+		return hash_bytes(seed, data_.data(), data_.size());
+	}
+
+	// All of the memory in one piece, which only this policy has.
+	const uint8_t* data () const noexcept
+	{
+		return data_.data();
+	}
+
+	static constexpr size_t size () noexcept
+	{
+		return Spec::kDRamSize;
+	}
+
+private:
+	DRam<Spec> data_;
+};
+
+// The read only pages of a boot image, with identical pages (e.g. zero pages) stored once.
+template <typename Spec>
+class PageImage
+{
+public:
+	static constexpr auto kPageCount = Spec::kDRamSize / kPageSize;
+
+	explicit PageImage (const DRam<Spec>& memory)
+		:
+		pages_(),
+		table_()
+	{
+		// Reserved up front, so the page pointers stay valid while pages are added.
+		pages_.reserve(kPageCount);
+
+		for (auto i = 0u; i != kPageCount; ++i)
+		{
+			const auto source = memory.data() + i * kPageSize;
+
+			auto found = false;
+			for (const auto& page : pages_)
+			{
+				if (std::memcmp(page.data(), source, kPageSize) == 0)
+				{
+					table_[i] = page.data();
+					found     = true;
+					break;
+				}
+			}
+
+			if (found)
+				continue;
+
+			pages_.emplace_back();
+			std::memcpy(pages_.back().data(), source, kPageSize);
+			table_[i] = pages_.back().data();
+		}
+	}
+
+	const uint8_t* page (uint32_t index) const noexcept
+	{
+		return table_[index];
+	}
+
+	// The number of distinct pages stored.
+	size_t get_page_count () const noexcept
+	{
+		return pages_.size();
+	}
+
+private:
+	std::vector<Page>                      pages_;
+	std::array<const uint8_t*, kPageCount> table_;
+};
+
+// Pages of the shared boot image until they're written, then private copies.
+//
+// Every instance booted from one image shares its pages, so thousands of instances of a ROM
+// cost only the pages each of them writes. A private page is kept over reset(), so an
+// instance that is reset and run again copies into it without allocating.
+template <typename Spec>
+class PagedMemory
+{
+	static constexpr auto kPageCount = PageImage<Spec>::kPageCount;
+
+public:
+	using Image = std::shared_ptr<const PageImage<Spec>>;
+
+	static Image make_image (const DRam<Spec>& memory)
+	{
+		return std::make_shared<const PageImage<Spec>>(memory);
+	}
+
+	explicit PagedMemory (const Image& image)
+		:
+		image_  (),
+		pages_  (),
+		private_(),
+		owned_  ()
+	{
+		reset(image);
+	}
+
+	PagedMemory (const PagedMemory& other)
+		:
+		image_  (other.image_),
+		pages_  (other.pages_),
+		private_(            ),
+		owned_  (other.owned_)
+	{
+		for (auto i = 0u; i != kPageCount; ++i)
+		{
+			if (!owned_[i])
+				continue;
+
+			private_[i] = std::make_unique<Page>(*other.private_[i]);
+			pages_  [i] = private_[i]->data();
+		}
+	}
+
+	PagedMemory& operator= (const PagedMemory& other)
+	{
+		if (this == &other)
+			return *this;
+
+		image_ = other.image_;
+		pages_ = other.pages_;
+		owned_ = other.owned_;
+
+		for (auto i = 0u; i != kPageCount; ++i)
+		{
+			if (!owned_[i])
+				continue;
+
+			if (nullptr == private_[i])
+				private_[i] = std::make_unique<Page>();
+
+			*private_[i] = *other.private_[i];
+			pages_[i]    = private_[i]->data();
+		}
+
+		return *this;
+	}
+
+	// Maps every page back to the image. The private pages stay allocated for reuse.
+	void reset (const Image& image)
+	{
+		image_ = image;
+		owned_.reset();
+
+		for (auto i = 0u; i != kPageCount; ++i)
+			pages_[i] = image_->page(i);
+	}
+
+	uint8_t operator[] (uint32_t address) const noexcept
+	{
+		return pages_[address >> kPageShift][address & kPageMask];
+	}
+
+	void write (uint32_t address, uint8_t value)
+	{
+		const auto index = address >> kPageShift;
+
+		if (!owned_[index])
+			copy_on_write(index);
+
+		(*private_[index])[address & kPageMask] = value;
+	}
+
+	// Equals the hash of a FlatMemory with the same content.
+	uint64_t hash (uint64_t seed) const noexcept
+	{
+		for (auto i = 0u; i != kPageCount; ++i)
+			seed = hash_words(seed, pages_[i], kPageSize);
+
+		return hash_word(seed, Spec::kDRamSize);
+	}
+
+	static constexpr size_t size () noexcept
+	{
+		return Spec::kDRamSize;
+	}
+
+	// The number of pages this instance doesn't share with the image.
+	size_t get_private_page_count () const noexcept
+	{
+		return owned_.count();
+	}
+
+private:
+	void copy_on_write (uint32_t index)
+	{
+		if (nullptr == private_[index])
+			private_[index] = std::make_unique<Page>();
+
+		std::memcpy(private_[index]->data(), pages_[index], kPageSize);
+
+		pages_[index] = private_[index]->data();
+		owned_.set(index);
+	}
+
+private:
+	Image                                         image_;
+	std::array<const uint8_t*, kPageCount>        pages_;
+	std::array<std::unique_ptr<Page>, kPageCount> private_;
+	std::bitset<kPageCount>                       owned_;
+};
+
+}  // namespace chip8
+
+#endif // CHIP_MEMORY_H
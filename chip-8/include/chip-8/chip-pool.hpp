@@ -0,0 +1,78 @@
+#ifndef CHIP_POOL_H
+#define CHIP_POOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <util/noncopyable.h>
+
+namespace chip8
+{
+
+// Machines running one program, all booted from one image.
+//
+//   using Machine = Chip<Chip8Spec, VipQuirks, NoHooks, PagedMemory<Chip8Spec>>;
+//
+//   auto pool = ChipPool<Machine>(rom.data(), rom.size());
+//   auto chip = pool.acquire();
+//   ...
+//   pool.release(chip);
+//
+// With PagedMemory every machine shares the pages of the image until it writes them.
+// A released machine is reset and handed out again by acquire, and the machines are
+// never moved, so the pointers stay valid for the lifetime of the pool.
+template <typename Machine>
+class ChipPool : private utl::Noncopyable
+{
+public:
+	using Image = typename Machine::Image;
+
+	ChipPool (const uint8_t* program, size_t size)
+		:
+		image_   (Machine::make_image(program, size)),
+		machines_(                                  ),
+		free_    (                                  )
+	{
+	}
+
+	Machine* acquire ()
+	{
+		if (free_.empty())
+		{
+			machines_.emplace_back(image_);
+			return &machines_.back();
+		}
+
+		const auto machine = free_.back();
+		free_.pop_back();
+
+		return machine;
+	}
+
+	void release (Machine* machine)
+	{
+		machine->reset(image_);
+		free_.push_back(machine);
+	}
+
+	const Image& get_image () const noexcept
+	{
+		return image_;
+	}
+
+	// The number of machines constructed, including the released ones.
+	size_t size () const noexcept
+	{
+		return machines_.size();
+	}
+
+private:
+	Image                 image_;
+	std::deque<Machine>   machines_;
+	std::vector<Machine*> free_;
+};
+
+}  // namespace chip8
+
+#endif // CHIP_POOL_H
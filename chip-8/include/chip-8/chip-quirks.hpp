@@ -0,0 +1,127 @@
+#ifndef CHIP_QUIRKS_H
+#define CHIP_QUIRKS_H
+
+#include <type_traits>
+
+#include "chip-spec.h"
+
+namespace chip8
+{
+
+// Which register 8xy6 and 8xyE shift.
+enum class ShiftSource
+{
+	kVY,
+	kVX
+};
+
+// What Fx55 and Fx65 do to I.
+enum class LoadStore
+{
+	kIncrementI,
+	kKeepI
+};
+
+// Which register Bnnn adds to NNN. (BxNN jumps to XNN plus VX)
+enum class JumpOffset
+{
+	kV0,
+	kVX
+};
+
+// What Dxyn does with the pixels past the screen edges.
+enum class SpriteEdge
+{
+	kClip,
+	kWrap
+};
+
+// The quirks are resolved at compile time, every combination is its own instantiation of Chip.
+template <ShiftSource Shift,
+          LoadStore   Memory,
+          JumpOffset  Jump,
+          SpriteEdge  Edge,
+          bool        ResetVF>
+struct Quirks
+{
+	static constexpr auto kShiftSource  = Shift;
+	static constexpr auto kLoadStore    = Memory;
+	static constexpr auto kJumpOffset   = Jump;
+	static constexpr auto kSpriteEdge   = Edge;
+	static constexpr auto kLogicResetVF = ResetVF;
+};
+
+// The original COSMAC VIP interpreter.
+using VipQuirks       = Quirks<ShiftSource::kVY,
+                               LoadStore::kIncrementI,
+                               JumpOffset::kV0,
+                               SpriteEdge::kClip,
+                               true>;
+
+// SUPER-CHIP 1.1 on the HP 48.
+using SuperChipQuirks = Quirks<ShiftSource::kVX,
+                               LoadStore::kKeepI,
+                               JumpOffset::kVX,
+                               SpriteEdge::kClip,
+                               false>;
+
+// Octo's XO-CHIP.
+using XoChipQuirks    = Quirks<ShiftSource::kVY,
+                               LoadStore::kIncrementI,
+                               JumpOffset::kV0,
+                               SpriteEdge::kWrap,
+                               false>;
+
+template <typename Spec>
+using DefaultQuirks   = std::conditional_t<Spec::kOpcodeSet == OpcodeSet::kChip8,     VipQuirks,
+                        std::conditional_t<Spec::kOpcodeSet == OpcodeSet::kSuperChip, SuperChipQuirks,
+                                                                                     XoChipQuirks>>;
+
+// The runtime description of the quirks, usually read from a ROM database.
+struct QuirkFlags
+{
+	ShiftSource shift_source;
+	LoadStore   load_store;
+	JumpOffset  jump_offset;
+	SpriteEdge  sprite_edge;
+	bool        logic_reset_vf;
+};
+
+namespace detail
+{
+
+template <typename Function>
+decltype(auto) dispatch (bool value, Function&& function)
+{
+	return value ? function(std::true_type()) : function(std::false_type());
+}
+
+}  // namespace detail
+
+// Calls function with the Quirks instance matching flags, so the caller can pick
+// the specialized Chip once per ROM instead of branching once per instruction.
+template <typename Function>
+decltype(auto) visit_quirks (const QuirkFlags& flags, Function&& function)
+{
+	using detail::dispatch;
+
+	return dispatch(flags.shift_source == ShiftSource::kVX, [&](auto shift_vx) {
+	return dispatch(flags.load_store   == LoadStore::kKeepI, [&](auto keep_i) {
+	return dispatch(flags.jump_offset  == JumpOffset::kVX,   [&](auto jump_vx) {
+	return dispatch(flags.sprite_edge  == SpriteEdge::kWrap, [&](auto wrap) {
+	return dispatch(flags.logic_reset_vf,                    [&](auto reset_vf) {
+		return function(Quirks<decltype(shift_vx)::value ? ShiftSource::kVX  : ShiftSource::kVY,
+		                       decltype(keep_i  )::value ? LoadStore::kKeepI : LoadStore::kIncrementI,
+		                       decltype(jump_vx )::value ? JumpOffset::kVX   : JumpOffset::kV0,
+		                       decltype(wrap    )::value ? SpriteEdge::kWrap : SpriteEdge::kClip,
+		                       decltype(reset_vf)::value>());
+	});
+	});
+	});
+	});
+	});
+}
+
+}  // namespace chip8
+
+#endif // CHIP_QUIRKS_H
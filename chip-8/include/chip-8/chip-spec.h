@@ -4,17 +4,63 @@
 namespace chip8
 {
 
-constexpr auto kGeneralRegisterCount = 16u;
-constexpr auto kStackSize            = 16u;
-constexpr auto kDRamSize             = 4096u;
-constexpr auto kFontsetMemoryOffset  = 0x50;
-constexpr auto kProgramMemoryOffset  = 0x200;
-constexpr auto kScreenWidth          = 64u;
-constexpr auto kScreenHeight         = 32u;
-constexpr auto kVRamSize             = kScreenHeight * kScreenWidth;
-constexpr auto kKeyRegisterCount     = 16u;
+constexpr auto kGeneralRegisterCount    = 16u;
+constexpr auto kFontsetMemoryOffset     = 0x50;
+constexpr auto kBigFontsetMemoryOffset  = 0xA0;
+constexpr auto kProgramMemoryOffset     = 0x200;
+constexpr auto kKeyRegisterCount        = 16u;
+constexpr auto kFlagRegisterCount       = 16u;
+constexpr auto kAudioPatternSize        = 16u;
 
+// Each opcode set is a superset of the previous one.
+enum class OpcodeSet
+{
+	kChip8,
+	kSuperChip,
+	kXoChip
+};
+
+// The original COSMAC VIP machine. (64x32, 4 KB)
+struct Chip8Spec
+{
+	static constexpr auto kOpcodeSet    = OpcodeSet::kChip8;
+	static constexpr auto kDRamSize     = 4096u;
+	static constexpr auto kStackSize    = 16u;
+	static constexpr auto kScreenWidth  = 64u;
+	static constexpr auto kScreenHeight = 32u;
+	static constexpr auto kVRamSize     = kScreenHeight * kScreenWidth;
+	static constexpr auto kPlaneCount   = 1u;
+	static constexpr auto kHasHiRes     = false;
+};
+
+// SUPER-CHIP 1.1. (128x64 hi-res mode, 16x16 sprites, scroll ops)
+// The screen is always stored at the hi-res size; lo-res pixels cover 2x2 blocks.
+struct SuperChipSpec
+{
+	static constexpr auto kOpcodeSet    = OpcodeSet::kSuperChip;
+	static constexpr auto kDRamSize     = 4096u;
+	static constexpr auto kStackSize    = 16u;
+	static constexpr auto kScreenWidth  = 128u;
+	static constexpr auto kScreenHeight = 64u;
+	static constexpr auto kVRamSize     = kScreenHeight * kScreenWidth;
+	static constexpr auto kPlaneCount   = 1u;
+	static constexpr auto kHasHiRes     = true;
+};
+
+// XO-CHIP. (SUPER-CHIP plus 64 KB memory and two bit planes)
+// Each pixel of the screen holds one bit per plane.
+struct XoChipSpec
+{
+	static constexpr auto kOpcodeSet    = OpcodeSet::kXoChip;
+	static constexpr auto kDRamSize     = 65536u;
+	static constexpr auto kStackSize    = 16u;
+	static constexpr auto kScreenWidth  = 128u;
+	static constexpr auto kScreenHeight = 64u;
+	static constexpr auto kVRamSize     = kScreenHeight * kScreenWidth;
+	static constexpr auto kPlaneCount   = 2u;
+	static constexpr auto kHasHiRes     = true;
+};
 
 }  // namespace chip8
 
-#endif // CHIP_SPEC_H
\ No newline at end of file
+#endif // CHIP_SPEC_H
@@ -0,0 +1,95 @@
+#ifndef CHIP_TIMING_H
+#define CHIP_TIMING_H
+
+#include <cstdint>
+
+namespace chip8
+{
+
+// The timing policy Chip::run_frame runs a 60 Hz frame with.
+//
+// An untimed machine runs the number of instructions it's given a frame, and its delay
+// timer counts down an instruction, as Chip always did. A timed one has the members of
+// VipTiming: it runs the instructions that fit a cycle budget a frame, paying every one
+// what get_cycles says, and its timers count down once a frame.
+struct NoTiming
+{
+	static constexpr bool kTimed = false;
+};
+
+// The COSMAC VIP interpreter, in machine cycles of its CDP1802 (8 clocks of 1.7609 MHz, so
+// 4.54 us). A frame is 3668 of them, less the 1024 the display takes for its DMA (8 bytes
+// a line for 128 lines) and about 30 for the interrupt routine.
+//
+// The costs are approximations of the interpreter's routines, fetch and dispatch included,
+// good for the relative speed of the opcodes: 8xyn runs through self modifying code, 00E0
+// clears 256 bytes, Dxyn shifts every row by the column it draws at, Fx33 divides by
+// repeated subtraction and Fx55 and Fx65 copy a register at a time.
+//
+// On the VIP, Dxyn waits for the vertical blank before it draws. So a Dxyn ends the frame
+// it comes in, unless it's the first instruction of it, and draws first in the next one.
+struct VipTiming
+{
+	static constexpr bool    kTimed        = true;
+	static constexpr bool    kDisplayWait  = true;
+	static constexpr int32_t kFrameCycles  = 3668 - 1024 - 30;
+	static constexpr int32_t kFetchCycles  = 40;
+
+	template <typename Machine>
+	static constexpr int32_t get_cycles (const Machine& chip, uint16_t opcode) noexcept
+	{
+		const auto x = (opcode & 0x0F00) >> 8;
+		const auto n = (opcode & 0x000F);
+
+		switch (opcode & 0xF000)
+		{
+		case 0x0000:
+			return kFetchCycles + (0x00E0 == opcode ? 1024 : 10);
+		case 0x1000:
+			return kFetchCycles + 12;
+		case 0x2000:
+			return kFetchCycles + 26;
+		case 0x3000:
+		case 0x4000:
+			return kFetchCycles + 10;
+		case 0x5000:
+		case 0x9000:
+			return kFetchCycles + 14;
+		case 0x6000:
+			return kFetchCycles + 6;
+		case 0x7000:
+			return kFetchCycles + 10;
+		case 0x8000:
+			return kFetchCycles + 44;
+		case 0xA000:
+			return kFetchCycles + 12;
+		case 0xB000:
+			return kFetchCycles + 22;
+		case 0xC000:
+			return kFetchCycles + 36;
+		case 0xD000:
+			return kFetchCycles + 26 + static_cast<int32_t>(n * (34 + 4 * (chip.get_v(x) % 8)));
+		case 0xE000:
+			return kFetchCycles + 16;
+		default:
+			switch (opcode & 0x00FF)
+			{
+			case 0x001E:
+				return kFetchCycles + 18;
+			case 0x0029:
+				return kFetchCycles + 20;
+			case 0x0033:
+				return kFetchCycles + 204;
+			case 0x0055:
+			case 0x0065:
+				return kFetchCycles + 14 + 14 * (x + 1);
+			default:
+				return kFetchCycles + 10;
+			}
+		}
+	}
+};
+
+}  // namespace chip8
+
+#endif // CHIP_TIMING_H
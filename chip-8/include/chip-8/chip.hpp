@@ -0,0 +1,1275 @@
+#ifndef CHIP_H
+#define CHIP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+#include <array>
+#include <memory>
+#include <iterator>
+#include <random>
+
+#include "chip-spec.h"
+#include "chip-quirks.hpp"
+#include "chip-hooks.hpp"
+#include "chip-memory.hpp"
+#include "chip-timing.hpp"
+#include "roms.h"
+
+#if defined(_MSC_VER)
+#define CHIP8_FORCE_INLINE __forceinline
+#else
+#define CHIP8_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace chip8
+{
+
+using GeneralRegisters = std::array<uint8_t, kGeneralRegisterCount>;
+using FlagRegisters    = std::array<uint8_t, kFlagRegisterCount>;
+using AudioPattern     = std::array<uint8_t, kAudioPatternSize>;
+
+template <typename Spec>
+using Stack            = std::array<uint32_t, Spec::kStackSize>;
+
+template <typename Spec>
+using VRam             = std::array<uint8_t, Spec::kVRamSize>;
+
+// Why a machine stopped executing. A faulted machine stays at the faulting instruction.
+enum class Fault
+{
+	kNone,
+	kUnknownOpcode,
+	kStackOverflow,
+	kStackUnderflow
+};
+
+// The key register holds this while no key is pressed.
+constexpr auto kNoKey = uint8_t { 0xFF };
+
+template <typename Spec   = Chip8Spec,
+          typename Quirks = DefaultQuirks<Spec>,
+          typename Hooks  = NoHooks,
+          typename Memory = FlatMemory<Spec>,
+          typename Timing = NoTiming>
+class Chip
+{
+	static constexpr auto kSuperChipOpcodes = Spec::kOpcodeSet >= OpcodeSet::kSuperChip;
+	static constexpr auto kXoChipOpcodes    = Spec::kOpcodeSet >= OpcodeSet::kXoChip;
+	static constexpr auto kAddressMask      = Spec::kDRamSize - 1;
+
+	static_assert((Spec::kDRamSize & kAddressMask) == 0, "The memory size must be a power of two!!!");
+
+public:
+	using SpecType   = Spec;
+	using QuirksType = Quirks;
+	using HooksType  = Hooks;
+	using MemoryType = Memory;
+	using TimingType = Timing;
+	using Image      = typename Memory::Image;
+
+	// Writes the memory right after boot (fontset and program) to memory.
+	static constexpr void make_boot_memory (DRam<Spec>& memory, const uint8_t* program, size_t size)
+	{
+		for (auto& byte : memory)
+			byte = 0u;
+
+		load_fontset(memory);
+		load_program(memory, program, size);
+	}
+
+	// Builds the boot image, which every reset restores.
+	static constexpr Image make_image (const uint8_t* program, size_t size)
+	{
+		auto memory = DRam<Spec>();
+		make_boot_memory(memory, program, size);
+
+		return Memory::make_image(memory);
+	}
+
+	// Boots Pong from an image made once, at compile time where the memory policy allows.
+	Chip ()
+		:
+		Chip(get_pong_image())
+	{
+	}
+
+	Chip (const uint8_t* program, size_t size)
+		:
+		Chip(make_image(program, size))
+	{
+	}
+
+	explicit Chip (const Image& image)
+		:
+		Chip(image, std::random_device{}())
+	{
+	}
+
+	// A machine whose Cxnn is deterministic from the start, which constant evaluation needs.
+	constexpr Chip (const uint8_t* program, size_t size, uint32_t seed)
+		:
+		Chip(make_image(program, size), seed)
+	{
+	}
+
+	constexpr Chip (const Image& image, uint32_t seed)
+		:
+		V_          (                    ),
+		PC_         (kProgramMemoryOffset),
+		I_          (0u                  ),
+		STACK_      (                    ),
+		SP_         (0u                  ),
+		MEM_        (image               ),
+		GFX_        (                    ),
+		KEY_        (kNoKey              ),
+		DELAY_TIMER_(0u                  ),
+		SOUND_TIMER_(0u                  ),
+		PLANE_      (0x1                 ),
+		RPL_        (                    ),
+		PATTERN_    (                    ),
+		PITCH_      (64u                 ),
+		hires_      (false               ),
+		halted_     (false               ),
+		fault_      (Fault::kNone        ),
+		generation_ (0u                  ),
+		random_     (seed | 0x1          ),
+		cycles_     (0                   ),
+		hooks_      (                    )
+	{
+		wipe_up_resources();
+	}
+
+	// Boots a program and runs its first cycles, which may all happen at compile time:
+	//
+	//   constexpr auto kBooted = Chip<>::boot(kPong.data(), kPong.size(), 1u, 64u);
+	//
+	//   auto chip = kBooted;  // Starting a machine is a copy.
+	//
+	// Nothing presses a key in the cycles, so they should run up to the first key check.
+	static constexpr Chip boot (const uint8_t* program, size_t size, uint32_t seed, uint32_t cycles)
+	{
+		auto chip = Chip(program, size, seed);
+		for (auto i = 0u; i != cycles; ++i)
+			chip.instruction_cycle();
+
+		return chip;
+	}
+
+	// Restarts the machine with another program without constructing a new one.
+	// The hooks and the random number state are kept.
+	void reset (const uint8_t* program, size_t size)
+	{
+		reset(make_image(program, size));
+	}
+
+	// Restarts the machine from a boot image made by make_image.
+	void reset (const Image& image)
+	{
+		PC_           = kProgramMemoryOffset;
+		I_            = 0u;
+		SP_           = 0u;
+		KEY_          = kNoKey;
+		DELAY_TIMER_  = 0u;
+		SOUND_TIMER_  = 0u;
+		PLANE_        = 0x1;
+		PITCH_        = 64u;
+		hires_        = false;
+		halted_       = false;
+		fault_        = Fault::kNone;
+		cycles_       = 0;
+
+		STACK_.fill(0u);
+		RPL_.fill(0u);
+		PATTERN_.fill(0u);
+
+		MEM_.reset(image);
+		wipe_up_resources();
+	}
+
+	// Makes Cxnn deterministic from here on.
+	constexpr void seed (uint32_t value) noexcept
+	{
+		random_ = value | 0x1;
+	}
+
+	// Holds a key (0x0 to 0xF) down, or releases it with kNoKey. One key is held at a time.
+	constexpr void set_key (uint8_t key) noexcept
+	{
+		assert((key < 0x10 || key == kNoKey) && "The key is out of range!!!");
+		KEY_ = key;
+	}
+
+	constexpr void instruction_cycle ()
+	{
+		if (halted_)
+			return;
+
+		if (!hooks_.before_execute(*this))
+			return;
+
+		execute(fetch());
+
+		hooks_.after_execute(*this);
+	}
+
+	// Executes an already fetched opcode. With a constant opcode the decoding folds away,
+	// which is what the recompiled programs rely on.
+	CHIP8_FORCE_INLINE constexpr void execute (uint16_t opcode)
+	{
+		decode_and_execute(opcode);
+
+		if constexpr (!Timing::kTimed)
+		{
+			if (DELAY_TIMER_ > 0)
+				DELAY_TIMER_--;
+		}
+	}
+
+	// Runs a 60 Hz frame. Untimed, that's the given number of instruction cycles.
+	//
+	// Timed, it's the instructions that fit the frame's cycle budget, which ignores the
+	// number. The cycles the last instruction runs over are taken from the next frame, the
+	// ones left unused (halted, stopped by a hook or waiting for the vertical blank) are
+	// lost, as the real machine idles them away. The delay and sound timers count down
+	// once, at the end of the frame.
+	constexpr void run_frame (uint32_t instructions)
+	{
+		if constexpr (!Timing::kTimed)
+		{
+			for (auto i = 0u; i != instructions; ++i)
+				instruction_cycle();
+		}
+		else
+		{
+			cycles_ += Timing::kFrameCycles;
+			for (auto first = true; cycles_ > 0 && !halted_; first = false)
+			{
+				const auto opcode = fetch();
+				if (Timing::kDisplayWait && !first && 0xD000 == (opcode & 0xF000))
+					break;
+
+				if (!hooks_.before_execute(*this))
+					break;
+
+				cycles_ -= Timing::get_cycles(*this, opcode);
+				execute(opcode);
+
+				hooks_.after_execute(*this);
+			}
+
+			if (cycles_ > 0)
+				cycles_ = 0;
+
+			if (DELAY_TIMER_ > 0)
+				DELAY_TIMER_--;
+
+			if (SOUND_TIMER_ > 0)
+				SOUND_TIMER_--;
+		}
+	}
+
+	constexpr uint16_t fetch () const
+	{
+		return static_cast<uint16_t>(MEM_[(PC_ + 0) & kAddressMask] << 8 | MEM_[(PC_ + 1) & kAddressMask]);
+	}
+
+	constexpr auto get_pc() const noexcept
+	{
+		return PC_;
+	}
+
+	constexpr auto get_i() const noexcept
+	{
+		return I_;
+	}
+
+	constexpr auto get_v(uint32_t index) const noexcept
+	{
+		return V_[index];
+	}
+
+	constexpr const auto& get_registers() const noexcept
+	{
+		return V_;
+	}
+
+	constexpr const auto& get_memory() const noexcept
+	{
+		return MEM_;
+	}
+
+	constexpr auto get_sp() const noexcept
+	{
+		return SP_;
+	}
+
+	constexpr const auto& get_stack() const noexcept
+	{
+		return STACK_;
+	}
+
+	constexpr auto get_pixel(uint32_t index) const noexcept
+	{
+		return GFX_[index];
+	}
+
+	constexpr const auto& get_vram() const noexcept
+	{
+		return GFX_;
+	}
+
+	constexpr auto get_key() const noexcept
+	{
+		return KEY_;
+	}
+
+	constexpr auto get_delay_timer() const noexcept
+	{
+		return DELAY_TIMER_;
+	}
+
+	constexpr auto get_sound_timer() const noexcept
+	{
+		return SOUND_TIMER_;
+	}
+
+	constexpr auto is_hires() const noexcept
+	{
+		return hires_;
+	}
+
+	constexpr auto is_halted() const noexcept
+	{
+		return halted_;
+	}
+
+	constexpr auto get_fault() const noexcept
+	{
+		return fault_;
+	}
+
+	// The cycles the timed frames ran over, which the next one has less of. 0 untimed.
+	constexpr auto get_cycle_debt() const noexcept
+	{
+		return -cycles_;
+	}
+
+	// Changes whenever the screen may have, so a presenter can skip the frames that didn't.
+	// It isn't machine state, so it isn't hashed.
+	constexpr auto get_frame_generation() const noexcept
+	{
+		return generation_;
+	}
+
+	// A hash of everything that decides what the machine does next: the registers, the
+	// memory, the screen (packed to the bits of its planes), the random number state and,
+	// timed, the cycle debt.
+	// Equal machines hash equally whatever their memory policy; the hooks aren't hashed.
+	uint64_t get_state_hash () const noexcept
+	{
+		auto hash = uint64_t { 0x9E3779B97F4A7C15ull };
+
+		hash = hash_bytes(hash, V_.data(), V_.size());
+		hash = hash_word (hash, uint64_t { PC_ } << 32 | I_);
+		hash = hash_word (hash, uint64_t { SP_ } << 32 | random_);
+		hash = hash_word (hash, uint64_t { KEY_ } << 40 | uint64_t { DELAY_TIMER_ } << 32 |
+		                        uint64_t { SOUND_TIMER_ } << 24 | uint64_t { PLANE_ } << 16 |
+		                        uint64_t { PITCH_ } << 8 | uint64_t { hires_ } << 1 | halted_);
+
+		for (auto i = 0u; i != SP_; ++i)
+			hash = hash_word(hash, STACK_[i]);
+
+		if constexpr (kSuperChipOpcodes)
+			hash = hash_bytes(hash, RPL_.data(), RPL_.size());
+
+		if constexpr (kXoChipOpcodes)
+			hash = hash_bytes(hash, PATTERN_.data(), PATTERN_.size());
+
+		if constexpr (Timing::kTimed)
+			hash = hash_word(hash, static_cast<uint32_t>(cycles_));
+
+		hash = MEM_.hash(hash);
+
+		// A bit a pixel and plane. The multiply gathers the plane bit of 8 pixels into a byte.
+		static_assert(Spec::kVRamSize % 64 == 0, "The screen must pack into whole words!!!");
+
+		for (auto plane = 0u; plane != Spec::kPlaneCount; ++plane)
+		{
+			for (auto i = 0u; i != Spec::kVRamSize; i += 64)
+			{
+				auto word = uint64_t { 0 };
+				for (auto j = 0u; j != 8u; ++j)
+				{
+					auto pixels = uint64_t { 0 };
+					std::memcpy(&pixels, GFX_.data() + i + j * 8, sizeof(pixels));
+
+					const auto bits = ((pixels >> plane) & 0x0101010101010101ull) * 0x0102040810204080ull >> 56;
+					word |= bits << (j * 8);
+				}
+
+				hash = hash_word(hash, word);
+			}
+		}
+
+		return hash;
+	}
+
+	auto& hooks() noexcept
+	{
+		return hooks_;
+	}
+
+	const auto& hooks() const noexcept
+	{
+		return hooks_;
+	}
+
+private:
+	// Made once. With a memory policy that makes images in constant evaluation, it's made at
+	// compile time and the default machine boots with a copy.
+	static const Image& get_pong_image ()
+	{
+		static const auto image = make_image(kPong.data(), kPong.size());
+
+		return image;
+	}
+
+	constexpr void wipe_up_resources ()
+	{
+		for (auto& value : V_)
+			value = 0u;
+
+		for (auto& pixel : GFX_)
+			pixel = 0u;
+
+		++generation_;
+	}
+
+	static constexpr void load_fontset (DRam<Spec>& memory)
+	{
+		constexpr auto kFontset = std::array<uint8_t, 80>
+		{
+			0xF0, 0x90, 0x90, 0x90, 0xF0, //0
+			0x20, 0x60, 0x20, 0x20, 0x70, //1
+			0xF0, 0x10, 0xF0, 0x80, 0xF0, //2
+			0xF0, 0x10, 0xF0, 0x10, 0xF0, //3
+			0x90, 0x90, 0xF0, 0x10, 0x10, //4
+			0xF0, 0x80, 0xF0, 0x10, 0xF0, //5
+			0xF0, 0x80, 0xF0, 0x90, 0xF0, //6
+			0xF0, 0x10, 0x20, 0x40, 0x40, //7
+			0xF0, 0x90, 0xF0, 0x90, 0xF0, //8
+			0xF0, 0x90, 0xF0, 0x10, 0xF0, //9
+			0xF0, 0x90, 0xF0, 0x90, 0x90, //A
+			0xE0, 0x90, 0xE0, 0x90, 0xE0, //B
+			0xF0, 0x80, 0x80, 0x80, 0xF0, //C
+			0xE0, 0x90, 0x90, 0x90, 0xE0, //D
+			0xF0, 0x80, 0xF0, 0x80, 0xF0, //E
+			0xF0, 0x80, 0xF0, 0x80, 0x80  //F
+		};
+
+		for (auto i = 0u; i != kFontset.size(); ++i)
+			memory[kFontsetMemoryOffset + i] = kFontset[i];
+
+		if constexpr (kSuperChipOpcodes)
+		{
+			constexpr auto kBigFontset = std::array<uint8_t, 160>
+			{
+				0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, //0
+				0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, //1
+				0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, //2
+				0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, //3
+				0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, //4
+				0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, //5
+				0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, //6
+				0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, //7
+				0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, //8
+				0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, //9
+				0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, //A
+				0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, //B
+				0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, //C
+				0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, //D
+				0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, //E
+				0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  //F
+			};
+
+			for (auto i = 0u; i != kBigFontset.size(); ++i)
+				memory[kBigFontsetMemoryOffset + i] = kBigFontset[i];
+		}
+	}
+
+	// Every data access wraps around the memory, so no program can reach outside of MEM_.
+	constexpr uint8_t read (uint32_t address) const
+	{
+		return MEM_[address & kAddressMask];
+	}
+
+	constexpr void write (uint32_t address, uint8_t value)
+	{
+		MEM_.write(address & kAddressMask, value);
+	}
+
+	// Stops the machine at the current instruction.
+	constexpr void fault (Fault reason)
+	{
+		fault_  = reason;
+		halted_ = true;
+	}
+
+	// Xorshift32, which is much cheaper than std::random_device for every Cxnn.
+	constexpr uint8_t random ()
+	{
+		random_ ^= random_ << 13;
+		random_ ^= random_ >> 17;
+		random_ ^= random_ << 5;
+
+		return static_cast<uint8_t>(random_ >> 24);
+	}
+
+	static constexpr void load_program (DRam<Spec>& memory, const uint8_t* program, size_t size)
+	{
+		assert(size <= Spec::kDRamSize - kProgramMemoryOffset && "The program is too big!!!");
+
+		for (auto i = size_t { 0 }; i != size; ++i)
+			memory[kProgramMemoryOffset + i] = program[i];
+	}
+
+	constexpr void skip_if (bool condition)
+	{
+		PC_ += sizeof(uint16_t);
+
+		if (!condition)
+			return;
+
+		// XO-CHIP's F000 NNNN is the only four bytes long instruction.
+		if constexpr (kXoChipOpcodes)
+		{
+			if (fetch() == 0xF000)
+				PC_ += sizeof(uint16_t);
+		}
+
+		PC_ += sizeof(uint16_t);
+	}
+
+	constexpr uint8_t shift_source (uint32_t x, uint32_t y) const
+	{
+		if constexpr (Quirks::kShiftSource == ShiftSource::kVY)
+			return V_[y];
+		else
+			return V_[x];
+	}
+
+	// The COSMAC VIP clobbers VF in 8xy1, 8xy2 and 8xy3.
+	constexpr void reset_vf ()
+	{
+		if constexpr (Quirks::kLogicResetVF)
+			V_[0xF] = 0;
+	}
+
+	constexpr void clear_screen ()
+	{
+		++generation_;
+
+		for (auto& pixel : GFX_)
+			pixel &= ~PLANE_;
+	}
+
+	// Returns true if the pixel was set before in the given plane.
+	constexpr bool flip_pixel (uint32_t x, uint32_t y, uint8_t plane)
+	{
+		if constexpr (Spec::kHasHiRes)
+		{
+			if (!hires_)
+			{
+				// A lo-res pixel covers a 2x2 block of the hi-res screen.
+				const auto idx       = (y * 2) * Spec::kScreenWidth + (x * 2);
+				const auto collision = (GFX_[idx] & plane) != 0;
+
+				GFX_[idx                         + 0] ^= plane;
+				GFX_[idx                         + 1] ^= plane;
+				GFX_[idx + Spec::kScreenWidth + 0] ^= plane;
+				GFX_[idx + Spec::kScreenWidth + 1] ^= plane;
+
+				return collision;
+			}
+		}
+
+		const auto idx       = y * Spec::kScreenWidth + x;
+		const auto collision = (GFX_[idx] & plane) != 0;
+
+		GFX_[idx] ^= plane;
+
+		return collision;
+	}
+
+	constexpr void draw_sprite (uint32_t vx, uint32_t vy, uint32_t n)
+	{
+		const auto scale  = (Spec::kHasHiRes && !hires_) ? 2u : 1u;
+		const auto width  = Spec::kScreenWidth  / scale;
+		const auto height = Spec::kScreenHeight / scale;
+
+		// SUPER-CHIP draws a 16x16 sprite when N is zero.
+		const auto wide = kSuperChipOpcodes && 0 == n;
+		const auto cols = wide ? 16u : 8u;
+		const auto rows = wide ? 16u : n;
+
+		const auto x0 = vx % width;
+		const auto y0 = vy % height;
+
+		auto address = I_;
+
+		++generation_;
+
+		V_[0xF] = 0;
+		for (auto plane = 0u; plane != Spec::kPlaneCount; ++plane)
+		{
+			const auto mask = static_cast<uint8_t>(0x1 << plane);
+			if (0 == (PLANE_ & mask))
+				continue;
+
+			for (auto h = 0u; h != rows; ++h)
+			{
+				const auto bits = wide ? (read(address) << 8 | read(address + 1)) : (read(address) << 8);
+				address += wide ? 2 : 1;
+
+				auto y = y0 + h;
+				if (y >= height)
+				{
+					if constexpr (Quirks::kSpriteEdge == SpriteEdge::kClip)
+						continue;
+
+					y -= height;
+				}
+
+				for (auto w = 0u; w != cols; ++w)
+				{
+					auto x = x0 + w;
+					if (x >= width)
+					{
+						if constexpr (Quirks::kSpriteEdge == SpriteEdge::kClip)
+							break;
+
+						x -= width;
+					}
+
+					if (0 == (bits & (0x8000 >> w)))
+						continue;
+
+					if (flip_pixel(x, y, mask))
+						V_[0xF] = 1;
+				}
+			}
+		}
+
+		hooks_.on_read(I_, address - I_);
+	}
+
+	// Scrolls the selected planes by (dx, dy) hi-res pixels, filling the exposed area with zero.
+	constexpr void scroll (int32_t dx, int32_t dy)
+	{
+		const auto scale = hires_ ? 1 : 2;
+		dx *= scale;
+		dy *= scale;
+
+		const auto width  = static_cast<int32_t>(Spec::kScreenWidth );
+		const auto height = static_cast<int32_t>(Spec::kScreenHeight);
+
+		++generation_;
+
+		auto source = GFX_;
+		for (auto y = 0; y != height; ++y)
+		{
+			for (auto x = 0; x != width; ++x)
+			{
+				const auto sx = x - dx;
+				const auto sy = y - dy;
+
+				const auto inside = sx >= 0 && sx < width && sy >= 0 && sy < height;
+				const auto pixel  = inside ? source[sy * width + sx] : 0;
+
+				auto& target = GFX_[y * width + x];
+				target = (target & ~PLANE_) | (pixel & PLANE_);
+			}
+		}
+	}
+
+	CHIP8_FORCE_INLINE constexpr void decode_and_execute (uint16_t opcode)
+	{
+
+#define X   ((opcode & 0x0F00) >> 8)
+#define Y   ((opcode & 0x00F0) >> 4)
+#define N   ((opcode & 0x000F) >> 0)
+#define NN  ((opcode & 0x00FF) >> 0)
+#define NNN ((opcode & 0x0FFF) >> 0)
+
+		switch (opcode & 0xF000)
+		{
+		case 0x0000:
+			switch (opcode & 0x00FF)
+			{
+			case 0x00E0:
+				// Clears the screen.
+				clear_screen();
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x00EE:
+				// Returns from a subroutine.
+				if (0 == SP_)
+				{
+					fault(Fault::kStackUnderflow);
+					break;
+				}
+				PC_ = STACK_[--SP_];
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x00FB:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Scrolls the display right by 4 pixels.
+					scroll(4, 0);
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x00FC:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Scrolls the display left by 4 pixels.
+					scroll(-4, 0);
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x00FD:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Exits the interpreter.
+					halted_ = true;
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x00FE:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Switches to the lo-res (64x32) mode.
+					hires_ = false;
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x00FF:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Switches to the hi-res (128x64) mode.
+					hires_ = true;
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			default:
+				if constexpr (kSuperChipOpcodes)
+				{
+					if ((opcode & 0xFFF0) == 0x00C0)
+					{
+						// Scrolls the display down by N pixels.
+						scroll(0, N);
+						PC_ += sizeof(opcode);
+						break;
+					}
+				}
+
+				if constexpr (kXoChipOpcodes)
+				{
+					if ((opcode & 0xFFF0) == 0x00D0)
+					{
+						// Scrolls the display up by N pixels.
+						scroll(0, -static_cast<int32_t>(N));
+						PC_ += sizeof(opcode);
+						break;
+					}
+				}
+
+				fault(Fault::kUnknownOpcode);
+			}
+			break;
+
+		case 0x1000:
+			// Jumps to address NNN.
+			PC_ = NNN;
+			break;
+
+		case 0x2000:
+			// Calls subroutine at NNN.
+			if (SP_ == Spec::kStackSize)
+			{
+				fault(Fault::kStackOverflow);
+				break;
+			}
+			STACK_[SP_++] = PC_;
+			PC_ = NNN;
+			break;
+
+		case 0x3000:
+			// Skips the next instruction if VX equals NN.
+			// (Usually the next instruction is a jump to skip a code block)
+			skip_if(V_[X] == NN);
+			break;
+
+		case 0x4000:
+			// Skips the next instruction if VX doesn't equal NN.
+			// (Usually the next instruction is a jump to skip a code block)
+			skip_if(V_[X] != NN);
+			break;
+
+		case 0x5000:
+			switch (opcode & 0x000F)
+			{
+			case 0x0000:
+				// Skips the next instruction if VX equals VY.
+				// (Usually the next instruction is a jump to skip a code block)
+				skip_if(V_[X] == V_[Y]);
+				break;
+
+			case 0x0002:
+				if constexpr (kXoChipOpcodes)
+				{
+					// Stores VX to VY (including VY) in memory starting at address I.
+					// I doesn't change, and VX may be greater than VY.
+					const auto step = X <= Y ? 1 : -1;
+					auto       address = I_;
+					for (auto i = X; ; i += step)
+					{
+						write(address++, V_[i]);
+						if (i == Y)
+							break;
+					}
+					hooks_.on_write(I_, address - I_);
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0003:
+				if constexpr (kXoChipOpcodes)
+				{
+					// Fills VX to VY (including VY) with values from memory starting at address I.
+					// I doesn't change, and VX may be greater than VY.
+					const auto step = X <= Y ? 1 : -1;
+					auto       address = I_;
+					for (auto i = X; ; i += step)
+					{
+						V_[i] = read(address++);
+						if (i == Y)
+							break;
+					}
+					hooks_.on_read(I_, address - I_);
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			default:
+				fault(Fault::kUnknownOpcode);
+			}
+			break;
+
+		case 0x6000:
+			// Sets VX to NN.
+			V_[X] = NN;
+			PC_ += sizeof(opcode);
+			break;
+
+		case 0x7000:
+			// Adds NN to VX. (Carry flag is not changed)
+			V_[X] += NN;
+			PC_ += sizeof(opcode);
+			break;
+
+		case 0x8000:
+			switch (opcode & 0x00F)
+			{
+			case 0x000:
+				// Sets VX to the value of VY.
+				V_[X] = V_[Y];
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x001:
+				// Sets VX to VX or VY. (Bitwise OR operation)
+				V_[X] |= V_[Y];
+				reset_vf();
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x002:
+				// Sets VX to VX and VY. (Bitwise AND operation)
+				V_[X] &= V_[Y];
+				reset_vf();
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x003:
+				// Sets VX to VX xor VY.
+				V_[X] ^= V_[Y];
+				reset_vf();
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x004:
+			{
+				// Adds VY to VX.
+				// VF is set to 1 when there's a carry, and to 0 when there isn't.
+				// (VF is set after VX, so 8Fy4 leaves the carry in VF)
+				const auto carry = V_[X] > 0xFF - V_[Y] ? 1 : 0;
+				V_[X] += V_[Y];
+				V_[0xF] = carry;
+				PC_ += sizeof(opcode);
+				break;
+			}
+
+			case 0x005:
+			{
+				// VY is subtracted from VX.
+				// VF is set to 0 when there's a borrow, and 1 when there isn't.
+				const auto no_borrow = V_[X] >= V_[Y] ? 1 : 0;
+				V_[X] -= V_[Y];
+				V_[0xF] = no_borrow;
+				PC_ += sizeof(opcode);
+				break;
+			}
+
+			case 0x006:
+			{
+				// Shifts VY right by one and stores the result to VX(VY remains unchanged).
+				// VF is set to the value of the least significant bit of VY before the shift.
+				// (SUPER-CHIP shifts VX in place)
+				const auto source = shift_source(X, Y);
+				V_[X] = source >> 1;
+				V_[0xF] = source & 0x1;
+				PC_ += sizeof(opcode);
+				break;
+			}
+
+			case 0x007:
+			{
+				// Sets VX to VY minus VX.
+				// VF is set to 0 when there's a borrow, and 1 when there isn't.
+				const auto no_borrow = V_[Y] >= V_[X] ? 1 : 0;
+				V_[X] = V_[Y] - V_[X];
+				V_[0xF] = no_borrow;
+				PC_ += sizeof(opcode);
+				break;
+			}
+
+			case 0x00E:
+			{
+				// Shifts VY left by one and copies the result to VX.
+				// VF is set to the value of the most significant bit of VY before the shift.
+				// (SUPER-CHIP shifts VX in place)
+				const auto source = shift_source(X, Y);
+				V_[X] = source << 1;
+				V_[0xF] = source >> 7;
+				PC_ += sizeof(opcode);
+				break;
+			}
+
+			default:
+				fault(Fault::kUnknownOpcode);
+				break;
+			}
+			break;
+
+		case 0x9000:
+			// Skips the next instruction if VX doesn't equal VY.
+			// (Usually the next instruction is a jump to skip a code block)
+			skip_if(V_[X] != V_[Y]);
+			break;
+
+		case 0xA000:
+			// Sets I to the address NNN.
+			I_ = NNN;
+			PC_ += sizeof(opcode);
+			break;
+
+		case 0xB000:
+			// Jumps to the address NNN plus V0.
+			// (SUPER-CHIP reads it as BxNN and jumps to the address XNN plus VX)
+			if constexpr (Quirks::kJumpOffset == JumpOffset::kV0)
+				PC_ = NNN + V_[0x0];
+			else
+				PC_ = NNN + V_[X];
+			break;
+
+		case 0xC000:
+			// Sets VX to the result of a bitwise and operation on a random number (Typically: 0 to 255) and NN.
+			V_[X] = random() & NN;
+			PC_ += sizeof(opcode);
+			break;
+
+		case 0xD000:
+			// Draws a sprite at coordinate (VX, VY) that has a width of 8 pixels and a height of N pixels.
+			// Each row of 8 pixels is read as bit-coded starting from memory location I;
+			// I value doesn't change after the execution of this instruction.
+			// As described above, VF is set to 1 if any screen pixels are flipped from set to unset
+			// when the sprite is drawn, and to 0 if that doesn't happen
+			// (SUPER-CHIP draws a 16x16 sprite when N is zero, XO-CHIP draws on every selected plane)
+			draw_sprite(V_[X], V_[Y], N);
+			PC_ += sizeof(opcode);
+			break;
+
+		case 0xE000:
+			switch (opcode & 0x00FF)
+			{
+			case 0x009E:
+				// Skips the next instruction if the key stored in VX is pressed.
+				// (Usually the next instruction is a jump to skip a code block)
+				skip_if(KEY_ != kNoKey && KEY_ == V_[X]);
+				break;
+
+			case 0x00A1:
+				// Skips the next instruction if the key stored in VX isn't pressed.
+				// (Usually the next instruction is a jump to skip a code block)
+				skip_if(KEY_ == kNoKey || KEY_ != V_[X]);
+				break;
+
+			default:
+				fault(Fault::kUnknownOpcode);
+			}
+			break;
+
+		case 0xF000:
+			switch (opcode & 0x00FF)
+			{
+			case 0x0000:
+				if constexpr (kXoChipOpcodes)
+				{
+					// Sets I to the 16 bit address stored in the next two bytes.
+					I_ = read(PC_ + 2) << 8 | read(PC_ + 3);
+					PC_ += sizeof(opcode) * 2;
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0001:
+				if constexpr (kXoChipOpcodes)
+				{
+					// Selects the drawing planes by the bit mask X.
+					PLANE_ = X & ((0x1 << Spec::kPlaneCount) - 1);
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0002:
+				if constexpr (kXoChipOpcodes)
+				{
+					// Loads the 16 bytes audio pattern from memory starting at address I.
+					for (auto i = 0u; i != kAudioPatternSize; ++i)
+					{
+						PATTERN_[i] = read(I_ + i);
+					}
+					hooks_.on_read(I_, kAudioPatternSize);
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0007:
+				// Sets VX to the value of the delay timer.
+				V_[X] = DELAY_TIMER_;
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x000A:
+				// A key press is awaited, and then stored in VX.
+				// (Blocking Operation. The instruction repeats until a key is pressed)
+				if (KEY_ == kNoKey)
+					break;
+				V_[X] = KEY_;
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x0015:
+				// Sets the delay timer to VX.
+				DELAY_TIMER_ = V_[X];
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x0018:
+				// Sets the sound timer to VX.
+				SOUND_TIMER_ = V_[X];
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x001E:
+				// Adds VX to I.
+				I_ += V_[X];
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x0029:
+				// Sets I to the location of the sprite for the character in VX.
+				// Characters 0-F (in hexadecimal) are represented by a 4x5 font.
+				I_ = (V_[X] & 0xF) * 5 + kFontsetMemoryOffset;
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x0030:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Sets I to the location of the big sprite for the character in VX.
+					// Characters 0-F (in hexadecimal) are represented by a 8x10 font.
+					I_ = (V_[X] & 0xF) * 10 + kBigFontsetMemoryOffset;
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0033:
+				// Stores the binary - coded decimal representation of VX,
+				// with the most significant of three digits at the address in I,
+				// the middle digit at I plus 1, and the least significant digit at I plus 2.
+				// (In other words, take the decimal representation of VX,
+				// place the hundreds digit in memory at location in I,
+				// the tens digit at location I + 1, and the ones digit at location I + 2.)
+				write(I_ + 0, V_[X] / 100);
+				write(I_ + 1, V_[X] / 10 % 10);
+				write(I_ + 2, V_[X] % 100 % 10);
+				hooks_.on_write(I_, 3);
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x003A:
+				if constexpr (kXoChipOpcodes)
+				{
+					// Sets the audio pattern playback rate to VX.
+					PITCH_ = V_[X];
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0055:
+				// Stores V0 to VX (including VX) in memory starting at address I.
+				// I is increased by 1 for each value written.
+				// (SUPER-CHIP leaves I unchanged)
+				for (auto i = 0x0; i <= X; ++i)
+				{
+					write(I_ + i, V_[i]);
+				}
+				hooks_.on_write(I_, X + 1);
+				if constexpr (Quirks::kLoadStore == LoadStore::kIncrementI)
+					I_ += X + 1;
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x0065:
+				// Fills V0 to VX (including VX) with values from memory starting at address I.
+				// I is increased by 1 for each value written.
+				// (SUPER-CHIP leaves I unchanged)
+				for (auto i = 0x0; i <= X; ++i)
+				{
+					V_[i] = read(I_ + i);
+				}
+				hooks_.on_read(I_, X + 1);
+				if constexpr (Quirks::kLoadStore == LoadStore::kIncrementI)
+					I_ += X + 1;
+				PC_ += sizeof(opcode);
+				break;
+
+			case 0x0075:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Stores V0 to VX (including VX) in the RPL user flags.
+					for (auto i = 0x0; i <= X; ++i)
+					{
+						RPL_[i] = V_[i];
+					}
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			case 0x0085:
+				if constexpr (kSuperChipOpcodes)
+				{
+					// Fills V0 to VX (including VX) with values from the RPL user flags.
+					for (auto i = 0x0; i <= X; ++i)
+					{
+						V_[i] = RPL_[i];
+					}
+					PC_ += sizeof(opcode);
+					break;
+				}
+				fault(Fault::kUnknownOpcode);
+				break;
+
+			default:
+				fault(Fault::kUnknownOpcode);
+			}
+			break;
+
+		default:
+			fault(Fault::kUnknownOpcode);
+		}
+
+#undef NNN
+#undef NN
+#undef N
+#undef Y
+#undef X
+
+	}
+
+private:
+	GeneralRegisters V_;
+	uint32_t         PC_;
+	uint32_t         I_;
+	Stack<Spec>      STACK_;
+	uint32_t         SP_;
+	Memory           MEM_;
+	VRam<Spec>       GFX_;
+	uint8_t          KEY_;
+	uint8_t          DELAY_TIMER_;
+	uint8_t          SOUND_TIMER_;
+	uint8_t          PLANE_;
+	FlagRegisters    RPL_;
+	AudioPattern     PATTERN_;
+	uint8_t          PITCH_;
+	bool             hires_;
+	bool             halted_;
+	Fault            fault_;
+	uint32_t         generation_;
+	uint32_t         random_;
+	int32_t          cycles_;  // Of the timed frame, below 0 for those run over.
+	Hooks            hooks_;
+};
+
+extern template class Chip<Chip8Spec>;
+extern template class Chip<SuperChipSpec>;
+extern template class Chip<XoChipSpec>;
+
+}  // namespace chip8
+
+#endif  // CHIP_H
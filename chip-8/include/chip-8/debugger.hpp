@@ -0,0 +1,352 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <cstdint>
+#include <array>
+#include <map>
+#include <vector>
+#include <optional>
+
+#include "chip-spec.h"
+
+namespace chip8
+{
+
+// A hook policy for Chip with breakpoints, watchpoints and stepping.
+//
+//   auto chip = Chip<Chip8Spec, VipQuirks, Debugger<Chip8Spec>>();
+//   chip.hooks().set_breakpoint(0x22A);
+//
+// While running, before_execute costs one bit test of the breakpoint bitmap. Everything
+// else (conditions, stepping, pending stops) takes the slow path, which is only entered
+// when the bit of PC is set or every bit is forced on by force_.
+template <typename Spec>
+class Debugger
+{
+	static constexpr auto kWordBits  = 64u;
+	static constexpr auto kWordCount = Spec::kDRamSize / kWordBits;
+	static constexpr auto kNoAddress = ~0u;
+
+	using Bitmap = std::array<uint64_t, kWordCount>;
+
+public:
+	enum class StopReason
+	{
+		kNone,
+		kBreakpoint,
+		kWatchpoint,
+		kStep,
+		kPause
+	};
+
+	enum class Access
+	{
+		kRead      = 0x1,
+		kWrite     = 0x2,
+		kReadWrite = 0x3
+	};
+
+	enum class Comparison
+	{
+		kEqual,
+		kNotEqual,
+		kLess,
+		kGreater
+	};
+
+	// Stops at a breakpoint only if V[index] compares to value.
+	struct Condition
+	{
+		uint32_t   index;
+		Comparison comparison;
+		uint8_t    value;
+	};
+
+	Debugger ()
+		:
+		bitmap_     (                 ),
+		force_      (0u               ),
+		breakpoints_(                 ),
+		watchpoints_(                 ),
+		temporary_  (                 ),
+		stop_reason_(StopReason::kNone),
+		pending_    (StopReason::kNone),
+		allow_      (false            ),
+		stepping_   (false            ),
+		hit_address_(kNoAddress       )
+	{
+		bitmap_.fill(0u);
+	}
+
+	void set_breakpoint (uint32_t pc)
+	{
+		breakpoints_[pc] = std::nullopt;
+		update_bit(pc);
+	}
+
+	void set_breakpoint (uint32_t pc, const Condition& condition)
+	{
+		breakpoints_[pc] = condition;
+		update_bit(pc);
+	}
+
+	void clear_breakpoint (uint32_t pc)
+	{
+		breakpoints_.erase(pc);
+		update_bit(pc);
+	}
+
+	// Stops after an access to MEM_ overlapping [begin, end).
+	void set_watchpoint (uint32_t begin, uint32_t end, Access access)
+	{
+		watchpoints_.push_back(Watchpoint { begin, end, access });
+	}
+
+	void clear_watchpoints ()
+	{
+		watchpoints_.clear();
+	}
+
+	// Stops before the next instruction.
+	void pause ()
+	{
+		pending_ = StopReason::kPause;
+		force_   = ~0ull;
+	}
+
+	// Continues from a stop.
+	void resume ()
+	{
+		continue_from_stop(false);
+	}
+
+	// Executes one instruction and stops again.
+	void step ()
+	{
+		continue_from_stop(true);
+	}
+
+	// Steps over a call, stopping when it returns to the current frame.
+	template <typename Machine>
+	void step_over (const Machine& chip)
+	{
+		if ((chip.fetch() & 0xF000) != 0x2000)
+		{
+			step();
+			return;
+		}
+
+		set_temporary(chip.get_pc() + sizeof(uint16_t), chip.get_sp());
+		resume();
+	}
+
+	// Runs until the current subroutine returns to its caller.
+	template <typename Machine>
+	void step_out (const Machine& chip)
+	{
+		const auto sp = chip.get_sp();
+		if (0 == sp)
+		{
+			step();
+			return;
+		}
+
+		set_temporary(chip.get_stack()[sp - 1] + sizeof(uint16_t), sp - 1);
+		resume();
+	}
+
+	auto get_stop_reason () const noexcept
+	{
+		return stop_reason_;
+	}
+
+	auto is_stopped () const noexcept
+	{
+		return stop_reason_ != StopReason::kNone;
+	}
+
+	// The address of the access that hit the last watchpoint.
+	auto get_hit_address () const noexcept
+	{
+		return hit_address_;
+	}
+
+	template <typename Machine>
+	bool before_execute (const Machine& chip)
+	{
+		const auto pc   = chip.get_pc();
+		const auto word = bitmap_[(pc / kWordBits) % kWordCount] | force_;
+
+		if (0 == (word >> (pc % kWordBits) & 0x1))
+			return true;
+
+		return check(chip);
+	}
+
+	template <typename Machine>
+	void after_execute (const Machine&)
+	{
+	}
+
+	void on_read (uint32_t address, uint32_t size)
+	{
+		watch(address, size, Access::kRead);
+	}
+
+	void on_write (uint32_t address, uint32_t size)
+	{
+		watch(address, size, Access::kWrite);
+	}
+
+private:
+	struct Watchpoint
+	{
+		uint32_t begin;
+		uint32_t end;
+		Access   access;
+	};
+
+	struct Temporary
+	{
+		uint32_t pc;
+		uint32_t sp;
+	};
+
+	template <typename Machine>
+	bool check (const Machine& chip)
+	{
+		// The instruction the machine was stopped at runs once after resume or step.
+		if (allow_)
+		{
+			allow_ = false;
+			force_ = stepping_ ? ~0ull : 0u;
+			return true;
+		}
+
+		if (is_stopped())
+			return false;
+
+		if (pending_ != StopReason::kNone)
+		{
+			stop(pending_);
+			pending_ = StopReason::kNone;
+			return false;
+		}
+
+		if (stepping_)
+		{
+			stepping_ = false;
+			stop(StopReason::kStep);
+			return false;
+		}
+
+		const auto pc = chip.get_pc();
+
+		if (temporary_ && temporary_->pc == pc && temporary_->sp == chip.get_sp())
+		{
+			temporary_ = std::nullopt;
+			update_bit(pc);
+			stop(StopReason::kStep);
+			return false;
+		}
+
+		const auto breakpoint = breakpoints_.find(pc);
+		if (breakpoint != std::end(breakpoints_) && satisfies(chip, breakpoint->second))
+		{
+			stop(StopReason::kBreakpoint);
+			return false;
+		}
+
+		return true;
+	}
+
+	template <typename Machine>
+	static bool satisfies (const Machine& chip, const std::optional<Condition>& condition)
+	{
+		if (!condition)
+			return true;
+
+		const auto value = chip.get_v(condition->index);
+
+		switch (condition->comparison)
+		{
+		case Comparison::kEqual:
+			return value == condition->value;
+
+		case Comparison::kNotEqual:
+			return value != condition->value;
+
+		case Comparison::kLess:
+			return value < condition->value;
+
+		default:
+			return value > condition->value;
+		}
+	}
+
+	void watch (uint32_t address, uint32_t size, Access access)
+	{
+		for (const auto& watchpoint : watchpoints_)
+		{
+			if (0 == (static_cast<uint32_t>(watchpoint.access) & static_cast<uint32_t>(access)))
+				continue;
+
+			if (address < watchpoint.end && address + size > watchpoint.begin)
+			{
+				hit_address_ = address;
+				pending_     = StopReason::kWatchpoint;
+				force_       = ~0ull;
+				return;
+			}
+		}
+	}
+
+	void stop (StopReason reason)
+	{
+		stop_reason_ = reason;
+		force_       = ~0ull;
+	}
+
+	void continue_from_stop (bool stepping)
+	{
+		stop_reason_ = StopReason::kNone;
+		allow_       = true;
+		stepping_    = stepping;
+		force_       = ~0ull;
+	}
+
+	void set_temporary (uint32_t pc, uint32_t sp)
+	{
+		const auto previous = temporary_;
+
+		temporary_ = Temporary { pc, sp };
+		if (previous)
+			update_bit(previous->pc);
+		update_bit(pc);
+	}
+
+	void update_bit (uint32_t pc)
+	{
+		const auto set  = breakpoints_.count(pc) != 0 || (temporary_ && temporary_->pc == pc);
+		const auto mask = 0x1ull << (pc % kWordBits);
+		auto&      word = bitmap_[(pc / kWordBits) % kWordCount];
+
+		word = set ? (word | mask) : (word & ~mask);
+	}
+
+private:
+	Bitmap                                        bitmap_;
+	uint64_t                                      force_;
+	std::map<uint32_t, std::optional<Condition>>  breakpoints_;
+	std::vector<Watchpoint>                       watchpoints_;
+	std::optional<Temporary>                      temporary_;
+	StopReason                                    stop_reason_;
+	StopReason                                    pending_;
+	bool                                          allow_;
+	bool                                          stepping_;
+	uint32_t                                      hit_address_;
+};
+
+}  // namespace chip8
+
+#endif // DEBUGGER_H
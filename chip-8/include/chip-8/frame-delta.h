@@ -0,0 +1,57 @@
+#ifndef FRAME_DELTA_H
+#define FRAME_DELTA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "chip-spec.h"
+
+namespace chip8
+{
+
+// A screen packed to a bit a pixel, the most significant bit first, in rows of a plane
+// after the rows of the plane before.
+template <typename Spec>
+struct PackedFrame
+{
+	static constexpr auto kRowSize  = Spec::kScreenWidth / 8;
+	static constexpr auto kRowCount = Spec::kScreenHeight * Spec::kPlaneCount;
+	static constexpr auto kSize     = kRowSize * kRowCount;
+
+	static_assert(Spec::kScreenWidth % 8 == 0, "A row must pack into whole bytes!!!");
+
+	// Packs the pixels of VRam, which hold a bit a plane.
+	static void pack (const uint8_t* vram, uint8_t* packed) noexcept
+	{
+		for (auto plane = 0u; plane != Spec::kPlaneCount; ++plane)
+		{
+			for (auto i = 0u; i != Spec::kVRamSize; i += 8)
+			{
+				auto pixels = uint64_t { 0 };
+				std::memcpy(&pixels, vram + i, sizeof(pixels));
+
+				// Gathers the plane bit of the 8 pixels, the first one into the top bit.
+				const auto bits = ((pixels >> plane) & 0x0101010101010101ull) * 0x8040201008040201ull >> 56;
+
+				*packed++ = static_cast<uint8_t>(bits);
+			}
+		}
+	}
+};
+
+// Appends the rows of current that differ from previous, which is what most frames are.
+//
+// A changed row is its index (16 bits, little endian) and the XOR of the two rows, run
+// length encoded as (zeros to skip, bytes that follow, the bytes) pairs of counts up to
+// 255, ended by a (0, 0) pair. Returns the number of changed rows, 0 for equal frames.
+uint32_t encode_delta (const uint8_t* previous, const uint8_t* current, uint32_t row_size, uint32_t row_count, std::vector<uint8_t>& out);
+
+// XORs a delta made by encode_delta into frame. Returns false for a malformed delta, which
+// may have changed frame.
+bool apply_delta (const uint8_t* delta, size_t size, uint8_t* frame, uint32_t row_size, uint32_t row_count);
+
+}  // namespace chip8
+
+#endif // FRAME_DELTA_H
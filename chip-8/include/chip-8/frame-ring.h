@@ -0,0 +1,215 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <util/noncopyable.h>
+
+#include "frame-delta.h"
+
+namespace chip8
+{
+
+// The frames a session publishes for other processes, in a ring of slots in shared memory.
+//
+// The segment starts with a FrameRingHeader. slot_count slots follow it, at slot_size
+// apart. Each slot is a FrameSlot followed by a packed frame (see PackedFrame) of
+// frame_size bytes.
+//
+// A slot is a seqlock. The writer makes its sequence odd, writes the slot, and makes the
+// sequence even again. A reader copies the slot out, and keeps the copy only if the
+// sequence was the same even number before and after. So the writer never waits for a
+// reader, and a reader that raced the writer just reads again.
+constexpr auto kFrameRingVersion = 1u;
+
+struct FrameRingHeader
+{
+	char                  magic[8];
+	uint32_t              version;
+	uint32_t              slot_count;
+	uint32_t              slot_size;
+	uint32_t              frame_size;
+	uint16_t              screen_width;
+	uint16_t              screen_height;
+	uint32_t              plane_count;
+	// The number of frames published. The last one is in slot (published - 1) % slot_count.
+	std::atomic<uint64_t> published;
+};
+
+struct FrameSlot
+{
+	std::atomic<uint32_t> sequence;
+	uint8_t               key;
+	uint8_t               sound_timer;
+	uint16_t              reserved;
+	// The number of the frame in the slot, counted from 0.
+	uint64_t              number;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+              std::atomic<uint64_t>::is_always_lock_free, "The ring is shared between processes!!!");
+static_assert(std::is_standard_layout_v<FrameRingHeader> &&
+              std::is_standard_layout_v<FrameSlot>, "The ring is a memory layout!!!");
+
+// Publishes frames into a new ring.
+//
+//   auto writer = FrameRingWriter();
+//   writer.open("/chip8-frames", 64u, 32u, 1u);
+//
+//   // Every frame.
+//   writer.record(chip);
+//
+// The name is a POSIX shared memory name (a file mapping name on Windows). The frame is
+// packed straight into its slot, so publishing it costs the packing and two stores.
+class FrameRingWriter : private utl::Noncopyable
+{
+public:
+	FrameRingWriter ();
+
+	~FrameRingWriter ();
+
+	// Creates the ring, replacing one a writer left behind. Returns false if it can't.
+	bool open (const std::string& name, uint32_t screen_width, uint32_t screen_height, uint32_t plane_count,
+	           uint32_t slot_count = 8);
+
+	// Removes the name of the ring. Readers that mapped it keep the frames they see.
+	void close ();
+
+	bool is_open () const noexcept
+	{
+		return nullptr != header_;
+	}
+
+	// The key held from the next frame on, kNoKey for none.
+	void set_key (uint8_t key);
+
+	// The sound timer from the next frame on.
+	void set_sound_timer (uint8_t value);
+
+	// Publishes a packed frame of the size the ring was opened with.
+	void publish_frame (const uint8_t* frame);
+
+	// Publishes the screen, the key and the sound timer of a machine of the ring's size.
+	template <typename Machine>
+	void record (const Machine& chip)
+	{
+		using Packed = PackedFrame<typename Machine::SpecType>;
+
+		assert(Packed::kSize == header_->frame_size && "The machine's screen isn't the ring's!!!");
+
+		set_key(chip.get_key());
+		set_sound_timer(chip.get_sound_timer());
+
+		Packed::pack(chip.get_vram().data(), begin_frame());
+		end_frame();
+	}
+
+	uint64_t get_frame_count () const noexcept
+	{
+		return frame_count_;
+	}
+
+private:
+	// Locks the next slot and returns where its frame goes.
+	uint8_t* begin_frame ();
+
+	// Unlocks the slot and publishes its frame.
+	void end_frame ();
+
+private:
+	std::string      name_;
+	FrameRingHeader* header_;
+	uint64_t         size_;
+	void*            mapping_;  // The file mapping handle on Windows.
+	FrameSlot*       slot_;
+	uint8_t          key_;
+	uint8_t          sound_timer_;
+	uint64_t         frame_count_;
+};
+
+// Reads the last frame published into a ring, without ever holding the writer up.
+class FrameRingReader : private utl::Noncopyable
+{
+public:
+	FrameRingReader ();
+
+	~FrameRingReader ();
+
+	// Maps the ring read only. Returns false if there's no ring of a known version.
+	bool open (const std::string& name);
+
+	void close ();
+
+	bool is_open () const noexcept
+	{
+		return nullptr != header_;
+	}
+
+	// Copies the last frame published into frame, frame_size bytes. Returns false if no frame
+	// was published yet, or if the writer kept overwriting the slot being read.
+	bool read_latest (uint8_t* frame);
+
+	// The number of frames the writer published so far.
+	uint64_t get_published_count () const noexcept
+	{
+		return header_->published.load(std::memory_order_acquire);
+	}
+
+	// The number, the key and the sound timer of the frame read last.
+	uint64_t get_frame_number () const noexcept
+	{
+		return number_;
+	}
+
+	uint8_t get_key () const noexcept
+	{
+		return key_;
+	}
+
+	uint8_t get_sound_timer () const noexcept
+	{
+		return sound_timer_;
+	}
+
+	// The reads that raced the writer and were done again.
+	uint64_t get_retry_count () const noexcept
+	{
+		return retry_count_;
+	}
+
+	uint32_t get_screen_width () const noexcept
+	{
+		return header_->screen_width;
+	}
+
+	uint32_t get_screen_height () const noexcept
+	{
+		return header_->screen_height;
+	}
+
+	uint32_t get_plane_count () const noexcept
+	{
+		return header_->plane_count;
+	}
+
+	uint32_t get_frame_size () const noexcept
+	{
+		return header_->frame_size;
+	}
+
+private:
+	const FrameRingHeader* header_;
+	uint64_t               size_;
+	void*                  mapping_;  // The file mapping handle on Windows.
+	uint64_t               number_;
+	uint8_t                key_;
+	uint8_t                sound_timer_;
+	uint64_t               retry_count_;
+};
+
+}  // namespace chip8
+
+#endif // FRAME_RING_H
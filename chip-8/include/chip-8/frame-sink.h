@@ -0,0 +1,93 @@
+#ifndef FRAME_SINK_H
+#define FRAME_SINK_H
+
+#include <cstdint>
+#include <cassert>
+#include <array>
+#include <vector>
+
+namespace chip8
+{
+
+// How a sink stores a pixel.
+enum class PixelFormat
+{
+	// A bit, set if any plane is, the leftmost pixel in the top bit.
+	kMono1,
+	// The pixel value, a bit a plane.
+	kIndex8,
+	// The palette color, red first.
+	kRgb24,
+	// The palette color, blue first, and an opaque alpha.
+	kBgra32
+};
+
+// Writes screens straight into a buffer of the caller, in the caller's pixel format.
+//
+//   auto screen = std::vector<uint8_t>(64 * 32 * 4);
+//   auto sink   = FrameSink(64u, 32u, PixelFormat::kBgra32, screen.data());
+//
+//   // Every frame.
+//   sink.write(chip);
+//
+// The sink keeps the pixels it wrote last and writes only the rows that differ, which are
+// the ones 00E0, Dxyn and the scrolls changed. It compares instead of being told by the
+// machine, because machines are copied (run ahead, pooled, searched) and a copy would write
+// into the buffer too; so it may follow any machine. The buffer has to keep what was
+// written into it.
+class FrameSink
+{
+public:
+	// The colors of the pixel values as 0xRRGGBB.
+	using Palette = std::array<uint32_t, 4>;
+
+	// A stride of 0 is the size of a row in the format.
+	FrameSink (uint32_t screen_width, uint32_t screen_height, PixelFormat format, void* data, uint32_t stride = 0);
+
+	// Writes every row on the next write, e.g. after the buffer was drawn over.
+	void invalidate ();
+
+	// Takes effect on the rows written after, so it's usually followed by invalidate.
+	void set_palette (const Palette& palette);
+
+	// Writes the rows of a screen, a byte a pixel, that changed since the last write.
+	// Returns the number of rows written.
+	uint32_t write_pixels (const uint8_t* pixels);
+
+	// Writes the screen of a machine of the sink's size.
+	template <typename Machine>
+	uint32_t write (const Machine& chip)
+	{
+		assert(Machine::SpecType::kScreenWidth == width_ && Machine::SpecType::kScreenHeight == height_ &&
+		       "The machine's screen isn't the sink's!!!");
+
+		return write_pixels(chip.get_vram().data());
+	}
+
+	PixelFormat get_format () const noexcept
+	{
+		return format_;
+	}
+
+	uint32_t get_stride () const noexcept
+	{
+		return stride_;
+	}
+
+private:
+	void write_row (const uint8_t* pixels, uint8_t* target) const;
+
+private:
+	uint32_t             width_;
+	uint32_t             height_;
+	PixelFormat          format_;
+	uint8_t*             data_;
+	uint32_t             stride_;
+	Palette              palette_;
+	std::vector<uint8_t> shown_;
+	bool                 valid_;
+};
+
+}  // namespace chip8
+
+#endif // FRAME_SINK_H
@@ -0,0 +1,48 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <util/noncopyable.h>
+
+namespace chip8
+{
+
+// A file mapped read only into memory, for the readers of the recorded files.
+class MappedFile : private utl::Noncopyable
+{
+public:
+	MappedFile ();
+
+	~MappedFile ();
+
+	// Maps the whole file, unmapping the one mapped before. An empty file doesn't map.
+	bool open (const std::string& path);
+
+	void close ();
+
+	bool is_open () const noexcept
+	{
+		return nullptr != data_;
+	}
+
+	const uint8_t* get_data () const noexcept
+	{
+		return data_;
+	}
+
+	uint64_t get_size () const noexcept
+	{
+		return size_;
+	}
+
+private:
+	const uint8_t* data_;
+	uint64_t       size_;
+	void*          file_;    // The file and mapping handles on Windows.
+	void*          mapping_;
+};
+
+}  // namespace chip8
+
+#endif // MAPPED_FILE_H
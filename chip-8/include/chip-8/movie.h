@@ -0,0 +1,200 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <cstdint>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <util/noncopyable.h>
+
+#include "chip.hpp"
+#include "frame-delta.h"
+#include "mapped-file.h"
+
+namespace chip8
+{
+
+// Writes the presented frames of a session, with the key held and the sound timer, into a
+// movie file as they come.
+//
+//   auto writer = MovieWriter("pong.c8m", 64u, 32u, 1u);
+//
+//   // Every frame.
+//   writer.record(chip);
+//
+// A frame is the screen packed to a bit a pixel (see PackedFrame), stored as the XOR
+// against the frame before or the one before that, whichever is smaller, run length
+// encoded; a frame equal to the one before costs a count. The frames are written in
+// chunks of keyframe_interval frames, the first one of a chunk against a blank screen,
+// so a chunk decodes on its own. The changes of the key and the sound timer are
+// interleaved with the frames they precede. An index of the chunks follows them when the
+// writer closes.
+class MovieWriter : private utl::Noncopyable
+{
+public:
+	MovieWriter (const std::string& path, uint32_t screen_width, uint32_t screen_height, uint32_t plane_count,
+	             uint32_t keyframe_interval = 600);
+
+	~MovieWriter ();
+
+	bool is_open () const noexcept
+	{
+		return is_open_;
+	}
+
+	// The key held from the next frame on, kNoKey for none.
+	void set_key (uint8_t key);
+
+	// The sound timer from the next frame on.
+	void set_sound_timer (uint8_t value);
+
+	// Appends a packed frame of the size the writer was opened with.
+	void append_frame (const uint8_t* frame);
+
+	// Appends the screen, the key and the sound timer of a machine of the writer's size.
+	template <typename Machine>
+	void record (const Machine& chip)
+	{
+		using Packed = PackedFrame<typename Machine::SpecType>;
+
+		assert(Packed::kSize == current_.size() && "The machine's screen isn't the movie's!!!");
+
+		set_key(chip.get_key());
+		set_sound_timer(chip.get_sound_timer());
+
+		Packed::pack(chip.get_vram().data(), current_.data());
+		append_frame(current_.data());
+	}
+
+	// Writes the last chunk and the index. The destructor closes an open writer.
+	void close ();
+
+	uint64_t get_frame_count () const noexcept
+	{
+		return frame_count_;
+	}
+
+private:
+	void flush_repeats ();
+
+	void write_chunk ();
+
+private:
+	std::ofstream         file_;
+	bool                  is_open_;
+	uint32_t              keyframe_interval_;
+	std::vector<uint8_t>  previous_;
+	std::vector<uint8_t>  older_;
+	std::vector<uint8_t>  current_;
+	std::vector<uint8_t>  delta_;
+	std::vector<uint8_t>  older_delta_;
+	std::vector<uint8_t>  payload_;
+	uint32_t              chunk_frame_count_;
+	uint32_t              repeat_count_;
+	uint8_t               key_;
+	uint8_t               sound_timer_;
+	uint8_t               chunk_key_;
+	uint8_t               chunk_sound_timer_;
+	uint64_t              frame_count_;
+	std::vector<uint64_t> offsets_;
+};
+
+// Random access to the frames of a movie file through a memory mapping.
+//
+// Seeking finds the chunk of a frame directly and decodes from its first frame, so it
+// decodes at most keyframe_interval frames; seeking to the next frame decodes one.
+class MovieReader : private utl::Noncopyable
+{
+public:
+	explicit MovieReader (const std::string& path);
+
+	bool is_open () const noexcept
+	{
+		return file_.is_open();
+	}
+
+	uint64_t get_frame_count () const noexcept
+	{
+		return frame_count_;
+	}
+
+	uint32_t get_screen_width () const noexcept
+	{
+		return screen_width_;
+	}
+
+	uint32_t get_screen_height () const noexcept
+	{
+		return screen_height_;
+	}
+
+	uint32_t get_plane_count () const noexcept
+	{
+		return plane_count_;
+	}
+
+	// Decodes the index-th frame. Returns false for a malformed movie.
+	bool seek (uint64_t index);
+
+	// The frame seeked to, packed as the writer got it.
+	const std::vector<uint8_t>& get_frame () const noexcept
+	{
+		return frame_;
+	}
+
+	uint8_t get_key () const noexcept
+	{
+		return key_;
+	}
+
+	uint8_t get_sound_timer () const noexcept
+	{
+		return sound_timer_;
+	}
+
+private:
+	struct Chunk
+	{
+		uint64_t offset;
+		uint64_t first;
+		uint32_t count;
+		uint32_t payload_size;
+		uint8_t  key;
+		uint8_t  sound_timer;
+	};
+
+	bool read_index ();
+
+	bool scan_chunks ();
+
+	// Adds the chunk at offset if it's whole before end and follows the chunks before it.
+	bool add_chunk (uint64_t offset, uint64_t end);
+
+	// Starts decoding a chunk from its first frame.
+	void rewind (size_t chunk);
+
+	// Decodes the frame after the current one of the chunk.
+	bool step ();
+
+private:
+	MappedFile           file_;
+	uint32_t             screen_width_;
+	uint32_t             screen_height_;
+	uint32_t             plane_count_;
+	uint32_t             keyframe_interval_;
+	uint64_t             frame_count_;
+	std::vector<Chunk>   chunks_;
+	std::vector<uint8_t> frame_;
+	std::vector<uint8_t> older_;
+	uint8_t              key_;
+	uint8_t              sound_timer_;
+	size_t               chunk_;
+	uint64_t             offset_;
+	uint64_t             next_;
+	uint32_t             repeat_count_;
+};
+
+}  // namespace chip8
+
+#endif // MOVIE_H
@@ -0,0 +1,197 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <string>
+#include <util/noncopyable.h>
+
+namespace chip8
+{
+
+constexpr auto kOpcodeClassCount = 16u;
+
+// Opcodes are classed by their first nibble, which is what decode_and_execute switches on.
+constexpr uint32_t get_opcode_class (uint16_t opcode) noexcept
+{
+	return opcode >> 12;
+}
+
+// Hardware counters of the calling thread through perf_event (Linux only).
+//
+// Opening fails without permission (see /proc/sys/kernel/perf_event_paranoid), in a VM
+// without a PMU, or on other systems. Then is_available() is false, get_error() says why
+// and read() returns zeros, so the caller keeps working without the numbers. A counter the
+// CPU doesn't support is left out on its own, is_available(counter) tells which are counted.
+class PerfCounters : private utl::Noncopyable
+{
+public:
+	enum Counter
+	{
+		kCycles,
+		kInstructions,
+		kBranchMisses,
+		kL1DMisses,
+		kCounterCount
+	};
+
+	using Values = std::array<uint64_t, kCounterCount>;
+
+	PerfCounters ();
+
+	~PerfCounters ();
+
+	bool is_available () const noexcept
+	{
+		return -1 != group_fd_;
+	}
+
+	bool is_available (Counter counter) const noexcept
+	{
+		return -1 != fds_[counter];
+	}
+
+	const std::string& get_error () const noexcept
+	{
+		return error_;
+	}
+
+	// Counting is off until enable.
+	void enable ();
+
+	void disable ();
+
+	// Reads every counter with one system call.
+	Values read () const;
+
+	static const char* get_name (Counter counter) noexcept;
+
+private:
+	std::array<int, kCounterCount> fds_;
+	int                            group_fd_;
+	std::string                    error_;
+};
+
+inline PerfCounters::Values operator- (const PerfCounters::Values& lhs, const PerfCounters::Values& rhs) noexcept
+{
+	auto result = PerfCounters::Values();
+	for (auto i = 0u; i != result.size(); ++i)
+		result[i] = lhs[i] - rhs[i];
+
+	return result;
+}
+
+inline PerfCounters::Values& operator+= (PerfCounters::Values& lhs, const PerfCounters::Values& rhs) noexcept
+{
+	for (auto i = 0u; i != lhs.size(); ++i)
+		lhs[i] += rhs[i];
+
+	return lhs;
+}
+
+// A hook policy for Chip that attributes the counters to the class of every instruction.
+//
+// Reading the counters around every instruction costs far more than the instruction, so the
+// cost of a bare read pair (measured by calibrate) is subtracted. Use it for the relative
+// weight of the opcode classes, and PerfCounters around whole frames for absolute numbers.
+class OpcodeClassProfiler
+{
+public:
+	OpcodeClassProfiler ()
+		:
+		counters_(nullptr),
+		class_   (0u     ),
+		begin_   (       ),
+		overhead_(       ),
+		totals_  (       ),
+		counts_  (       )
+	{
+		overhead_.fill(0u);
+		clear();
+	}
+
+	void attach (const PerfCounters* counters) noexcept
+	{
+		counters_ = counters;
+	}
+
+	// Measures the counts of a bare read pair, the least of a number of tries.
+	void calibrate ()
+	{
+		if (nullptr == counters_ || !counters_->is_available())
+			return;
+
+		overhead_.fill(~uint64_t { 0 });
+		for (auto i = 0u; i != 1000u; ++i)
+		{
+			const auto begin = counters_->read();
+			const auto delta = counters_->read() - begin;
+
+			for (auto j = 0u; j != overhead_.size(); ++j)
+				overhead_[j] = std::min(overhead_[j], delta[j]);
+		}
+	}
+
+	void clear ()
+	{
+		for (auto& total : totals_)
+			total.fill(0u);
+		counts_.fill(0u);
+	}
+
+	const auto& get_totals () const noexcept
+	{
+		return totals_;
+	}
+
+	const auto& get_counts () const noexcept
+	{
+		return counts_;
+	}
+
+	template <typename Machine>
+	bool before_execute (const Machine& chip)
+	{
+		if (nullptr == counters_)
+			return true;
+
+		class_ = get_opcode_class(chip.fetch());
+		begin_ = counters_->read();
+
+		return true;
+	}
+
+	template <typename Machine>
+	void after_execute (const Machine&)
+	{
+		if (nullptr == counters_)
+			return;
+
+		const auto delta = counters_->read() - begin_;
+
+		for (auto i = 0u; i != delta.size(); ++i)
+			totals_[class_][i] += delta[i] > overhead_[i] ? delta[i] - overhead_[i] : 0u;
+		counts_[class_]++;
+	}
+
+	void on_read (uint32_t, uint32_t) noexcept
+	{
+	}
+
+	void on_write (uint32_t, uint32_t) noexcept
+	{
+	}
+
+private:
+	const PerfCounters*                                 counters_;
+	uint32_t                                            class_;
+	PerfCounters::Values                                begin_;
+	PerfCounters::Values                                overhead_;
+	std::array<PerfCounters::Values, kOpcodeClassCount> totals_;
+	std::array<uint64_t, kOpcodeClassCount>             counts_;
+};
+
+}  // namespace chip8
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,306 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "chip.hpp"
+
+namespace chip8
+{
+
+// The key a player holds in a frame, which each side sends the other once a frame.
+struct InputMessage
+{
+	uint32_t frame;
+	uint8_t  key;
+	uint8_t  player;
+	uint16_t reserved;
+};
+
+static_assert(sizeof(InputMessage) == 8, "InputMessage is a wire format!!!");
+
+// Two players on two machines, each run by its own side, kept in step by rollback.
+//
+//   auto rollback = Rollback<Chip<Chip8Spec>, Link>(chip, link, player, 10u);
+//
+//   // Every frame.
+//   rollback.advance(key);
+//   present(chip.get_vram());
+//
+// A side runs a frame as soon as it has its own key, with the other player's key predicted
+// to be the last one received. When a key comes in that differs from the prediction, the
+// machine is restored to the snapshot taken before that frame and the frames since are run
+// again, all before the next present. The snapshots are plain copies of the machine, one a
+// frame for the last max_frames frames; a side that gets max_frames ahead of the keys it
+// received waits for them. input_delay holds the own key back that many frames, which both
+// sides agree on, so a slow link mispredicts less.
+//
+// The machine holds one key, so when both players hold one they take turns a frame each.
+// Both machines must boot alike with the same seed. The link is a policy with
+//
+//   void send (const InputMessage& message);
+//   bool receive (InputMessage& message);  // The next message in order, or false for none.
+template <typename Machine, typename Link>
+class Rollback
+{
+	using Clock = std::chrono::steady_clock;
+
+public:
+	Rollback (Machine& machine, Link& link, uint32_t player, uint32_t cycles_per_frame,
+	          uint32_t max_frames = 8u, uint32_t input_delay = 0u)
+		:
+		machine_           (machine                                    ),
+		link_              (link                                       ),
+		player_            (player                                     ),
+		cycles_per_frame_  (cycles_per_frame                           ),
+		max_frames_        (max_frames                                 ),
+		input_delay_       (input_delay                                ),
+		snapshots_         (max_frames + 1, machine                    ),
+		local_             (2 * (max_frames + input_delay) + 2, kNoKey),
+		remote_            (local_.size(), kNoKey                      ),
+		predicted_         (local_.size(), kNoKey                      ),
+		frame_             (0u                                         ),
+		confirmed_         (input_delay                                ),
+		rollback_count_    (0u                                         ),
+		resimulated_count_ (0u                                         ),
+		last_resimulated_  (0u                                         ),
+		last_resimulation_ (0.0                                        )
+	{
+		assert(player < 2 && "There are two players!!!");
+		assert(cycles_per_frame != 0 && "A frame must run instructions!!!");
+		assert(max_frames != 0 && "A misprediction must be correctable!!!");
+	}
+
+	// Receives the other player's keys and corrects the frames they were mispredicted in.
+	// Returns false, without running a frame, while the other side is max_frames behind.
+	bool advance (uint8_t key)
+	{
+		synchronize();
+
+		if (frame_ >= confirmed_ + max_frames_)
+			return false;
+
+		const auto frame = frame_ + input_delay_;
+
+		local_[slot(frame)] = key;
+		link_.send(InputMessage { frame, key, static_cast<uint8_t>(player_), 0u });
+
+		run_frame(frame_++);
+
+		return true;
+	}
+
+	// Receives the keys that came in and corrects the machine, without running a new frame.
+	void synchronize ()
+	{
+		last_resimulated_  = 0u;
+		last_resimulation_ = 0.0;
+
+		auto first   = frame_;
+		auto message = InputMessage();
+		while (link_.receive(message))
+		{
+			assert(message.frame == confirmed_ && message.player != player_ && "The link lost or reordered a key!!!");
+
+			remote_[slot(message.frame)] = message.key;
+			if (message.frame < frame_ && predicted_[slot(message.frame)] != message.key)
+				first = std::min(first, message.frame);
+
+			++confirmed_;
+		}
+
+		if (first != frame_)
+			resimulate(first);
+	}
+
+	// The next frame to run.
+	uint32_t get_frame () const noexcept
+	{
+		return frame_;
+	}
+
+	// The frames below it have both keys known.
+	uint32_t get_confirmed_frame () const noexcept
+	{
+		return confirmed_;
+	}
+
+	uint64_t get_rollback_count () const noexcept
+	{
+		return rollback_count_;
+	}
+
+	uint64_t get_resimulated_frame_count () const noexcept
+	{
+		return resimulated_count_;
+	}
+
+	// The frames the last advance or synchronize ran again, and the seconds it took.
+	uint32_t get_last_resimulated_frames () const noexcept
+	{
+		return last_resimulated_;
+	}
+
+	double get_last_resimulation_time () const noexcept
+	{
+		return last_resimulation_;
+	}
+
+	// The key the machine holds for the two players' keys in a frame.
+	static uint8_t merge (uint8_t first, uint8_t second, uint32_t frame) noexcept
+	{
+		if (kNoKey == first)
+			return second;
+
+		if (kNoKey == second)
+			return first;
+
+		return 0 == frame % 2 ? first : second;
+	}
+
+private:
+	size_t slot (uint32_t frame) const noexcept
+	{
+		return frame % local_.size();
+	}
+
+	// The other player's key, predicted to be the last one received if it isn't yet.
+	uint8_t get_remote_key (uint32_t frame) const noexcept
+	{
+		if (frame < confirmed_)
+			return remote_[slot(frame)];
+
+		return 0 != confirmed_ ? remote_[slot(confirmed_ - 1)] : kNoKey;
+	}
+
+	uint8_t get_local_key (uint32_t frame) const noexcept
+	{
+		return frame < input_delay_ ? kNoKey : local_[slot(frame)];
+	}
+
+	void run_frame (uint32_t frame)
+	{
+		snapshots_[frame % snapshots_.size()] = machine_;
+
+		const auto local  = get_local_key(frame);
+		const auto remote = get_remote_key(frame);
+		predicted_[slot(frame)] = remote;
+
+		machine_.set_key(0 == player_ ? merge(local, remote, frame) : merge(remote, local, frame));
+
+		machine_.run_frame(cycles_per_frame_);
+	}
+
+	void resimulate (uint32_t first)
+	{
+		assert(frame_ - first <= max_frames_ && "The snapshot was overwritten!!!");
+
+		const auto begin = Clock::now();
+
+		machine_ = snapshots_[first % snapshots_.size()];
+		for (auto frame = first; frame != frame_; ++frame)
+			run_frame(frame);
+
+		last_resimulated_  = frame_ - first;
+		last_resimulation_ = std::chrono::duration<double>(Clock::now() - begin).count();
+
+		++rollback_count_;
+		resimulated_count_ += last_resimulated_;
+	}
+
+private:
+	Machine&             machine_;
+	Link&                link_;
+	uint32_t             player_;
+	uint32_t             cycles_per_frame_;
+	uint32_t             max_frames_;
+	uint32_t             input_delay_;
+	std::vector<Machine> snapshots_;
+	std::vector<uint8_t> local_;
+	std::vector<uint8_t> remote_;
+	std::vector<uint8_t> predicted_;
+	uint32_t             frame_;
+	uint32_t             confirmed_;
+	uint64_t             rollback_count_;
+	uint64_t             resimulated_count_;
+	uint32_t             last_resimulated_;
+	double               last_resimulation_;
+};
+
+// Both ends of a link within one process, e.g. to run both players side by side.
+//
+//   auto links  = LoopbackLink::make_pair(3u);
+//   auto first  = Rollback<Machine, LoopbackLink>(a, links.first,  0u, 10u);
+//   auto second = Rollback<Machine, LoopbackLink>(b, links.second, 1u, 10u);
+//
+// A message arrives latency polls of the receiving end after it was sent, where a poll is
+// a receive that found nothing. A Rollback polls once a frame, stalled or not, so that is
+// a latency in frames.
+class LoopbackLink
+{
+	struct Channel
+	{
+		std::deque<std::pair<uint64_t, InputMessage>> messages;   // With the poll they arrive at.
+		uint64_t                                      poll_count = 0u;
+	};
+
+public:
+	static std::pair<LoopbackLink, LoopbackLink> make_pair (uint32_t latency = 0u)
+	{
+		const auto ab = std::make_shared<Channel>();
+		const auto ba = std::make_shared<Channel>();
+
+		return { LoopbackLink(ab, ba, latency), LoopbackLink(ba, ab, latency) };
+	}
+
+	void send (const InputMessage& message)
+	{
+		output_->messages.emplace_back(output_->poll_count + latency_, message);
+	}
+
+	bool receive (InputMessage& message)
+	{
+		if (input_->messages.empty() || input_->messages.front().first > input_->poll_count)
+		{
+			++input_->poll_count;
+			return false;
+		}
+
+		message = input_->messages.front().second;
+		input_->messages.pop_front();
+
+		return true;
+	}
+
+	// Delivers the messages on the way at the next receive, e.g. at the end of a session.
+	void flush () noexcept
+	{
+		for (auto& message : input_->messages)
+			message.first = input_->poll_count;
+	}
+
+private:
+	LoopbackLink (std::shared_ptr<Channel> output, std::shared_ptr<Channel> input, uint32_t latency)
+		:
+		output_ (std::move(output)),
+		input_  (std::move(input) ),
+		latency_(latency          )
+	{
+	}
+
+private:
+	std::shared_ptr<Channel> output_;
+	std::shared_ptr<Channel> input_;
+	uint32_t                 latency_;
+};
+
+}  // namespace chip8
+
+#endif // ROLLBACK_H
@@ -0,0 +1,37 @@
+#ifndef ROM_FILE_H
+#define ROM_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chip-spec.h"
+
+namespace chip8
+{
+
+// Why a ROM file couldn't be loaded.
+enum class RomError
+{
+	kNone,
+	kOpen,
+	kSize
+};
+
+// The biggest program which fits the memory of Spec after kProgramMemoryOffset.
+template <typename Spec>
+constexpr uint32_t get_max_rom_size () noexcept
+{
+	return Spec::kDRamSize - kProgramMemoryOffset;
+}
+
+// Reads the whole ROM file at path into rom, which is left as it is if it fails.
+// The ROM has to be from min_size to max_size bytes.
+RomError load_rom (const std::string& path, size_t min_size, size_t max_size, std::vector<uint8_t>& rom);
+
+// The message the tools print for the error, followed by the path.
+const char* get_message (RomError error) noexcept;
+
+}  // namespace chip8
+
+#endif // ROM_FILE_H
@@ -0,0 +1,155 @@
+#ifndef RUN_AHEAD_H
+#define RUN_AHEAD_H
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+#include "chip.hpp"
+
+namespace chip8
+{
+
+// Hides the frames a program takes to show a key press, by presenting the future.
+//
+//   auto chip      = Chip<Chip8Spec>();
+//   auto run_ahead = RunAhead<Chip<Chip8Spec>>(chip, 10u);
+//   run_ahead.enable_auto_tune(3u);
+//
+//   // Every frame.
+//   run_ahead.set_key(key);
+//   run_ahead.run_frame();
+//   present(run_ahead.speculate().get_vram());
+//
+// The machine runs the real frames. speculate copies it into a second machine and runs
+// that some frames ahead with the keys held now, and its screen is what gets presented;
+// the real machine never sees the speculation, so nothing has to be restored. The state
+// copy is a plain assignment of the machine, which doesn't allocate once the second
+// machine owns the pages it writes (see PagedMemory). The hooks are copied and run in the
+// speculative frames too, so use a machine without recording hooks.
+//
+// Speculating costs a copy and the frames run ahead, once per presented frame. The auto
+// tune measures how many frames the program takes to show a key press and runs that many
+// ahead, up to a maximum.
+template <typename Machine>
+class RunAhead
+{
+public:
+	// Frames between the measurements of the auto tune.
+	static constexpr auto kTunePeriod = 60u;
+
+	RunAhead (Machine& machine, uint32_t cycles_per_frame, uint32_t frames = 1u)
+		:
+		machine_         (machine         ),
+		ahead_           (machine         ),
+		probe_           (machine         ),
+		cycles_per_frame_(cycles_per_frame),
+		frames_          (frames          ),
+		max_frames_      (0u              ),
+		frame_count_     (0u              )
+	{
+		assert(cycles_per_frame != 0 && "A frame must run instructions!!!");
+	}
+
+	void set_key (uint8_t key) noexcept
+	{
+		machine_.set_key(key);
+	}
+
+	// Runs a real frame, the ones that are caught up too.
+	void run_frame ()
+	{
+		run(machine_, 1u);
+
+		// A program that shows no key press (e.g. paused) keeps the frames it had, as it
+		// gives nothing to hide.
+		auto lag = 0u;
+		if (0 != max_frames_ && 0 == frame_count_++ % kTunePeriod && measure_lag(max_frames_, lag))
+			frames_ = lag;
+	}
+
+	// Returns the machine to present, the real one run the frames ahead.
+	const Machine& speculate ()
+	{
+		if (0 == frames_)
+			return machine_;
+
+		ahead_ = machine_;
+		run(ahead_, frames_);
+
+		return ahead_;
+	}
+
+	// Runs a fixed number of frames ahead, which stops the auto tune.
+	void set_frames (uint32_t frames) noexcept
+	{
+		frames_     = frames;
+		max_frames_ = 0u;
+	}
+
+	// Runs as many frames ahead as the program takes to show a key press, up to max_frames.
+	void enable_auto_tune (uint32_t max_frames) noexcept
+	{
+		max_frames_  = max_frames;
+		frame_count_ = 0u;
+	}
+
+	auto get_frames () const noexcept
+	{
+		return frames_;
+	}
+
+	// Measures the number of frames after the current one until a key press changes the
+	// screen. Returns false if no key does within max_frames. Tries every key on copies.
+	bool measure_lag (uint32_t max_frames, uint32_t& lag)
+	{
+		auto responds = false;
+
+		lag = max_frames;
+		for (auto key = uint8_t { 0x0 }; key != 0x10 && lag != 0; ++key)
+		{
+			if (key == machine_.get_key())
+				continue;
+
+			ahead_ = machine_;
+			probe_ = machine_;
+			probe_.set_key(key);
+
+			// The frame with the key in is the one presented without running ahead.
+			for (auto frame = 0u; frame <= lag; ++frame)
+			{
+				run(ahead_, 1u);
+				run(probe_, 1u);
+
+				if (ahead_.get_vram() != probe_.get_vram())
+				{
+					lag      = frame;
+					responds = true;
+					break;
+				}
+			}
+		}
+
+		return responds;
+	}
+
+private:
+	void run (Machine& machine, uint32_t frames)
+	{
+		for (auto i = 0u; i != frames; ++i)
+			machine.run_frame(cycles_per_frame_);
+	}
+
+private:
+	Machine& machine_;
+	Machine  ahead_;
+	Machine  probe_;
+	uint32_t cycles_per_frame_;
+	uint32_t frames_;
+	uint32_t max_frames_;
+	uint32_t frame_count_;
+};
+
+}  // namespace chip8
+
+#endif // RUN_AHEAD_H
@@ -0,0 +1,44 @@
+#ifndef SESSION_PROTOCOL_H
+#define SESSION_PROTOCOL_H
+
+#include <cstdint>
+
+namespace chip8
+{
+
+// The messages between Chip8Server and its clients over a Unix stream socket. Every
+// message is a MessageHeader followed by size bytes of payload, in the byte order of the
+// machine (the socket is local).
+//
+//   kAttach (client): receive the frames of the session, and send keys to it.
+//   kKey    (client): payload of one byte, the key held down (0x0 to 0xF) or kNoKey, in
+//                     the session attached to. Sent before kAttach, it closes the connection.
+//   kFrame  (server): payload of the frame number (32 bits), then an encode_delta of the
+//                     packed frame against the last frame sent to the client, or against
+//                     a blank frame if kKeyframe is set. Frames the client is too slow
+//                     for are skipped, so the numbers may jump.
+enum class MessageType : uint8_t
+{
+	kAttach,
+	kKey,
+	kFrame
+};
+
+constexpr auto kKeyframe = uint8_t { 0x1 };
+
+struct MessageHeader
+{
+	uint32_t size;
+	uint8_t  type;
+	uint8_t  flags;
+	uint16_t session;
+};
+
+static_assert(sizeof(MessageHeader) == 8, "MessageHeader is a wire format!!!");
+
+// The largest payload a client sends, bigger ones close the connection.
+constexpr auto kMaxClientPayloadSize = 64u;
+
+}  // namespace chip8
+
+#endif // SESSION_PROTOCOL_H
@@ -0,0 +1,246 @@
+#ifndef STATE_SEARCH_H
+#define STATE_SEARCH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+#include <util/noncopyable.h>
+#include <util/thread-pool.h>
+
+#include "chip.hpp"
+
+namespace chip8
+{
+
+// Breadth first search over key inputs, for play testing and search based agents.
+//
+//   auto pool   = utl::ThreadPool();
+//   auto search = StateSearch<Chip<Chip8Spec>>(pool, 10u);
+//   search.set_scorer([](const auto& chip) { return chip.get_v(0x3); });
+//   search.reset(chip);
+//   for (auto depth = 0u; depth != 8u; ++depth)
+//   {
+//       search.expand(4u);
+//       search.prune(1000u);
+//   }
+//   const auto keys = search.get_keys(search.get_best());
+//
+// A level holds the states reached so far. expand forks every state of it once per key,
+// holds the key for a number of frames and makes the successors the next level. The
+// successors run and are scored on the pool; then the ones whose state hash was seen
+// before, in any level, are dropped in order, so the search is deterministic. Forking is
+// a copy of the machine. Only the current level keeps its machines, the older ones keep
+// how each state was reached.
+template <typename Machine>
+class StateSearch : private utl::Noncopyable
+{
+public:
+	using Scorer = std::function<double (const Machine&)>;
+
+	struct State
+	{
+		Machine  machine;
+		uint64_t hash;
+		double   score;
+	};
+
+	StateSearch (utl::ThreadPool& pool, uint32_t cycles_per_frame)
+		:
+		pool_            (pool            ),
+		cycles_per_frame_(cycles_per_frame),
+		keys_            (0x10            ),
+		scorer_          (                ),
+		level_           (                ),
+		successors_      (                ),
+		edges_           (                ),
+		seen_            (                ),
+		expanded_count_  (0u              )
+	{
+		assert(cycles_per_frame != 0 && "A frame must run instructions!!!");
+		std::iota(keys_.begin(), keys_.end(), uint8_t { 0x0 });
+	}
+
+	// The keys every state is expanded by, kNoKey for none held. All 16 by default.
+	void set_keys (const std::vector<uint8_t>& keys)
+	{
+		keys_ = keys;
+	}
+
+	// Scores every successor on the pool, so the scorer must be safe to call concurrently.
+	void set_scorer (const Scorer& scorer)
+	{
+		scorer_ = scorer;
+	}
+
+	// Starts over from one state.
+	void reset (const Machine& root)
+	{
+		level_.clear();
+		edges_.clear();
+		seen_.clear();
+		expanded_count_ = 0u;
+
+		const auto hash = root.get_state_hash();
+
+		level_.push_back({ root, hash, scorer_ ? scorer_(root) : 0.0 });
+		edges_.emplace_back(1u, Edge { kRoot, kNoKey });
+		seen_.insert(hash);
+	}
+
+	// Makes the successors of the current level the next level, and returns their number.
+	size_t expand (uint32_t frames)
+	{
+		const auto key_count = keys_.size();
+		const auto count     = level_.size() * key_count;
+
+		// The successors are kept between expands, so forking assigns into machines that
+		// already own their buffers.
+		if (successors_.size() < count)
+			successors_.resize(count, level_.front());
+
+		pool_.parallel_for(count, [&](size_t i)
+		{
+			auto& successor = successors_[i];
+
+			successor.machine = level_[i / key_count].machine;
+			successor.machine.set_key(keys_[i % key_count]);
+
+			for (auto j = 0u; j != frames; ++j)
+				successor.machine.run_frame(cycles_per_frame_);
+
+			successor.hash  = successor.machine.get_state_hash();
+			successor.score = scorer_ ? scorer_(successor.machine) : 0.0;
+		});
+
+		expanded_count_ += count;
+
+		auto edges = std::vector<Edge>();
+		auto level = std::vector<State>();
+		for (auto i = 0u; i != count; ++i)
+		{
+			if (!seen_.insert(successors_[i].hash).second)
+				continue;
+
+			edges.push_back({ static_cast<uint32_t>(i / key_count), keys_[i % key_count] });
+			level.push_back(successors_[i]);
+		}
+
+		edges_.push_back(std::move(edges));
+		level_ = std::move(level);
+
+		return level_.size();
+	}
+
+	// Keeps the count best scored states of the current level, in their order.
+	void prune (size_t count)
+	{
+		if (level_.size() <= count)
+			return;
+
+		auto order = std::vector<uint32_t>(level_.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs)
+		{
+			return level_[lhs].score > level_[rhs].score;
+		});
+
+		order.resize(count);
+		std::sort(order.begin(), order.end());
+
+		auto& edges = edges_.back();
+		auto  level = std::vector<State>();
+		auto  kept  = std::vector<Edge>();
+		for (const auto index : order)
+		{
+			level.push_back(std::move(level_[index]));
+			kept.push_back(edges[index]);
+		}
+
+		level_ = std::move(level);
+		edges  = std::move(kept);
+	}
+
+	const std::vector<State>& get_level () const noexcept
+	{
+		return level_;
+	}
+
+	// The index of the best scored state of the current level.
+	size_t get_best () const
+	{
+		assert(!level_.empty() && "The level is empty!!!");
+
+		const auto best = std::max_element(level_.begin(), level_.end(), [](const State& lhs, const State& rhs)
+		{
+			return lhs.score < rhs.score;
+		});
+
+		return static_cast<size_t>(best - level_.begin());
+	}
+
+	// The keys held from the root to a state of the current level, one a expand.
+	std::vector<uint8_t> get_keys (size_t index) const
+	{
+		auto keys = std::vector<uint8_t>();
+		for (auto depth = edges_.size() - 1; depth != 0; --depth)
+		{
+			const auto& edge = edges_[depth][index];
+
+			keys.push_back(edge.key);
+			index = edge.parent;
+		}
+
+		std::reverse(keys.begin(), keys.end());
+
+		return keys;
+	}
+
+	// The successors run, including the ones dropped as seen, which is the work done.
+	uint64_t get_expanded_count () const noexcept
+	{
+		return expanded_count_;
+	}
+
+	size_t get_seen_count () const noexcept
+	{
+		return seen_.size();
+	}
+
+private:
+	static constexpr auto kRoot = ~0u;
+
+	// How a state was reached: the state it was forked from in the level before, and the key.
+	struct Edge
+	{
+		uint32_t parent;
+		uint8_t  key;
+	};
+
+	// The hashes are already mixed.
+	struct Identity
+	{
+		size_t operator() (uint64_t hash) const noexcept
+		{
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	utl::ThreadPool&                       pool_;
+	uint32_t                               cycles_per_frame_;
+	std::vector<uint8_t>                   keys_;
+	Scorer                                 scorer_;
+	std::vector<State>                     level_;
+	std::vector<State>                     successors_;
+	std::vector<std::vector<Edge>>         edges_;
+	std::unordered_set<uint64_t, Identity> seen_;
+	uint64_t                               expanded_count_;
+};
+
+}  // namespace chip8
+
+#endif // STATE_SEARCH_H
@@ -0,0 +1,104 @@
+#ifndef TERMINAL_RENDERER_H
+#define TERMINAL_RENDERER_H
+
+#include <cstdint>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "frame-delta.h"
+
+namespace chip8
+{
+
+// Draws screens on an ANSI terminal, for watching a headless machine over SSH.
+//
+//   auto renderer = TerminalRenderer(64u, 32u, 1u, 16384u);
+//   write(STDOUT_FILENO, TerminalRenderer::kEnter, std::strlen(TerminalRenderer::kEnter));
+//
+//   // Every frame.
+//   const auto& output = renderer.render(chip);
+//   write(STDOUT_FILENO, output.data(), output.size());
+//
+// A text line shows two pixel rows with the half block characters, from the top left of
+// the terminal. A frame moves the cursor to the cells that changed since the frame rendered
+// before and writes only them, so a still screen costs nothing; the first frame is drawn
+// over a cleared terminal. With several planes a cell is an upper half block coloured by
+// its two pixels.
+//
+// bytes_per_second limits the output to what the terminal (or the link to it) takes: a
+// frame is skipped while the frames before used up the budget, and the next one rendered
+// brings the terminal up to date.
+class TerminalRenderer
+{
+public:
+	// Hides the cursor and clears the terminal, and shows the cursor again below the screen.
+	static constexpr const char* kEnter = "\x1b[?25l\x1b[2J";
+	static constexpr const char* kLeave = "\x1b[0m\x1b[?25h\n";
+
+	TerminalRenderer (uint32_t screen_width, uint32_t screen_height, uint32_t plane_count, uint32_t bytes_per_second = 0);
+
+	// Redraws every cell on the next render, for a terminal that was drawn over.
+	void invalidate ();
+
+	// Returns what brings the terminal from the frame rendered before to this packed frame,
+	// which is empty when nothing changed or the frame is skipped. The cursor is moved from
+	// wherever it is, so other output may come in between.
+	const std::string& render_frame (const uint8_t* frame);
+
+	// Renders the screen of a machine of the renderer's size.
+	template <typename Machine>
+	const std::string& render (const Machine& chip)
+	{
+		using Packed = PackedFrame<typename Machine::SpecType>;
+
+		assert(Packed::kSize == frame_.size() && "The machine's screen isn't the renderer's!!!");
+
+		Packed::pack(chip.get_vram().data(), frame_.data());
+
+		return render_frame(frame_.data());
+	}
+
+	// The text lines the screen takes.
+	uint32_t get_line_count () const noexcept
+	{
+		return line_count_;
+	}
+
+	uint64_t get_skipped_frame_count () const noexcept
+	{
+		return skipped_frame_count_;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// The pixel values of the upper and the lower half of every cell.
+	void read_cells (const uint8_t* frame);
+
+	void move_cursor (uint32_t line, uint32_t column);
+
+	void write_cell (uint8_t cell);
+
+private:
+	uint32_t             width_;
+	uint32_t             line_count_;
+	uint32_t             plane_count_;
+	uint32_t             bytes_per_second_;
+	std::vector<uint8_t> frame_;
+	std::vector<uint8_t> cells_;
+	std::vector<uint8_t> shown_;
+	std::string          output_;
+	uint32_t             cursor_line_;
+	uint32_t             cursor_column_;
+	uint8_t              foreground_;
+	uint8_t              background_;
+	double               budget_;
+	Clock::time_point    time_;
+	uint64_t             skipped_frame_count_;
+};
+
+}  // namespace chip8
+
+#endif // TERMINAL_RENDERER_H
@@ -0,0 +1,228 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <array>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <fstream>
+#include <condition_variable>
+#include <util/noncopyable.h>
+
+#include "chip-spec.h"
+#include "mapped-file.h"
+
+namespace chip8
+{
+
+constexpr auto kNoRegister = uint8_t { 0xFF };
+
+// One executed instruction. The layout is the on-disk format, so it's fixed at 16 bytes.
+struct TraceRecord
+{
+	uint16_t pc;
+	uint16_t opcode;
+	uint16_t i;
+	uint16_t write_address;  // Valid if write_size isn't zero.
+	uint8_t  write_size;     // The number of bytes written to memory.
+	uint8_t  write_value;    // The first byte written to memory.
+	uint8_t  register_index; // The first V register (except VF) changed, or kNoRegister.
+	uint8_t  register_value;
+	uint8_t  flag;           // VF after the instruction.
+	uint8_t  reserved[3];
+};
+
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord is an on-disk format!!!");
+
+// Appends records to a trace file from the emulation thread.
+//
+// Records are collected into one buffer while a writer thread encodes and writes the other,
+// so append never touches the file. The file is a sequence of blocks of up to
+// records_per_block records, each optionally compressed, followed by an index of the blocks.
+class TraceWriter : private utl::Noncopyable
+{
+public:
+	TraceWriter (const std::string& path, bool compressed, uint32_t records_per_block = 65536);
+
+	~TraceWriter ();
+
+	bool is_open () const noexcept
+	{
+		return is_open_;
+	}
+
+	void append (const TraceRecord& record)
+	{
+		front_[count_++] = record;
+
+		if (count_ == front_.size())
+			submit();
+	}
+
+	uint64_t get_record_count () const noexcept
+	{
+		return submitted_ + count_;
+	}
+
+private:
+	void submit ();
+
+	void write_blocks ();
+
+	void write_footer ();
+
+private:
+	std::ofstream            file_;
+	bool                     is_open_;
+	bool                     compressed_;
+	std::vector<TraceRecord> front_;
+	std::vector<TraceRecord> back_;
+	size_t                   count_;
+	size_t                   back_count_;
+	uint64_t                 submitted_;
+	std::vector<uint64_t>    offsets_;
+	std::mutex               mutex_;
+	std::condition_variable  condition_;
+	bool                     stop_;
+	std::thread              thread_;
+};
+
+// Random access to a trace file through a memory mapping.
+class TraceReader : private utl::Noncopyable
+{
+public:
+	explicit TraceReader (const std::string& path);
+
+	~TraceReader ();
+
+	bool is_open () const noexcept
+	{
+		return nullptr != data_;
+	}
+
+	// The number of records, which is the number of traced instructions.
+	uint64_t size () const noexcept
+	{
+		return record_count_;
+	}
+
+	// Reads the record of the index-th traced instruction. Returns false if its block is
+	// corrupt, which a compressed one can only tell when it's decoded.
+	bool read (uint64_t index, TraceRecord& record);
+
+private:
+	struct Block
+	{
+		uint64_t offset;
+		uint64_t first;
+		uint32_t count;
+		uint32_t payload_size;
+	};
+
+	bool read_index ();
+
+	bool scan_blocks ();
+
+	// Adds the block at offset if it's whole before end and fits the blocks before it.
+	bool add_block (uint64_t offset, uint64_t end);
+
+	void unmap ();
+
+	const Block& find_block (uint64_t index) const;
+
+private:
+	MappedFile               file_;
+	const uint8_t*           data_;
+	uint64_t                 size_;
+	bool                     compressed_;
+	uint32_t                 records_per_block_;
+	uint64_t                 record_count_;
+	std::vector<Block>       blocks_;
+	std::vector<TraceRecord> cache_;
+	size_t                   cached_block_;
+};
+
+// A hook policy for Chip that records every executed instruction into a TraceWriter.
+//
+//   auto chip   = Chip<Chip8Spec, VipQuirks, TraceRecorder>();
+//   auto writer = TraceWriter("pong.trace", true);
+//   chip.hooks().attach(&writer);
+class TraceRecorder
+{
+public:
+	TraceRecorder ()
+		:
+		writer_   (nullptr),
+		record_   (       ),
+		registers_(       )
+	{
+	}
+
+	void attach (TraceWriter* writer) noexcept
+	{
+		writer_ = writer;
+	}
+
+	template <typename Machine>
+	bool before_execute (const Machine& chip)
+	{
+		if (nullptr == writer_)
+			return true;
+
+		record_        = TraceRecord();
+		record_.pc     = static_cast<uint16_t>(chip.get_pc());
+		record_.opcode = chip.fetch();
+		registers_     = chip.get_registers();
+
+		return true;
+	}
+
+	template <typename Machine>
+	void after_execute (const Machine& chip)
+	{
+		if (nullptr == writer_)
+			return;
+
+		const auto& registers = chip.get_registers();
+
+		record_.register_index = kNoRegister;
+		for (auto i = 0u; i != kGeneralRegisterCount - 1; ++i)
+		{
+			if (registers[i] != registers_[i])
+			{
+				record_.register_index = static_cast<uint8_t>(i);
+				record_.register_value = registers[i];
+				break;
+			}
+		}
+
+		record_.i    = static_cast<uint16_t>(chip.get_i());
+		record_.flag = registers[0xF];
+
+		if (0 != record_.write_size)
+			record_.write_value = chip.get_memory()[record_.write_address % chip.get_memory().size()];
+
+		writer_->append(record_);
+	}
+
+	void on_read (uint32_t, uint32_t) noexcept
+	{
+	}
+
+	void on_write (uint32_t address, uint32_t size) noexcept
+	{
+		record_.write_address = static_cast<uint16_t>(address);
+		record_.write_size    = static_cast<uint8_t>(size);
+	}
+
+private:
+	TraceWriter*                               writer_;
+	TraceRecord                                record_;
+	std::array<uint8_t, kGeneralRegisterCount> registers_;
+};
+
+}  // namespace chip8
+
+#endif // TRACE_H
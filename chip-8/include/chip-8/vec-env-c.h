@@ -0,0 +1,91 @@
+#ifndef VEC_ENV_C_H
+#define VEC_ENV_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A C interface to chip8::VecEnv, e.g. for a trainer in Python through ctypes, in the
+// shared library Chip8Env. The environments are CHIP-8 machines with the COSMAC VIP quirks.
+//
+//   chip8_vec_env* envs = chip8_vec_env_create(rom, rom_size, 256, 10, CHIP8_OBSERVATION_PACKED, 0);
+//   chip8_vec_env_reset(envs, 1);
+//   for (;;)
+//   {
+//       choose(chip8_vec_env_get_observations(envs), actions);
+//       chip8_vec_env_step(envs, actions);
+//       learn(chip8_vec_env_get_rewards(envs), chip8_vec_env_get_ends(envs));
+//   }
+//   chip8_vec_env_destroy(envs);
+//
+// The observations, rewards and ends are the buffers of the environments themselves, valid
+// until they are destroyed and rewritten by every step.
+
+#if defined(_WIN32) && defined(CHIP8_ENV_BUILD)
+#define CHIP8_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define CHIP8_ENV_API __declspec(dllimport)
+#else
+#define CHIP8_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct chip8_vec_env chip8_vec_env;
+
+// The observation formats, see chip8::ObservationFormat.
+#define CHIP8_OBSERVATION_PACKED 0
+#define CHIP8_OBSERVATION_BYTES  1
+
+// The episode ends, see chip8::EpisodeEnd.
+#define CHIP8_EPISODE_NONE       0
+#define CHIP8_EPISODE_TERMINATED 1
+#define CHIP8_EPISODE_TRUNCATED  2
+
+// The action that holds no key.
+#define CHIP8_NO_KEY 0xFF
+
+// The hooks get the 16 registers V0 to VF and the 4096 bytes of memory of a machine after
+// its frame. They run on the worker threads, so they must be safe to call concurrently.
+typedef double (*chip8_reward_hook) (const uint8_t* registers, const uint8_t* memory, void* user_data);
+typedef int    (*chip8_done_hook)   (const uint8_t* registers, const uint8_t* memory, void* user_data);
+
+// Boots env_count environments from the program and steps them on thread_count threads,
+// the calling one included (0 for a thread a core). Returns NULL for a program that doesn't
+// fit, no environments or no memory.
+CHIP8_ENV_API chip8_vec_env* chip8_vec_env_create (const uint8_t* program, size_t size, uint32_t env_count,
+                                                   uint32_t cycles_per_frame, int observation_format, uint32_t thread_count);
+
+CHIP8_ENV_API void chip8_vec_env_destroy (chip8_vec_env* envs);
+
+// A NULL hook removes it.
+CHIP8_ENV_API void chip8_vec_env_set_reward (chip8_vec_env* envs, chip8_reward_hook hook, void* user_data);
+
+CHIP8_ENV_API void chip8_vec_env_set_done (chip8_vec_env* envs, chip8_done_hook hook, void* user_data);
+
+// The frames an episode runs at most, 0 for no limit.
+CHIP8_ENV_API void chip8_vec_env_set_max_frames (chip8_vec_env* envs, uint32_t frames);
+
+CHIP8_ENV_API void chip8_vec_env_reset (chip8_vec_env* envs, uint32_t seed);
+
+// Holds actions[i], a key from 0x0 to 0xF or CHIP8_NO_KEY, in the i-th environment for a frame.
+// Any other action holds no key.
+CHIP8_ENV_API void chip8_vec_env_step (chip8_vec_env* envs, const uint8_t* actions);
+
+CHIP8_ENV_API size_t chip8_vec_env_get_env_count (const chip8_vec_env* envs);
+
+CHIP8_ENV_API size_t chip8_vec_env_get_observation_size (const chip8_vec_env* envs);
+
+CHIP8_ENV_API const uint8_t* chip8_vec_env_get_observations (const chip8_vec_env* envs);
+
+CHIP8_ENV_API const double* chip8_vec_env_get_rewards (const chip8_vec_env* envs);
+
+// CHIP8_EPISODE_* of every environment.
+CHIP8_ENV_API const uint8_t* chip8_vec_env_get_ends (const chip8_vec_env* envs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VEC_ENV_C_H
@@ -0,0 +1,264 @@
+#ifndef VEC_ENV_H
+#define VEC_ENV_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <util/noncopyable.h>
+#include <util/thread-pool.h>
+
+#include "chip.hpp"
+#include "chip-memory.hpp"
+#include "frame-delta.h"
+
+namespace chip8
+{
+
+// How an environment's screen is written into the observations.
+enum class ObservationFormat
+{
+	kPacked,  // A bit a pixel, see PackedFrame.
+	kBytes    // A byte a pixel, the VRam as it is (a bit a plane).
+};
+
+// How an environment's episode stands after a step.
+enum class EpisodeEnd : uint8_t
+{
+	kNone,
+	kTerminated,  // The done hook said so, or the machine halted.
+	kTruncated    // It ran the most frames an episode may.
+};
+
+// Environments for training agents, stepped all at once.
+//
+//   auto pool = utl::ThreadPool();
+//   auto envs = VecEnv<Chip<Chip8Spec>>(pool, rom.data(), rom.size(), 256u, 10u);
+//   envs.set_reward([](const auto& chip) { return chip.get_v(0xE); });
+//   envs.reset(1u);
+//   for (;;)
+//   {
+//       choose(envs.get_observations(), actions.data());
+//       envs.step(actions.data());
+//       learn(envs.get_rewards(), envs.get_ends());
+//   }
+//
+// step holds an action (a key, or kNoKey) in every environment, runs a frame each on the
+// pool, and writes the screens into one buffer, environment after environment, with the
+// rewards and the episode ends beside it. An environment whose episode ended is reset from
+// the boot image in the same step, with a seed of its own, so its observation is the first
+// of the next episode while its reward and end are of the last. The buffers are allocated
+// once, and a step copies nothing but the screens into them, and only the screens that
+// changed since they were.
+//
+// The hooks run on the pool, so they must be safe to call concurrently.
+template <typename Machine>
+class VecEnv : private utl::Noncopyable
+{
+	using Packed = PackedFrame<typename Machine::SpecType>;
+
+	// The environments a pool iteration steps, enough to make up for handing it out.
+	static constexpr auto kChunkSize = 64u;
+
+public:
+	using Reward = std::function<double (const Machine&)>;
+	using Done   = std::function<bool (const Machine&)>;
+
+	VecEnv (utl::ThreadPool& pool, const uint8_t* program, size_t size, uint32_t env_count, uint32_t cycles_per_frame,
+	        ObservationFormat format = ObservationFormat::kPacked)
+		:
+		pool_            (pool                                       ),
+		image_           (Machine::make_image(program, size)         ),
+		cycles_per_frame_(cycles_per_frame                           ),
+		format_          (format                                     ),
+		observation_size_(get_observation_size(format)               ),
+		reward_          (                                           ),
+		done_            (                                           ),
+		max_frames_      (0u                                         ),
+		seed_            (0u                                         ),
+		machines_        (env_count, Machine(image_, 0u)             ),
+		frames_          (env_count, 0u                              ),
+		episodes_        (env_count, 0u                              ),
+		generations_     (env_count, 0u                              ),
+		observations_    (size_t { env_count } * observation_size_   ),
+		rewards_         (env_count, 0.0                             ),
+		ends_            (env_count, EpisodeEnd::kNone               ),
+		actions_         (nullptr                                    ),
+		job_             ([this](size_t chunk) { step_chunk(chunk); })
+	{
+		assert(env_count != 0 && "There must be an environment!!!");
+		assert(cycles_per_frame != 0 && "A frame must run instructions!!!");
+	}
+
+	// The reward of a step, computed after its frame. 0 without one.
+	void set_reward (const Reward& reward)
+	{
+		reward_ = reward;
+	}
+
+	// Whether the episode ended with a step, asked after its frame.
+	void set_done (const Done& done)
+	{
+		done_ = done;
+	}
+
+	// The frames an episode runs at most, 0 for no end but the done hook and halting.
+	void set_max_frames (uint32_t frames) noexcept
+	{
+		max_frames_ = frames;
+	}
+
+	// Starts every environment over, and writes the first observations.
+	void reset (uint32_t seed)
+	{
+		seed_ = seed;
+
+		for (auto i = 0u; i != machines_.size(); ++i)
+		{
+			episodes_[i] = 0u;
+			restart(i);
+
+			rewards_[i] = 0.0;
+			ends_[i]    = EpisodeEnd::kNone;
+		}
+	}
+
+	// Runs a frame in every environment, holding actions[i] (a key, or kNoKey) in the i-th.
+	void step (const uint8_t* actions)
+	{
+		actions_ = actions;
+		pool_.parallel_for((machines_.size() + kChunkSize - 1) / kChunkSize, job_);
+		actions_ = nullptr;
+	}
+
+	size_t get_env_count () const noexcept
+	{
+		return machines_.size();
+	}
+
+	ObservationFormat get_observation_format () const noexcept
+	{
+		return format_;
+	}
+
+	// The bytes of one environment's observation, which is at i times this in the buffer.
+	size_t get_observation_size () const noexcept
+	{
+		return observation_size_;
+	}
+
+	static constexpr size_t get_observation_size (ObservationFormat format) noexcept
+	{
+		return ObservationFormat::kPacked == format ? Packed::kSize : Machine::SpecType::kVRamSize;
+	}
+
+	// The buffers stay where they are for the lifetime of the environments.
+	const uint8_t* get_observations () const noexcept
+	{
+		return observations_.data();
+	}
+
+	const double* get_rewards () const noexcept
+	{
+		return rewards_.data();
+	}
+
+	const EpisodeEnd* get_ends () const noexcept
+	{
+		return ends_.data();
+	}
+
+	const Machine& get_machine (size_t index) const noexcept
+	{
+		return machines_[index];
+	}
+
+private:
+	void step_chunk (size_t chunk)
+	{
+		const auto begin = chunk * kChunkSize;
+		const auto end   = std::min(begin + kChunkSize, machines_.size());
+
+		for (auto i = begin; i != end; ++i)
+		{
+			auto& machine = machines_[i];
+
+			machine.set_key(actions_[i]);
+			machine.run_frame(cycles_per_frame_);
+
+			++frames_[i];
+
+			rewards_[i] = reward_ ? reward_(machine) : 0.0;
+
+			if ((done_ && done_(machine)) || machine.is_halted())
+				ends_[i] = EpisodeEnd::kTerminated;
+			else if (0 != max_frames_ && frames_[i] >= max_frames_)
+				ends_[i] = EpisodeEnd::kTruncated;
+			else
+				ends_[i] = EpisodeEnd::kNone;
+
+			if (EpisodeEnd::kNone != ends_[i])
+			{
+				++episodes_[i];
+				restart(i);
+			}
+			else if (machine.get_frame_generation() != generations_[i])
+			{
+				observe(i);
+			}
+		}
+	}
+
+	// Boots an environment from the image, seeded by the seed of the reset, the environment
+	// and the episode, so every episode is different and a reset with a seed repeats them.
+	void restart (size_t index)
+	{
+		auto& machine = machines_[index];
+
+		machine.reset(image_);
+		machine.seed(static_cast<uint32_t>(hash_word(hash_word(seed_, index), episodes_[index])));
+
+		frames_[index] = 0u;
+		observe(index);
+	}
+
+	void observe (size_t index)
+	{
+		const auto observation = observations_.data() + index * observation_size_;
+		const auto vram        = machines_[index].get_vram().data();
+
+		generations_[index] = machines_[index].get_frame_generation();
+
+		if (ObservationFormat::kPacked == format_)
+			Packed::pack(vram, observation);
+		else
+			std::memcpy(observation, vram, observation_size_);
+	}
+
+private:
+	utl::ThreadPool&                   pool_;
+	typename Machine::Image            image_;
+	uint32_t                           cycles_per_frame_;
+	ObservationFormat                  format_;
+	size_t                             observation_size_;
+	Reward                             reward_;
+	Done                               done_;
+	uint32_t                           max_frames_;
+	uint32_t                           seed_;
+	std::vector<Machine>               machines_;
+	std::vector<uint32_t>              frames_;
+	std::vector<uint64_t>              episodes_;
+	std::vector<uint32_t>              generations_;  // Of the screens last observed.
+	std::vector<uint8_t>               observations_;
+	std::vector<double>                rewards_;
+	std::vector<EpisodeEnd>            ends_;
+	const uint8_t*                     actions_;
+	const std::function<void (size_t)> job_;          // Made once, so a step doesn't.
+};
+
+}  // namespace chip8
+
+#endif // VEC_ENV_H
@@ -0,0 +1,197 @@
+// Runs many machines and shows them all in one window, as a monitor of a sweep would.
+//
+// Every machine runs the ROM (the built-in Pong without --rom) with its own random number
+// seed and random key presses. The screens are tiled by plt::Mosaic, and the time the
+// tiling takes is reported when the window closes, after --frames frames (0 for never).
+//
+// Usage: Chip8Mosaic [--machines <count>] [--rom <path>] [--frames <count>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iterator>
+#include <util/histogram.h>
+#include <util/singleton.hpp>
+#include <util/singleton-factory.hpp>
+#include <platform/display.h>
+#include <platform/window.h>
+#include <platform/pixmap.h>
+#include <platform/mosaic.h>
+#include <chip-8/chip.hpp>
+#include <chip-8/chip-pool.hpp>
+#include <chip-8/rom-file.h>
+
+namespace
+{
+
+using Spec    = chip8::Chip8Spec;
+using Machine = chip8::Chip<Spec, chip8::DefaultQuirks<Spec>, chip8::NoHooks, chip8::PagedMemory<Spec>>;
+using Clock   = std::chrono::steady_clock;
+
+constexpr auto kCyclesPerFrame = 10u;
+
+// A machine changes the key it holds about every half second.
+constexpr auto kKeyPeriod = 30u;
+
+struct Options
+{
+	uint32_t    machines = 256u;
+	std::string rom_path;
+	uint32_t    frames   = 600u;
+};
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--machines")
+			options.machines = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--rom")
+			options.rom_path = value;
+		else if (option == "--frames")
+			options.frames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+			return false;
+	}
+
+	return options.machines > 0;
+}
+
+class Monitor
+{
+public:
+	Monitor (const std::vector<uint8_t>& rom, const Options& options)
+		:
+		size_      { 1280, 720            },
+		pool_      (rom.data(), rom.size()),
+		machines_  (                      ),
+		random_    (0x1u                  ),
+		mosaic_    (size_                 ),
+		pixmap_ptr_(nullptr               ),
+		frames_    (options.frames        ),
+		histogram_ (0.01, 10000u          ),
+		rows_      (0u                    ),
+		renders_   (0u                    )
+	{
+		for (auto i = 0u; i != options.machines; ++i)
+		{
+			machines_.push_back(pool_.acquire());
+			machines_.back()->seed(i);
+			mosaic_.add_tile({ Spec::kScreenWidth, Spec::kScreenHeight });
+		}
+
+		utl::SingletonFactory<plt::Display>::create();
+		utl::SingletonFactory<plt::Window>::create("Chip-8 Mosaic", size_);
+
+		pixmap_ptr_ = std::make_unique<plt::Pixmap>(size_);
+
+		if (!mosaic_.layout())
+			std::cerr << "The machines don't fit at scale 1, some aren't shown." << std::endl;
+
+		mosaic_.clear(*pixmap_ptr_);
+
+		utl::Singleton<plt::Window>::get().update_signal().connect(std::bind(&Monitor::update_callback, this));
+		utl::Singleton<plt::Window>::get().render_signal().connect(std::bind(&Monitor::render_callback, this));
+	}
+
+	~Monitor ()
+	{
+		utl::Singleton<plt::Window>::get().render_signal().disconnect(std::bind(&Monitor::render_callback, this));
+		utl::Singleton<plt::Window>::get().update_signal().disconnect(std::bind(&Monitor::update_callback, this));
+
+		pixmap_ptr_ = nullptr;
+
+		utl::SingletonFactory<plt::Window>::destroy();
+		utl::SingletonFactory<plt::Display>::destroy();
+	}
+
+	void run ()
+	{
+		utl::Singleton<plt::Window>::get().receivce_msgs();
+
+		std::cout << "machines " << machines_.size() << ", scale " << mosaic_.get_scale()
+		          << ", frames " << renders_ << ", mosaic mean " << histogram_.get_mean() * 1000.0
+		          << " us (p99 " << histogram_.get_percentile(0.99) * 1000.0 << " us, max "
+		          << histogram_.get_max() * 1000.0 << " us), rows drawn a frame "
+		          << static_cast<double>(rows_) / std::max<uint64_t>(renders_, 1u) << std::endl;
+	}
+
+private:
+	void update_callback ()
+	{
+		for (auto machine : machines_)
+		{
+			if (0 == random_() % kKeyPeriod)
+				machine->set_key(0 == random_() % 3 ? chip8::kNoKey : static_cast<uint8_t>(random_() % 0x10));
+
+			machine->run_frame(kCyclesPerFrame);
+		}
+	}
+
+	void render_callback ()
+	{
+		const auto begin = Clock::now();
+
+		for (auto i = 0u; i != machines_.size(); ++i)
+		{
+			const auto machine = machines_[i];
+			mosaic_.draw_tile(*pixmap_ptr_, i, machine->get_frame_generation(), machine->get_vram().data());
+		}
+
+		histogram_.add(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+		rows_ += mosaic_.take_drawn_row_count();
+
+		utl::Singleton<plt::Window>::get().draw(*pixmap_ptr_);
+
+		if (++renders_ == frames_)
+			utl::Singleton<plt::Window>::get().close();
+	}
+
+private:
+	utl::Vec2<uint32_t>          size_;
+	chip8::ChipPool<Machine>     pool_;
+	std::vector<Machine*>        machines_;
+	std::minstd_rand             random_;
+	plt::Mosaic                  mosaic_;
+	std::unique_ptr<plt::Pixmap> pixmap_ptr_;
+	uint32_t                     frames_;
+	utl::Histogram               histogram_;
+	uint64_t                     rows_;
+	uint64_t                     renders_;
+};
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--machines <count>] [--rom <path>] [--frames <count>]" << std::endl;
+		return 1;
+	}
+
+	auto rom = std::vector<uint8_t>(std::begin(chip8::kPong), std::end(chip8::kPong));
+	if (!options.rom_path.empty())
+	{
+		const auto error = chip8::load_rom(options.rom_path, 1u, chip8::get_max_rom_size<Spec>(), rom);
+		if (chip8::RomError::kNone != error)
+		{
+			std::cerr << chip8::get_message(error) << ": " << options.rom_path << std::endl;
+			return 1;
+		}
+	}
+
+	Monitor(rom, options).run();
+
+	return 0;
+}
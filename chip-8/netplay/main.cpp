@@ -0,0 +1,340 @@
+// Plays the built-in Pong between two players, each on its own machine, kept in step by
+// chip8::Rollback.
+//
+// --host and --join run one player a process at 60 frames a second, linked by a Unix
+// socket: start the host (the left paddle, keys 1 and 4) and then join it (the right one,
+// keys C and D). --loopback runs both players in this process as fast as it can, linked
+// by a chip8::LoopbackLink whose keys arrive --latency frames late. The players press
+// random keys.
+//
+// After --frames frames a side waits for the other's last keys and prints its rollbacks,
+// the frames it ran again and what that cost the frames it happened in, and the hash of
+// the machine, which is the same on both sides if they stayed in step.
+//
+// Usage: Chip8Netplay (--host <socket path> | --join <socket path> | --loopback [--latency <frames>])
+//                     [--frames <count>] [--max-rollback <frames>] [--delay <frames>] [--seed <value>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <util/histogram.h>
+#include <chip-8/chip.hpp>
+#include <chip-8/rollback.hpp>
+
+namespace
+{
+
+using Spec    = chip8::Chip8Spec;
+using Machine = chip8::Chip<Spec>;
+using Clock   = std::chrono::steady_clock;
+
+constexpr auto kCyclesPerFrame = 10u;
+constexpr auto kFramePeriod    = std::chrono::microseconds(16667);
+
+// How long a side waits for the other's last keys.
+constexpr auto kSettleTimeout = std::chrono::seconds(5);
+
+// The keys of the left and the right paddle in Pong.
+constexpr uint8_t kPlayerKeys[2][2] = { { 0x1, 0x4 }, { 0xC, 0xD } };
+
+// A player changes the key it holds about every quarter second.
+constexpr auto kKeyPeriod = 15u;
+
+enum class Mode
+{
+	kNone,
+	kHost,
+	kJoin,
+	kLoopback
+};
+
+struct Options
+{
+	Mode        mode         = Mode::kNone;
+	std::string socket_path;
+	uint32_t    latency      = 4u;
+	uint32_t    frames       = 600u;
+	uint32_t    max_rollback = 8u;
+	uint32_t    delay        = 0u;
+	uint32_t    seed         = 1u;
+};
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (option == "--loopback")
+		{
+			options.mode = Mode::kLoopback;
+			continue;
+		}
+
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--host" || option == "--join")
+		{
+			options.mode        = option == "--host" ? Mode::kHost : Mode::kJoin;
+			options.socket_path = value;
+		}
+		else if (option == "--latency")
+			options.latency = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--frames")
+			options.frames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--max-rollback")
+			options.max_rollback = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--delay")
+			options.delay = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--seed")
+			options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+			return false;
+	}
+
+	return options.mode != Mode::kNone && options.max_rollback > 0;
+}
+
+// The link of a player to the other process, a message a packet.
+class SocketLink
+{
+public:
+	explicit SocketLink (int fd)
+		:
+		fd_(fd)
+	{
+	}
+
+	~SocketLink ()
+	{
+		close(fd_);
+	}
+
+	void send (const chip8::InputMessage& message)
+	{
+		::send(fd_, &message, sizeof(message), MSG_NOSIGNAL);
+	}
+
+	bool receive (chip8::InputMessage& message)
+	{
+		return ::recv(fd_, &message, sizeof(message), MSG_DONTWAIT) == sizeof(message);
+	}
+
+private:
+	int fd_;
+};
+
+// Listens on the path and accepts the other player, or connects to it. Returns -1 on failure.
+int open_socket (const Options& options)
+{
+	auto address = sockaddr_un { };
+	address.sun_family = AF_UNIX;
+	if (options.socket_path.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "The socket path is too long: " << options.socket_path << std::endl;
+		return -1;
+	}
+
+	std::strcpy(address.sun_path, options.socket_path.c_str());
+
+	const auto fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (-1 == fd)
+		return -1;
+
+	if (Mode::kJoin == options.mode)
+	{
+		if (0 == connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)))
+			return fd;
+
+		std::cerr << "Fail to connect to " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+		close(fd);
+		return -1;
+	}
+
+	unlink(options.socket_path.c_str());
+
+	if (-1 == bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) || -1 == listen(fd, 1))
+	{
+		std::cerr << "Fail to listen on " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+		close(fd);
+		return -1;
+	}
+
+	std::cout << "waiting for the other player on " << options.socket_path << std::endl;
+
+	const auto peer = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+	close(fd);
+	unlink(options.socket_path.c_str());
+
+	return peer;
+}
+
+// A player of one machine, pressing random keys of its paddle.
+template <typename Link>
+class Player
+{
+public:
+	Player (Link& link, uint32_t player, const Options& options)
+		:
+		machine_     (chip8::kPong.data(), chip8::kPong.size(), options.seed),
+		rollback_    (machine_, link, player, kCyclesPerFrame, options.max_rollback, options.delay),
+		random_      (player + 1u                                            ),
+		player_      (player                                                 ),
+		key_         (chip8::kNoKey                                          ),
+		resimulation_(0.001, 20000u                                          ),
+		stall_count_ (0u                                                     )
+	{
+	}
+
+	void advance ()
+	{
+		if (0 == random_() % kKeyPeriod)
+			key_ = 0 == random_() % 3 ? chip8::kNoKey : kPlayerKeys[player_][random_() % 2];
+
+		if (!rollback_.advance(key_))
+			++stall_count_;
+
+		record();
+	}
+
+	void synchronize ()
+	{
+		rollback_.synchronize();
+		record();
+	}
+
+	bool is_settled () const noexcept
+	{
+		return rollback_.get_confirmed_frame() >= rollback_.get_frame();
+	}
+
+	uint32_t get_frame () const noexcept
+	{
+		return rollback_.get_frame();
+	}
+
+	uint64_t get_state_hash () const noexcept
+	{
+		return machine_.get_state_hash();
+	}
+
+	void report () const
+	{
+		const auto resimulated = rollback_.get_resimulated_frame_count();
+		const auto total       = resimulation_.get_mean() * resimulation_.get_count();
+
+		std::cout << "player " << player_ + 1 << ": " << rollback_.get_frame() << " frames, " << stall_count_ << " stalled, "
+		          << rollback_.get_rollback_count() << " rollbacks, " << resimulated << " frames run again" << std::endl
+		          << "  resimulation a frame rolled back: mean " << resimulation_.get_mean() * 1000.0 << " us (p99 "
+		          << resimulation_.get_percentile(0.99) * 1000.0 << " us, max " << resimulation_.get_max() * 1000.0
+		          << " us), " << (resimulated ? total * 1000.0 / resimulated : 0.0) << " us a frame run again" << std::endl
+		          << "  state hash " << std::hex << get_state_hash() << std::dec << std::endl;
+	}
+
+private:
+	void record ()
+	{
+		if (0 != rollback_.get_last_resimulated_frames())
+			resimulation_.add(rollback_.get_last_resimulation_time() * 1000.0);
+	}
+
+private:
+	Machine                        machine_;
+	chip8::Rollback<Machine, Link> rollback_;
+	std::minstd_rand               random_;
+	uint32_t                       player_;
+	uint8_t                        key_;
+	utl::Histogram                 resimulation_; // In ms.
+	uint64_t                       stall_count_;
+};
+
+int run_loopback (const Options& options)
+{
+	auto links  = chip8::LoopbackLink::make_pair(options.latency);
+	auto first  = Player<chip8::LoopbackLink>(links.first,  0u, options);
+	auto second = Player<chip8::LoopbackLink>(links.second, 1u, options);
+
+	const auto begin = Clock::now();
+
+	while (first.get_frame() != options.frames || second.get_frame() != options.frames)
+	{
+		if (first.get_frame() != options.frames)
+			first.advance();
+		if (second.get_frame() != options.frames)
+			second.advance();
+	}
+
+	links.first.flush();
+	links.second.flush();
+	first.synchronize();
+	second.synchronize();
+
+	const auto seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+	first.report();
+	second.report();
+
+	std::cout << "latency " << options.latency << " frames, " << options.frames * 2 / seconds << " frames/s, "
+	          << (first.get_state_hash() == second.get_state_hash() ? "in step" : "OUT OF STEP") << std::endl;
+
+	return first.get_state_hash() == second.get_state_hash() ? 0 : 1;
+}
+
+int run_socket (const Options& options)
+{
+	const auto fd = open_socket(options);
+	if (-1 == fd)
+		return 1;
+
+	auto link   = SocketLink(fd);
+	auto player = Player<SocketLink>(link, Mode::kHost == options.mode ? 0u : 1u, options);
+
+	auto frame = Clock::now();
+	while (player.get_frame() != options.frames)
+	{
+		player.advance();
+
+		frame += kFramePeriod;
+		std::this_thread::sleep_until(frame);
+	}
+
+	const auto deadline = Clock::now() + kSettleTimeout;
+	while (player.synchronize(), !player.is_settled() && Clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	player.report();
+
+	if (!player.is_settled())
+	{
+		std::cerr << "The other player left before the last frame." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " (--host <socket path> | --join <socket path> | --loopback [--latency <frames>])" << std::endl
+		          << "       [--frames <count>] [--max-rollback <frames>] [--delay <frames>] [--seed <value>]" << std::endl;
+		return 1;
+	}
+
+	return Mode::kLoopback == options.mode ? run_loopback(options) : run_socket(options);
+}
@@ -0,0 +1,344 @@
+// Reads the frames a session exports into a shared memory ring (CHIP8_EXPORT of the demo).
+//
+// Polls the last frame published about 60 times a second and prints, once a second, the
+// frames read, the frames published in between that it didn't see, and the reads that
+// raced the writer. --show draws the screen on the terminal, writing at most --rate bytes
+// a second.
+//
+// With --trace it prints --count records of an instruction trace (e.g. of Chip8Bench
+// --trace) from the --from-th instead, a line each.
+//
+// With --movie it reads a movie (e.g. of the demo's CHIP8_MOVIE) instead: it plays --count
+// frames from the --from-th at 60 frames a second with --show, or prints them a line each,
+// and then reports how fast the movie decodes in order and at random frames.
+//
+// Usage: Chip8Peek <name> [--show] [--rate <bytes>]
+//        Chip8Peek --trace <path> [--from <index>] [--count <records>]
+//        Chip8Peek --movie <path> [--from <frame>] [--count <frames>] [--show] [--rate <bytes>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <csignal>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <chip-8/frame-ring.h>
+#include <chip-8/terminal-renderer.h>
+#include <chip-8/trace.h>
+#include <chip-8/movie.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kPollPeriod = std::chrono::microseconds(16667);
+
+// Movies play at the rate they're recorded at.
+constexpr auto kFramePeriod = std::chrono::microseconds(16667);
+
+constexpr auto kSeekCount = 1000u;
+
+struct Options
+{
+	std::string name;
+	bool        show  = false;
+	uint32_t    rate  = 16384u;
+	std::string trace_path;
+	std::string movie_path;
+	uint64_t    from  = 0u;
+	uint64_t    count = 0u;  // 32 records of a trace, or the rest of a movie.
+};
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void interrupt (int)
+{
+	interrupted = 1;
+}
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	if (argc < 2)
+		return false;
+
+	auto i = 1;
+	if (std::string(argv[1]).compare(0, 2, "--") != 0)
+		options.name = argv[i++];
+
+	for (; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (option == "--show")
+		{
+			options.show = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--rate")
+			options.rate = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--trace")
+			options.trace_path = value;
+		else if (option == "--movie")
+			options.movie_path = value;
+		else if (option == "--from")
+			options.from = std::strtoull(value, nullptr, 10);
+		else if (option == "--count")
+			options.count = std::strtoull(value, nullptr, 10);
+		else
+			return false;
+	}
+
+	// A ring, a trace or a movie.
+	return 1 == !options.name.empty() + !options.trace_path.empty() + !options.movie_path.empty();
+}
+
+int dump_trace (const Options& options)
+{
+	auto reader = chip8::TraceReader(options.trace_path);
+	if (!reader.is_open())
+	{
+		std::cerr << "Fail to open the trace " << options.trace_path << std::endl;
+		return 1;
+	}
+
+	std::cout << reader.size() << " records" << std::endl;
+
+	const auto count  = options.count ? options.count : 32u;
+	auto       record = chip8::TraceRecord();
+	for (auto i = options.from; i < reader.size() && i - options.from < count; ++i)
+	{
+		if (!reader.read(i, record))
+		{
+			std::cerr << "The trace is corrupt at record " << i << std::endl;
+			return 1;
+		}
+
+		char line[96];
+		auto size = std::snprintf(line, sizeof(line), "%10llu  %03X  %04X  I %03X  VF %02X",
+		                          static_cast<unsigned long long>(i), record.pc, record.opcode, record.i, record.flag);
+
+		if (chip8::kNoRegister != record.register_index)
+			size += std::snprintf(line + size, sizeof(line) - size, "  V%X=%02X", record.register_index, record.register_value);
+
+		if (0 != record.write_size)
+			std::snprintf(line + size, sizeof(line) - size, "  [%03X]=%02X (%u bytes)", record.write_address, record.write_value, record.write_size);
+
+		std::cout << line << std::endl;
+	}
+
+	return 0;
+}
+
+void write_out (const std::string& output)
+{
+	std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+	std::cout.flush();
+}
+
+uint32_t count_lit_pixels (const std::vector<uint8_t>& frame)
+{
+	auto count = 0u;
+	for (const auto byte : frame)
+	{
+		for (auto bits = byte; bits; bits &= bits - 1)
+			++count;
+	}
+
+	return count;
+}
+
+// Decodes every frame in order and then kSeekCount random ones, the way a player scrubs.
+bool measure_decoding (chip8::MovieReader& reader)
+{
+	auto begin = Clock::now();
+	for (auto i = uint64_t { 0 }; i != reader.get_frame_count(); ++i)
+	{
+		if (!reader.seek(i))
+		{
+			std::cerr << "The movie is corrupt at frame " << i << std::endl;
+			return false;
+		}
+	}
+
+	const auto in_order = std::chrono::duration<double>(Clock::now() - begin).count();
+
+	auto random = std::minstd_rand(1u);
+	auto frames = std::uniform_int_distribution<uint64_t>(0u, reader.get_frame_count() - 1);
+
+	begin = Clock::now();
+	for (auto i = 0u; i != kSeekCount; ++i)
+	{
+		if (!reader.seek(frames(random)))
+		{
+			std::cerr << "The movie is corrupt" << std::endl;
+			return false;
+		}
+	}
+
+	const auto at_random = std::chrono::duration<double>(Clock::now() - begin).count();
+
+	std::cout << "in order " << static_cast<uint64_t>(reader.get_frame_count() / in_order) << " frames/s, "
+	          << "at random " << static_cast<uint64_t>(kSeekCount / at_random) << " frames/s" << std::endl;
+
+	return true;
+}
+
+int play_movie (const Options& options)
+{
+	auto reader = chip8::MovieReader(options.movie_path);
+	if (!reader.is_open())
+	{
+		std::cerr << "Fail to open the movie " << options.movie_path << std::endl;
+		return 1;
+	}
+
+	std::cout << reader.get_frame_count() << " frames of " << reader.get_screen_width() << "x"
+	          << reader.get_screen_height() << ", " << reader.get_plane_count() << " planes" << std::endl;
+
+	if (0 == reader.get_frame_count())
+		return 0;
+
+	std::signal(SIGINT,  interrupt);
+	std::signal(SIGTERM, interrupt);
+
+	auto renderer = chip8::TerminalRenderer(reader.get_screen_width(), reader.get_screen_height(), reader.get_plane_count(), options.rate);
+	if (options.show)
+		write_out(chip8::TerminalRenderer::kEnter);
+
+	const auto end     = options.count ? std::min(options.from + options.count, reader.get_frame_count()) : reader.get_frame_count();
+	auto       present = Clock::now();
+	auto       corrupt = false;
+
+	for (auto i = options.from; i < end && !interrupted; ++i)
+	{
+		if (!reader.seek(i))
+		{
+			corrupt = true;
+			break;
+		}
+
+		if (options.show)
+		{
+			present += kFramePeriod;
+			std::this_thread::sleep_until(present);
+
+			write_out(renderer.render_frame(reader.get_frame().data()));
+			continue;
+		}
+
+		char line[64];
+		std::snprintf(line, sizeof(line), "%10llu  key %02X  sound %3u  %5u pixels",
+		              static_cast<unsigned long long>(i), reader.get_key(), reader.get_sound_timer(), count_lit_pixels(reader.get_frame()));
+		std::cout << line << std::endl;
+	}
+
+	if (options.show)
+		write_out(chip8::TerminalRenderer::kLeave);
+
+	if (corrupt)
+	{
+		std::cerr << "The movie is corrupt" << std::endl;
+		return 1;
+	}
+
+	return measure_decoding(reader) ? 0 : 1;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " <name> [--show] [--rate <bytes>]" << std::endl
+		          << "       " << argv[0] << " --trace <path> [--from <index>] [--count <records>]" << std::endl
+		          << "       " << argv[0] << " --movie <path> [--from <frame>] [--count <frames>] [--show] [--rate <bytes>]" << std::endl;
+		return 1;
+	}
+
+	if (!options.trace_path.empty())
+		return dump_trace(options);
+
+	if (!options.movie_path.empty())
+		return play_movie(options);
+
+	auto reader = chip8::FrameRingReader();
+	if (!reader.open(options.name))
+	{
+		std::cerr << "Fail to open the frame ring " << options.name << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT,  interrupt);
+	std::signal(SIGTERM, interrupt);
+
+	auto renderer = chip8::TerminalRenderer(reader.get_screen_width(), reader.get_screen_height(), reader.get_plane_count(), options.rate);
+	if (options.show)
+		write_out(chip8::TerminalRenderer::kEnter);
+
+	auto frame   = std::vector<uint8_t>(reader.get_frame_size());
+	auto last    = uint64_t { 0 };
+	auto frames  = uint64_t { 0 };
+	auto missed  = uint64_t { 0 };
+	auto retries = reader.get_retry_count();
+	auto seen    = false;
+	auto poll    = Clock::now();
+	auto report  = poll + std::chrono::seconds(1);
+
+	while (!interrupted)
+	{
+		poll += kPollPeriod;
+		std::this_thread::sleep_until(poll);
+
+		if (reader.read_latest(frame.data()) && (!seen || reader.get_frame_number() != last))
+		{
+			const auto number = reader.get_frame_number();
+			if (seen)
+				missed += number - last - 1;
+
+			last = number;
+			seen = true;
+			++frames;
+
+			if (options.show)
+				write_out(renderer.render_frame(frame.data()));
+		}
+
+		const auto now = Clock::now();
+		if (now >= report)
+		{
+			// Below the screen, where it doesn't scroll it.
+			if (options.show)
+				std::cout << "\x1b[" << renderer.get_line_count() + 1 << "H\x1b[K";
+
+			std::cout << "frame " << last << ", " << frames << " frames/s, " << missed << " missed, "
+			          << reader.get_retry_count() - retries << " retries";
+
+			if (options.show)
+				std::cout << std::flush;
+			else
+				std::cout << std::endl;
+
+			frames  = 0u;
+			missed  = 0u;
+			retries = reader.get_retry_count();
+			report  = now + std::chrono::seconds(1);
+		}
+	}
+
+	if (options.show)
+		write_out(chip8::TerminalRenderer::kLeave);
+
+	return 0;
+}
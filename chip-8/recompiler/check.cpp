@@ -0,0 +1,87 @@
+// Checks the recompiled Pong (Chip8RecompiledPong) against the interpreter.
+//
+// Boots both from the same ROM and seed, holds the same random keys in both, and compares
+// their state hashes after every frame. The recompiled code may run a frame past its
+// budget by the rest of a block, so the interpreter runs as many instructions as it did.
+// Exits with 2 at the first frame they differ.
+//
+// Usage: Chip8RecompilerCheck [--frames <count>] [--cycles <per frame>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <iostream>
+#include <recompiled/pong.h>
+
+namespace
+{
+
+struct Options
+{
+	uint32_t frames           = 20000u;
+	uint32_t cycles_per_frame = 10u;
+};
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--frames")
+			options.frames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--cycles")
+			options.cycles_per_frame = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+			return false;
+	}
+
+	return options.frames > 0 && options.cycles_per_frame > 0;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--frames <count>] [--cycles <per frame>]" << std::endl;
+		return 1;
+	}
+
+	auto pong       = chip8::recompiled::Pong();
+	auto recompiled = chip8::recompiled::Pong::boot();
+	recompiled.seed(0x1u);
+
+	auto interpreted = recompiled;
+	auto random      = std::minstd_rand(1u);
+	auto key         = chip8::kNoKey;
+
+	for (auto frame = 0u; frame != options.frames; ++frame)
+	{
+		if (0 == random() % 30)
+			key = 0 == random() % 3 ? chip8::kNoKey : static_cast<uint8_t>(random() % 0x10);
+
+		recompiled.set_key(key);
+		interpreted.set_key(key);
+
+		const auto executed = pong.run(recompiled, options.cycles_per_frame);
+		for (auto i = 0u; i != executed; ++i)
+			interpreted.instruction_cycle();
+
+		if (recompiled.get_state_hash() != interpreted.get_state_hash())
+		{
+			std::cerr << "The recompiled code differs from the interpreter at frame " << frame << std::endl;
+			return 2;
+		}
+	}
+
+	std::cout << options.frames << " frames match, state hash " << std::hex << recompiled.get_state_hash() << std::endl;
+
+	return 0;
+}
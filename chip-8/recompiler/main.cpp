@@ -0,0 +1,611 @@
+// Ahead-of-time recompiler for CHIP-8 ROMs.
+//
+// Walks the control flow of a ROM from kProgramMemoryOffset, splits the reachable code
+// into basic blocks and emits one straight-line C++ function per block. Every instruction
+// is emitted as Chip::execute with a constant opcode, so the compiler folds the decoding
+// and the result keeps the exact semantics of the interpreter. Blocks are entered through
+// a dispatcher switch on PC, which also serves 00EE and Bnnn, and anything that isn't
+// recompiled (unreached code, code overwritten at runtime) runs on the interpreter.
+//
+// Usage: Chip8Recompiler <rom> <class name> <chip-8|super-chip|xo-chip> <header> <source>
+
+#include <cstdint>
+#include <cstdio>
+#include <cctype>
+#include <map>
+#include <algorithm>
+#include <set>
+#include <deque>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <chip-8/chip-spec.h>
+#include <chip-8/rom-file.h>
+
+namespace
+{
+
+struct Block
+{
+	uint32_t              begin;
+	uint32_t              end;
+	std::vector<uint32_t> addresses;
+};
+
+class Program
+{
+public:
+	Program (std::vector<uint8_t> rom, chip8::OpcodeSet opcode_set)
+		:
+		rom_       (std::move(rom)),
+		opcode_set_(opcode_set    )
+	{
+	}
+
+	bool contains (uint32_t address) const noexcept
+	{
+		return address >= chip8::kProgramMemoryOffset &&
+			   address + 1 < chip8::kProgramMemoryOffset + rom_.size();
+	}
+
+	uint16_t fetch (uint32_t address) const
+	{
+		const auto offset = address - chip8::kProgramMemoryOffset;
+
+		return static_cast<uint16_t>(rom_[offset] << 8 | rom_[offset + 1]);
+	}
+
+	// The size of the instruction, XO-CHIP's F000 NNNN is four bytes long.
+	uint32_t length (uint32_t address) const
+	{
+		const auto long_i = opcode_set_ >= chip8::OpcodeSet::kXoChip && fetch(address) == 0xF000;
+
+		return long_i ? 4 : 2;
+	}
+
+	const std::vector<uint8_t>& rom () const noexcept
+	{
+		return rom_;
+	}
+
+	chip8::OpcodeSet opcode_set () const noexcept
+	{
+		return opcode_set_;
+	}
+
+private:
+	std::vector<uint8_t> rom_;
+	chip8::OpcodeSet     opcode_set_;
+};
+
+bool is_skip (uint16_t opcode)
+{
+	switch (opcode & 0xF000)
+	{
+	case 0x3000:
+	case 0x4000:
+		return true;
+
+	case 0x5000:
+	case 0x9000:
+		return (opcode & 0x000F) == 0;
+
+	case 0xE000:
+		return (opcode & 0x00FF) == 0x009E || (opcode & 0x00FF) == 0x00A1;
+
+	default:
+		return false;
+	}
+}
+
+// Returns false if the interpreter faults on the opcode in the opcode set.
+bool is_known (uint16_t opcode, chip8::OpcodeSet opcode_set)
+{
+	const auto super_chip = opcode_set >= chip8::OpcodeSet::kSuperChip;
+	const auto xo_chip    = opcode_set >= chip8::OpcodeSet::kXoChip;
+
+	switch (opcode & 0xF000)
+	{
+	case 0x0000:
+		switch (opcode & 0x00FF)
+		{
+		case 0x00E0:
+		case 0x00EE:
+			return true;
+
+		case 0x00FB:
+		case 0x00FC:
+		case 0x00FD:
+		case 0x00FE:
+		case 0x00FF:
+			return super_chip;
+
+		default:
+			return (super_chip && (opcode & 0xFFF0) == 0x00C0) ||
+				   (xo_chip    && (opcode & 0xFFF0) == 0x00D0);
+		}
+
+	case 0x5000:
+		return (opcode & 0x000F) == 0 || (xo_chip && ((opcode & 0x000F) == 0x2 || (opcode & 0x000F) == 0x3));
+
+	case 0x8000:
+		return (opcode & 0x000F) <= 0x7 || (opcode & 0x000F) == 0xE;
+
+	case 0xE000:
+		return (opcode & 0x00FF) == 0x009E || (opcode & 0x00FF) == 0x00A1;
+
+	case 0xF000:
+		switch (opcode & 0x00FF)
+		{
+		case 0x0007:
+		case 0x000A:
+		case 0x0015:
+		case 0x0018:
+		case 0x001E:
+		case 0x0029:
+		case 0x0033:
+		case 0x0055:
+		case 0x0065:
+			return true;
+
+		case 0x0030:
+		case 0x0075:
+		case 0x0085:
+			return super_chip;
+
+		case 0x0000:
+			return xo_chip && opcode == 0xF000;
+
+		case 0x0001:
+		case 0x0002:
+		case 0x003A:
+			return xo_chip;
+
+		default:
+			return false;
+		}
+
+	default:
+		return true;
+	}
+}
+
+// Ends a basic block, the successors are computed by successors().
+bool is_terminator (uint16_t opcode)
+{
+	return (opcode & 0xF000) == 0x1000 ||
+		   (opcode & 0xF000) == 0x2000 ||
+		   (opcode & 0xF000) == 0xB000 ||
+		   (opcode & 0xF0FF) == 0xF00A ||
+		   opcode == 0x00EE            ||
+		   opcode == 0x00FD            ||
+		   is_skip(opcode);
+}
+
+// The number of bytes written at I, zero if the opcode doesn't write memory.
+uint32_t store_size (uint16_t opcode, chip8::OpcodeSet opcode_set)
+{
+	const auto x = (opcode & 0x0F00) >> 8;
+	const auto y = (opcode & 0x00F0) >> 4;
+
+	if ((opcode & 0xF0FF) == 0xF033)
+		return 3;
+
+	if ((opcode & 0xF0FF) == 0xF055)
+		return x + 1;
+
+	if (opcode_set >= chip8::OpcodeSet::kXoChip && (opcode & 0xF00F) == 0x5002)
+		return (x > y ? x - y : y - x) + 1;
+
+	return 0;
+}
+
+std::vector<uint32_t> successors (const Program& program, uint32_t address)
+{
+	const auto opcode = program.fetch(address);
+	const auto next   = address + program.length(address);
+
+	if (is_skip(opcode))
+		return { next, program.contains(next) ? next + program.length(next) : next + 2 };
+
+	switch (opcode & 0xF000)
+	{
+	case 0x1000:
+		return { opcode & 0x0FFFu };
+
+	case 0x2000:
+		return { opcode & 0x0FFFu, next };
+
+	case 0xB000:
+		return { };
+
+	default:
+		break;
+	}
+
+	if (opcode == 0x00EE || opcode == 0x00FD)
+		return { };
+
+	return { next };
+}
+
+std::vector<Block> find_blocks (const Program& program)
+{
+	// Finds the reachable instructions and the block leaders.
+	auto leaders   = std::set<uint32_t> { chip8::kProgramMemoryOffset };
+	auto reachable = std::set<uint32_t> { };
+	auto worklist  = std::deque<uint32_t> { chip8::kProgramMemoryOffset };
+
+	while (!worklist.empty())
+	{
+		const auto address = worklist.front();
+		worklist.pop_front();
+
+		if (!program.contains(address) || !reachable.insert(address).second)
+			continue;
+
+		const auto opcode = program.fetch(address);
+		const auto next   = successors(program, address);
+
+		if (is_terminator(opcode))
+			leaders.insert(std::begin(next), std::end(next));
+
+		std::copy(std::begin(next), std::end(next), std::back_inserter(worklist));
+	}
+
+	// Splits the reachable instructions at the leaders and after the terminators.
+	auto blocks = std::vector<Block>();
+
+	for (const auto leader : leaders)
+	{
+		if (0 == reachable.count(leader))
+			continue;
+
+		auto block = Block { leader, leader, { } };
+		for (auto address = leader; ; )
+		{
+			block.addresses.push_back(address);
+			block.end = address + program.length(address);
+
+			if (is_terminator(program.fetch(address)))
+				break;
+
+			address = block.end;
+			if (0 != leaders.count(address) || 0 == reachable.count(address))
+				break;
+		}
+
+		blocks.push_back(block);
+	}
+
+	return blocks;
+}
+
+const char* spec_name (chip8::OpcodeSet opcode_set)
+{
+	switch (opcode_set)
+	{
+	case chip8::OpcodeSet::kChip8:
+		return "Chip8Spec";
+
+	case chip8::OpcodeSet::kSuperChip:
+		return "SuperChipSpec";
+
+	default:
+		return "XoChipSpec";
+	}
+}
+
+// Returns true if the block stores to memory, so it may overwrite code.
+bool has_stores (const Block& block, const Program& program)
+{
+	for (const auto address : block.addresses)
+	{
+		const auto opcode = program.fetch(address);
+		if (!is_known(opcode, program.opcode_set()))
+			break;
+
+		if (0 != store_size(opcode, program.opcode_set()))
+			return true;
+	}
+
+	return false;
+}
+
+std::string hex (uint32_t value, int digits)
+{
+	char buffer[16];
+	std::snprintf(buffer, sizeof(buffer), "0x%0*X", digits, value);
+
+	return buffer;
+}
+
+std::string file_name (const std::string& path)
+{
+	const auto separator = path.find_last_of("/\\");
+
+	return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+void emit_header (std::ostream& os, const std::string& class_name, const Program& program, size_t block_count)
+{
+	auto guard = "RECOMPILED_" + class_name + "_H";
+	std::transform(std::begin(guard), std::end(guard), std::begin(guard), [](unsigned char c) { return std::toupper(c); });
+
+	os << "// Generated by Chip8Recompiler, do not edit.\n"
+	   << "\n"
+	   << "#ifndef " << guard << "\n"
+	   << "#define " << guard << "\n"
+	   << "\n"
+	   << "#include <array>\n"
+	   << "#include <chip-8/chip.hpp>\n"
+	   << "\n"
+	   << "namespace chip8::recompiled\n"
+	   << "{\n"
+	   << "\n"
+	   << "class " << class_name << "\n"
+	   << "{\n"
+	   << "public:\n"
+	   << "\tusing Machine = Chip<" << spec_name(program.opcode_set()) << ">;\n"
+	   << "\n"
+	   << "\tstatic constexpr auto kBlockCount = " << block_count << "u;\n"
+	   << "\n"
+	   << "\t" << class_name << " ();\n"
+	   << "\n"
+	   << "\t// Returns a machine with the ROM loaded.\n"
+	   << "\tstatic Machine boot ();\n"
+	   << "\n"
+	   << "\t// Runs at least budget instructions (or until the machine halts) and returns how many ran.\n"
+	   << "\t// It may run past the budget by the rest of the last block.\n"
+	   << "\tuint32_t run (Machine& chip, uint32_t budget);\n"
+	   << "\n"
+	   << "private:\n"
+	   << "\tstd::array<bool, kBlockCount> valid_;\n"
+	   << "};\n"
+	   << "\n"
+	   << "}  // namespace chip8::recompiled\n"
+	   << "\n"
+	   << "#endif  // " << guard << "\n";
+}
+
+void emit_source (std::ostream& os, const std::string& class_name, const std::string& header,
+	              const Program& program, const std::vector<Block>& blocks)
+{
+	auto code_begin = blocks.front().begin;
+	auto code_end   = blocks.front().end;
+	for (const auto& block : blocks)
+	{
+		code_begin = std::min(code_begin, block.begin);
+		code_end   = std::max(code_end,   block.end  );
+	}
+
+	os << "// Generated by Chip8Recompiler, do not edit.\n"
+	   << "\n"
+	   << "#include \"" << file_name(header) << "\"\n"
+	   << "\n"
+	   << "namespace chip8::recompiled\n"
+	   << "{\n"
+	   << "\n"
+	   << "namespace\n"
+	   << "{\n"
+	   << "\n"
+	   << "using Machine = " << class_name << "::Machine;\n"
+	   << "using Valid   = std::array<bool, " << class_name << "::kBlockCount>;\n"
+	   << "\n";
+
+	// The ROM image.
+	os << "constexpr uint8_t kRom[] =\n"
+	   << "{";
+	for (auto i = 0u; i != program.rom().size(); ++i)
+	{
+		os << ((i % 12 == 0) ? "\n\t" : " ") << hex(program.rom()[i], 2) << ",";
+	}
+	os << "\n};\n\n";
+
+	// The address range of every block, used to drop the blocks overwritten at runtime.
+	os << "constexpr uint32_t kBlockRanges[][2] =\n"
+	   << "{\n";
+	for (const auto& block : blocks)
+	{
+		os << "\t{ " << hex(block.begin, 3) << ", " << hex(block.end, 3) << " },\n";
+	}
+	os << "};\n\n";
+
+	os << "// Invalidates the blocks overlapping [address, address + size), returns true if any code was hit.\n"
+	   << "bool invalidate (Valid& valid, uint32_t address, uint32_t size)\n"
+	   << "{\n"
+	   << "\tif (address >= " << hex(code_end, 3) << " || address + size <= " << hex(code_begin, 3) << ")\n"
+	   << "\t\treturn false;\n"
+	   << "\n"
+	   << "\tauto hit = false;\n"
+	   << "\tfor (auto i = 0u; i != valid.size(); ++i)\n"
+	   << "\t{\n"
+	   << "\t\tif (address < kBlockRanges[i][1] && address + size > kBlockRanges[i][0])\n"
+	   << "\t\t{\n"
+	   << "\t\t\tvalid[i] = false;\n"
+	   << "\t\t\thit      = true;\n"
+	   << "\t\t}\n"
+	   << "\t}\n"
+	   << "\n"
+	   << "\treturn hit;\n"
+	   << "}\n"
+	   << "\n";
+
+	os << "uint32_t store_size (uint16_t opcode)\n"
+	   << "{\n"
+	   << "\tconst auto x = (opcode & 0x0F00) >> 8;\n"
+	   << "\n"
+	   << "\tif ((opcode & 0xF0FF) == 0xF033)\n"
+	   << "\t\treturn 3;\n"
+	   << "\n"
+	   << "\tif ((opcode & 0xF0FF) == 0xF055)\n"
+	   << "\t\treturn x + 1;\n";
+	if (program.opcode_set() >= chip8::OpcodeSet::kXoChip)
+	{
+		os << "\n"
+		   << "\tif ((opcode & 0xF00F) == 0x5002)\n"
+		   << "\t{\n"
+		   << "\t\tconst auto y = (opcode & 0x00F0) >> 4;\n"
+		   << "\t\treturn (x > y ? x - y : y - x) + 1;\n"
+		   << "\t}\n";
+	}
+	os << "\n"
+	   << "\treturn 0;\n"
+	   << "}\n"
+	   << "\n";
+
+	os << "uint32_t interpret (Machine& chip, Valid& valid)\n"
+	   << "{\n"
+	   << "\tconst auto opcode  = chip.fetch();\n"
+	   << "\tconst auto address = chip.get_i();\n"
+	   << "\n"
+	   << "\tchip.instruction_cycle();\n"
+	   << "\n"
+	   << "\tif (const auto size = store_size(opcode))\n"
+	   << "\t\tinvalidate(valid, address, size);\n"
+	   << "\n"
+	   << "\treturn 1;\n"
+	   << "}\n"
+	   << "\n";
+
+	// The blocks.
+	for (const auto& block : blocks)
+	{
+		// A block without stores never invalidates, so it leaves the table unnamed.
+		os << "uint32_t block_" << hex(block.begin, 3) << " (Machine& chip, Valid&" << (has_stores(block, program) ? " valid" : "") << ")\n"
+		   << "{\n";
+
+		auto count = 0u;
+		for (const auto address : block.addresses)
+		{
+			const auto opcode = program.fetch(address);
+			const auto size   = store_size(opcode, program.opcode_set());
+			++count;
+
+			if (!is_known(opcode, program.opcode_set()))
+			{
+				// The machine faults here, so nothing after it may run.
+				os << "\tchip.execute(" << hex(opcode, 4) << ");  // " << hex(address, 3) << "\n";
+				break;
+			}
+
+			if (0 == size)
+			{
+				os << "\tchip.execute(" << hex(opcode, 4) << ");  // " << hex(address, 3) << "\n";
+				continue;
+			}
+
+			// Stops as soon as the block overwrites code, the dispatcher takes over from there.
+			os << "\t{\n"
+			   << "\t\tconst auto address = chip.get_i();\n"
+			   << "\t\tchip.execute(" << hex(opcode, 4) << ");  // " << hex(address, 3) << "\n"
+			   << "\t\tif (invalidate(valid, address, " << size << "))\n"
+			   << "\t\t\treturn " << count << ";\n"
+			   << "\t}\n";
+		}
+
+		os << "\treturn " << count << ";\n"
+		   << "}\n"
+		   << "\n";
+	}
+
+	os << "}  // namespace\n"
+	   << "\n";
+
+	os << class_name << "::" << class_name << " ()\n"
+	   << "{\n"
+	   << "\tvalid_.fill(true);\n"
+	   << "}\n"
+	   << "\n";
+
+	os << class_name << "::Machine " << class_name << "::boot ()\n"
+	   << "{\n"
+	   << "\treturn Machine(kRom, sizeof(kRom));\n"
+	   << "}\n"
+	   << "\n";
+
+	os << "uint32_t " << class_name << "::run (Machine& chip, uint32_t budget)\n"
+	   << "{\n"
+	   << "\tauto executed = 0u;\n"
+	   << "\n"
+	   << "\twhile (executed < budget && !chip.is_halted())\n"
+	   << "\t{\n"
+	   << "\t\tswitch (chip.get_pc())\n"
+	   << "\t\t{\n";
+	for (auto i = 0u; i != blocks.size(); ++i)
+	{
+		os << "\t\tcase " << hex(blocks[i].begin, 3) << ":\n"
+		   << "\t\t\tif (valid_[" << i << "])\n"
+		   << "\t\t\t{\n"
+		   << "\t\t\t\texecuted += block_" << hex(blocks[i].begin, 3) << "(chip, valid_);\n"
+		   << "\t\t\t\tcontinue;\n"
+		   << "\t\t\t}\n"
+		   << "\t\t\tbreak;\n"
+		   << "\n";
+	}
+	os << "\t\tdefault:\n"
+	   << "\t\t\tbreak;\n"
+	   << "\t\t}\n"
+	   << "\n"
+	   << "\t\texecuted += interpret(chip, valid_);\n"
+	   << "\t}\n"
+	   << "\n"
+	   << "\treturn executed;\n"
+	   << "}\n"
+	   << "\n"
+	   << "}  // namespace chip8::recompiled\n";
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	if (argc != 6)
+	{
+		std::cerr << "Usage: " << argv[0] << " <rom> <class name> <chip-8|super-chip|xo-chip> <header> <source>" << std::endl;
+		return 1;
+	}
+
+	// The opcode set and the biggest ROM the memory of each variant takes.
+	const auto variants = std::map<std::string, std::pair<chip8::OpcodeSet, uint32_t>>
+	{
+		{ "chip-8",     { chip8::OpcodeSet::kChip8,     chip8::get_max_rom_size<chip8::Chip8Spec>()     } },
+		{ "super-chip", { chip8::OpcodeSet::kSuperChip, chip8::get_max_rom_size<chip8::SuperChipSpec>() } },
+		{ "xo-chip",    { chip8::OpcodeSet::kXoChip,    chip8::get_max_rom_size<chip8::XoChipSpec>()    } }
+	};
+
+	const auto variant = variants.find(argv[3]);
+	if (variant == std::end(variants))
+	{
+		std::cerr << "Unknown variant: " << argv[3] << std::endl;
+		return 1;
+	}
+
+	auto       rom   = std::vector<uint8_t>();
+	const auto error = chip8::load_rom(argv[1], sizeof(uint16_t), variant->second.second, rom);
+	if (chip8::RomError::kNone != error)
+	{
+		std::cerr << chip8::get_message(error) << ": " << argv[1] << std::endl;
+		return 1;
+	}
+
+	const auto program = Program(std::move(rom), variant->second.first);
+	const auto blocks  = find_blocks(program);
+
+	auto header = std::ofstream(argv[4]);
+	auto source = std::ofstream(argv[5]);
+	if (!header || !source)
+	{
+		std::cerr << "Fail to open the outputs!!!" << std::endl;
+		return 1;
+	}
+
+	emit_header(header, argv[2], program, blocks.size());
+	emit_source(source, argv[2], argv[4], program, blocks);
+
+	return 0;
+}
@@ -0,0 +1,654 @@
+// Hosts emulator sessions for local viewers and input clients.
+//
+// One thread runs every session on an epoll loop: the frame scheduler's timerfd steps all
+// sessions once a frame, clients attach to a session over a Unix stream socket, send keys
+// and receive the frames as deltas (see <chip-8/session-protocol.h>).
+//
+// A client whose last frame isn't written out yet is skipped, so a slow client drops the
+// frames in between, and once it drains it gets the latest frame as a delta against the
+// last one it received. The clients that are up to date share one encoding a session.
+//
+// Usage: Chip8Server <socket path> [--sessions <count>] [--rom <path>] [--cycles <per frame>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <platform/frame-scheduler.h>
+#include <chip-8/chip.hpp>
+#include <chip-8/frame-delta.h>
+#include <chip-8/session-protocol.h>
+#include <chip-8/rom-file.h>
+
+namespace
+{
+
+using Spec    = chip8::Chip8Spec;
+using Machine = chip8::Chip<Spec>;
+using Packed  = chip8::PackedFrame<Spec>;
+using Frame   = std::array<uint8_t, Packed::kSize>;
+
+constexpr auto kNoSession   = ~0u;
+constexpr auto kMaxEvents   = 64;
+constexpr auto kReadSize    = 4096u;
+constexpr auto kStatsPeriod = 600u; // frames
+
+// The kernel buffers little for a client, so a slow one drops frames instead of seeing
+// them late.
+constexpr auto kSendBufferSize = 16384;
+
+struct Options
+{
+	std::string socket_path;
+	uint32_t    session_count    = 1u;
+	std::string rom_path;
+	uint32_t    cycles_per_frame = 10u;
+};
+
+struct Session
+{
+	explicit Session (const Machine::Image& image)
+		:
+		chip           (image),
+		previous       (     ),
+		current        (     ),
+		previous_number(0u   ),
+		number         (0u   ),
+		delta          (     ),
+		clients        (     )
+	{
+		previous.fill(0u);
+		current .fill(0u);
+	}
+
+	Machine              chip;
+	Frame                previous;
+	Frame                current;
+	uint32_t             previous_number;
+	uint32_t             number;
+	std::vector<uint8_t> delta;   // The frame message from previous to current.
+	std::vector<int>     clients;
+};
+
+struct Client
+{
+	explicit Client (int fd)
+		:
+		fd         (fd        ),
+		session    (kNoSession),
+		input      (          ),
+		output     (          ),
+		written    (0u        ),
+		sent       (          ),
+		sent_number(0u        ),
+		keyframe   (true      ),
+		writing    (false     ),
+		closed     (false     )
+	{
+		sent.fill(0u);
+	}
+
+	int                  fd;
+	uint32_t             session;
+	std::vector<uint8_t> input;
+	std::vector<uint8_t> output;
+	size_t               written;
+	Frame                sent;        // The frame the client has, after output is written.
+	uint32_t             sent_number;
+	bool                 keyframe;    // Nothing was sent yet.
+	bool                 writing;     // Waiting for EPOLLOUT.
+	bool                 closed;      // Disconnected after the events of the batch.
+};
+
+struct Stats
+{
+	uint64_t frames_sent    = 0u;
+	uint64_t frames_shared  = 0u;
+	uint64_t frames_dropped = 0u;
+	uint64_t bytes_sent     = 0u;
+	double   step_ns        = 0.0;
+};
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	if (argc < 2)
+		return false;
+
+	options.socket_path = argv[1];
+	for (auto i = 2; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--sessions")
+			options.session_count = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--rom")
+			options.rom_path = value;
+		else if (option == "--cycles")
+			options.cycles_per_frame = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+			return false;
+	}
+
+	return options.session_count > 0 && options.session_count <= 0xFFFF && options.cycles_per_frame > 0;
+}
+
+// Appends a frame message of the delta from previous to current, or returns false if
+// they're equal.
+bool append_frame (std::vector<uint8_t>& out, uint16_t session, uint32_t number, const Frame& previous, const Frame& current, bool keyframe)
+{
+	const auto begin = out.size();
+
+	out.resize(begin + sizeof(chip8::MessageHeader) + sizeof(number));
+	std::memcpy(out.data() + begin + sizeof(chip8::MessageHeader), &number, sizeof(number));
+
+	const auto changed = chip8::encode_delta(previous.data(), current.data(), Packed::kRowSize, Packed::kRowCount, out);
+	if (0 == changed && !keyframe)
+	{
+		out.resize(begin);
+		return false;
+	}
+
+	const auto header = chip8::MessageHeader
+	{
+		static_cast<uint32_t>(out.size() - begin - sizeof(chip8::MessageHeader)),
+		static_cast<uint8_t>(chip8::MessageType::kFrame),
+		keyframe ? chip8::kKeyframe : uint8_t { 0 },
+		session
+	};
+	std::memcpy(out.data() + begin, &header, sizeof(header));
+
+	return true;
+}
+
+class Server
+{
+public:
+	Server (const Options& options, const Machine::Image& image)
+		:
+		options_  (options),
+		sessions_ (       ),
+		clients_  (       ),
+		scheduler_(       ),
+		epoll_fd_ (-1     ),
+		listen_fd_(-1     ),
+		signal_fd_(-1     ),
+		blank_    (       ),
+		closing_  (       ),
+		stats_    (       )
+	{
+		blank_.fill(0u);
+
+		for (auto i = 0u; i != options.session_count; ++i)
+			sessions_.push_back(std::make_unique<Session>(image));
+	}
+
+	~Server ()
+	{
+		for (auto& client : clients_)
+			close(client.first);
+
+		if (-1 != listen_fd_)
+		{
+			close(listen_fd_);
+			unlink(options_.socket_path.c_str());
+		}
+
+		if (-1 != signal_fd_)
+			close(signal_fd_);
+
+		if (-1 != epoll_fd_)
+			close(epoll_fd_);
+	}
+
+	bool open ()
+	{
+		epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+		if (-1 == epoll_fd_)
+			return fail("epoll_create1");
+
+		// SIGINT and SIGTERM end the loop, so the socket file is removed.
+		auto signals = sigset_t();
+		sigemptyset(&signals);
+		sigaddset(&signals, SIGINT);
+		sigaddset(&signals, SIGTERM);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		std::signal(SIGPIPE, SIG_IGN);
+
+		signal_fd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+		if (-1 == signal_fd_)
+			return fail("signalfd");
+
+		listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (-1 == listen_fd_)
+			return fail("socket");
+
+		auto address = sockaddr_un { };
+		address.sun_family = AF_UNIX;
+		if (options_.socket_path.size() >= sizeof(address.sun_path))
+		{
+			std::cerr << "The socket path is too long: " << options_.socket_path << std::endl;
+			return false;
+		}
+		std::strcpy(address.sun_path, options_.socket_path.c_str());
+
+		unlink(options_.socket_path.c_str());
+		if (-1 == bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)))
+			return fail("bind");
+
+		if (-1 == listen(listen_fd_, SOMAXCONN))
+			return fail("listen");
+
+		return watch(listen_fd_, EPOLLIN) && watch(signal_fd_, EPOLLIN) && watch(scheduler_.get_timer_fd(), EPOLLIN);
+	}
+
+	void run ()
+	{
+		auto events = std::array<epoll_event, kMaxEvents>();
+		for (;;)
+		{
+			const auto count = epoll_wait(epoll_fd_, events.data(), kMaxEvents, -1);
+			if (-1 == count)
+			{
+				if (EINTR == errno)
+					continue;
+
+				fail("epoll_wait");
+				return;
+			}
+
+			for (auto i = 0; i != count; ++i)
+			{
+				const auto fd = events[i].data.fd;
+
+				if (fd == signal_fd_)
+					return;
+				else if (fd == listen_fd_)
+					accept_clients();
+				else if (fd == scheduler_.get_timer_fd())
+					step(scheduler_.wait());
+				else
+					serve(fd, events[i].events);
+			}
+
+			// Only after the batch, so an accepted client can't get the fd of one closed in
+			// it and the events left for that one.
+			for (const auto closing : closing_)
+				disconnect(closing);
+			closing_.clear();
+		}
+	}
+
+private:
+	bool fail (const char* what) const
+	{
+		std::cerr << what << " failed: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	bool watch (int fd, uint32_t events)
+	{
+		auto event = epoll_event { };
+		event.events  = events;
+		event.data.fd = fd;
+
+		return 0 == epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) || fail("epoll_ctl");
+	}
+
+	void accept_clients ()
+	{
+		for (;;)
+		{
+			const auto fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (-1 == fd)
+				return;
+
+			setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSendBufferSize, sizeof(kSendBufferSize));
+
+			if (!watch(fd, EPOLLIN))
+			{
+				close(fd);
+				continue;
+			}
+
+			clients_.emplace(fd, std::make_unique<Client>(fd));
+		}
+	}
+
+	// Runs the due frames of every session and sends the last one.
+	void step (uint32_t frames)
+	{
+		if (0 == frames)
+			return;
+
+		const auto begin = std::chrono::steady_clock::now();
+
+		for (auto& session_ptr : sessions_)
+		{
+			auto& session = *session_ptr;
+
+			for (auto i = 0u; i != frames; ++i)
+				session.chip.run_frame(options_.cycles_per_frame);
+
+			session.previous        = session.current;
+			session.previous_number = session.number;
+			session.number         += frames;
+			Packed::pack(session.chip.get_vram().data(), session.current.data());
+
+			session.delta.clear();
+			if (session.clients.empty())
+				continue;
+
+			const auto index = static_cast<uint16_t>(&session_ptr - sessions_.data());
+			append_frame(session.delta, index, session.number, session.previous, session.current, false);
+
+			for (const auto fd : session.clients)
+			{
+				auto& client = *clients_.at(fd);
+
+				if (client.written != client.output.size())
+					++stats_.frames_dropped;
+				else
+					send_frame(client);
+			}
+		}
+
+		stats_.step_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+		const auto frame_count = scheduler_.get_frame_count();
+		if (frame_count / kStatsPeriod != (frame_count - frames) / kStatsPeriod)
+			print_stats();
+	}
+
+	// Sends the latest frame of the client's session. Its last one must be written out.
+	void send_frame (Client& client)
+	{
+		const auto& session = *sessions_[client.session];
+
+		if (client.closed || (!client.keyframe && client.sent_number == session.number))
+			return;
+
+		client.output.clear();
+		client.written = 0u;
+
+		// Up to date with the frame before, so the shared delta applies.
+		const auto shared = !client.keyframe && client.sent_number == session.previous_number;
+		if (shared)
+		{
+			client.output = session.delta;
+		}
+		else
+		{
+			const auto& base = client.keyframe ? blank_ : client.sent;
+			append_frame(client.output, static_cast<uint16_t>(client.session), session.number, base, session.current, client.keyframe);
+		}
+
+		client.sent        = session.current;
+		client.sent_number = session.number;
+		client.keyframe    = false;
+
+		if (client.output.empty())
+			return;
+
+		++stats_.frames_sent;
+		if (shared)
+			++stats_.frames_shared;
+
+		flush(client);
+	}
+
+	void flush (Client& client)
+	{
+		while (client.written != client.output.size())
+		{
+			const auto result = ::send(client.fd, client.output.data() + client.written, client.output.size() - client.written, MSG_NOSIGNAL);
+			if (-1 == result)
+			{
+				if (EAGAIN != errno && EWOULDBLOCK != errno)
+					close_later(client);
+				else
+					set_writing(client, true);
+
+				return;
+			}
+
+			client.written    += static_cast<size_t>(result);
+			stats_.bytes_sent += static_cast<uint64_t>(result);
+		}
+
+		set_writing(client, false);
+	}
+
+	void set_writing (Client& client, bool writing)
+	{
+		if (client.writing == writing)
+			return;
+
+		auto event = epoll_event { };
+		event.events  = EPOLLIN | (writing ? EPOLLOUT : 0u);
+		event.data.fd = client.fd;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &event);
+
+		client.writing = writing;
+	}
+
+	void serve (int fd, uint32_t events)
+	{
+		const auto found = clients_.find(fd);
+		if (found == clients_.end())
+			return;
+
+		auto& client = *found->second;
+		if (client.closed)
+			return;
+
+		if (events & (EPOLLERR | EPOLLHUP))
+		{
+			close_later(client);
+			return;
+		}
+
+		if (events & EPOLLOUT)
+		{
+			flush(client);
+
+			// Drained, so it catches up to the latest frame at once.
+			if (client.written == client.output.size() && kNoSession != client.session)
+				send_frame(client);
+		}
+
+		if (events & EPOLLIN)
+			receive(client);
+	}
+
+	void receive (Client& client)
+	{
+		auto buffer = std::array<uint8_t, kReadSize>();
+		for (;;)
+		{
+			const auto result = ::recv(client.fd, buffer.data(), buffer.size(), 0);
+			if (0 == result || (-1 == result && EAGAIN != errno && EWOULDBLOCK != errno))
+			{
+				close_later(client);
+				return;
+			}
+
+			if (-1 == result)
+				break;
+
+			client.input.insert(client.input.end(), buffer.data(), buffer.data() + result);
+		}
+
+		auto offset = size_t { 0 };
+		while (!client.closed && client.input.size() - offset >= sizeof(chip8::MessageHeader))
+		{
+			auto header = chip8::MessageHeader();
+			std::memcpy(&header, client.input.data() + offset, sizeof(header));
+
+			if (header.size > chip8::kMaxClientPayloadSize || header.session >= sessions_.size())
+			{
+				close_later(client);
+				return;
+			}
+
+			if (client.input.size() - offset < sizeof(header) + header.size)
+				break;
+
+			const auto payload = client.input.data() + offset + sizeof(header);
+			offset += sizeof(header) + header.size;
+
+			if (!handle(client, header, payload))
+			{
+				close_later(client);
+				return;
+			}
+		}
+
+		client.input.erase(client.input.begin(), client.input.begin() + offset);
+	}
+
+	bool handle (Client& client, const chip8::MessageHeader& header, const uint8_t* payload)
+	{
+		switch (static_cast<chip8::MessageType>(header.type))
+		{
+		case chip8::MessageType::kAttach:
+			detach(client);
+
+			client.session     = header.session;
+			client.keyframe    = true;
+			client.sent_number = 0u;
+			sessions_[client.session]->clients.push_back(client.fd);
+
+			if (client.written == client.output.size())
+				send_frame(client);
+			return true;
+
+		case chip8::MessageType::kKey:
+		{
+			// Keys go to the session the client attached to, the header's is ignored.
+			if (1 != header.size || kNoSession == client.session)
+				return false;
+
+			const auto key = payload[0];
+			if (key >= 0x10 && key != chip8::kNoKey)
+				return false;
+
+			sessions_[client.session]->chip.set_key(key);
+			return true;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	void detach (Client& client)
+	{
+		if (kNoSession == client.session)
+			return;
+
+		auto& clients = sessions_[client.session]->clients;
+		clients.erase(std::remove(clients.begin(), clients.end(), client.fd), clients.end());
+
+		client.session = kNoSession;
+	}
+
+	// Closing right away would free the client under its callers.
+	void close_later (Client& client)
+	{
+		if (client.closed)
+			return;
+
+		client.closed = true;
+		closing_.push_back(client.fd);
+	}
+
+	void disconnect (int fd)
+	{
+		const auto found = clients_.find(fd);
+		if (found == clients_.end())
+			return;
+
+		detach(*found->second);
+
+		epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+		close(fd);
+
+		clients_.erase(found);
+	}
+
+	void print_stats ()
+	{
+		std::cout << "sessions "        << sessions_.size()
+		          << ", clients "       << clients_.size()
+		          << ", step "          << stats_.step_ns / kStatsPeriod / 1000.0 << " us"
+		          << ", sent "          << stats_.frames_sent
+		          << " (shared "        << stats_.frames_shared << ")"
+		          << ", dropped "       << stats_.frames_dropped
+		          << ", bytes/frame "   << (stats_.frames_sent ? stats_.bytes_sent / static_cast<double>(stats_.frames_sent) : 0.0)
+		          << ", late frames "   << scheduler_.get_dropped_frame_count()
+		          << std::endl;
+
+		stats_ = Stats();
+	}
+
+private:
+	Options                                          options_;
+	std::vector<std::unique_ptr<Session>>            sessions_;
+	std::unordered_map<int, std::unique_ptr<Client>> clients_;
+	plt::FrameScheduler                              scheduler_;
+	int                                              epoll_fd_;
+	int                                              listen_fd_;
+	int                                              signal_fd_;
+	Frame                                            blank_;
+	std::vector<int>                                 closing_;
+	Stats                                            stats_;
+};
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " <socket path> [--sessions <count>] [--rom <path>] [--cycles <per frame>]" << std::endl;
+		return 1;
+	}
+
+	auto rom = std::vector<uint8_t>(std::begin(chip8::kPong), std::end(chip8::kPong));
+	if (!options.rom_path.empty())
+	{
+		const auto error = chip8::load_rom(options.rom_path, 1u, chip8::get_max_rom_size<Spec>(), rom);
+		if (chip8::RomError::kNone != error)
+		{
+			std::cerr << chip8::get_message(error) << ": " << options.rom_path << std::endl;
+			return 1;
+		}
+	}
+
+	auto server = Server(options, Machine::make_image(rom.data(), rom.size()));
+	if (!server.open())
+		return 1;
+
+	server.run();
+
+	return 0;
+}
@@ -0,0 +1,240 @@
+// Attaches to a session of Chip8Server and reports the frames it receives.
+//
+// Applies every frame delta to its copy of the screen and prints, once a second, the
+// frames and bytes received and the frames the server skipped. --key holds a key down
+// in the session, --slow reads only every 100 ms to see the server drop frames. --show
+// draws the screen on the terminal, writing at most --rate bytes a second.
+//
+// Usage: Chip8Viewer <socket path> [--session <index>] [--key <0-F>] [--slow] [--show] [--rate <bytes>]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chip-8/chip.hpp>
+#include <chip-8/frame-delta.h>
+#include <chip-8/session-protocol.h>
+#include <chip-8/terminal-renderer.h>
+
+namespace
+{
+
+using Packed = chip8::PackedFrame<chip8::Chip8Spec>;
+
+struct Options
+{
+	std::string socket_path;
+	uint16_t    session = 0u;
+	uint8_t     key     = chip8::kNoKey;
+	bool        slow    = false;
+	bool        show    = false;
+	uint32_t    rate    = 16384u;
+};
+
+// Interrupts the blocking receive, so the terminal is restored.
+volatile std::sig_atomic_t interrupted = 0;
+
+void interrupt (int)
+{
+	interrupted = 1;
+}
+
+void write_all (const std::string& output)
+{
+	for (auto offset = size_t { 0 }; offset != output.size(); )
+	{
+		const auto result = ::write(STDOUT_FILENO, output.data() + offset, output.size() - offset);
+		if (result < 0 && EINTR != errno)
+			return;
+
+		offset += static_cast<size_t>(std::max<ssize_t>(result, 0));
+	}
+}
+
+bool parse_options (int argc, char* argv[], Options& options)
+{
+	if (argc < 2)
+		return false;
+
+	options.socket_path = argv[1];
+	for (auto i = 2; i < argc; ++i)
+	{
+		const auto option = std::string(argv[i]);
+		if (option == "--slow" || option == "--show")
+		{
+			(option == "--slow" ? options.slow : options.show) = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+			return false;
+
+		const auto value = argv[++i];
+		if (option == "--session")
+			options.session = static_cast<uint16_t>(std::strtoul(value, nullptr, 10));
+		else if (option == "--key")
+			options.key = static_cast<uint8_t>(std::strtoul(value, nullptr, 16));
+		else if (option == "--rate")
+			options.rate = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+			return false;
+	}
+
+	return options.key < 0x10 || options.key == chip8::kNoKey;
+}
+
+bool send_message (int fd, chip8::MessageType type, uint16_t session, const uint8_t* payload, uint32_t size)
+{
+	auto message = std::vector<uint8_t>(sizeof(chip8::MessageHeader) + size);
+
+	const auto header = chip8::MessageHeader { size, static_cast<uint8_t>(type), 0u, session };
+	std::memcpy(message.data(), &header, sizeof(header));
+	std::memcpy(message.data() + sizeof(header), payload, size);
+
+	return ::send(fd, message.data(), message.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(message.size());
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+	auto options = Options();
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " <socket path> [--session <index>] [--key <0-F>] [--slow] [--show] [--rate <bytes>]" << std::endl;
+		return 1;
+	}
+
+	const auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+	auto address = sockaddr_un { };
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, options.socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+	if (-1 == fd || -1 == connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)))
+	{
+		std::cerr << "Fail to connect to " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+
+	if (!send_message(fd, chip8::MessageType::kAttach, options.session, nullptr, 0u) ||
+	    (chip8::kNoKey != options.key && !send_message(fd, chip8::MessageType::kKey, options.session, &options.key, 1u)))
+	{
+		std::cerr << "Fail to attach: " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+
+	struct sigaction action = { };
+	action.sa_handler = interrupt;
+	sigaction(SIGINT,  &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	using Spec = chip8::Chip8Spec;
+
+	auto renderer = chip8::TerminalRenderer(Spec::kScreenWidth, Spec::kScreenHeight, Spec::kPlaneCount, options.rate);
+	if (options.show)
+		write_all(chip8::TerminalRenderer::kEnter);
+
+	auto frame   = std::array<uint8_t, Packed::kSize>();
+	auto input   = std::vector<uint8_t>();
+	auto buffer  = std::array<uint8_t, 4096>();
+	auto last    = uint32_t { 0 };
+	auto frames  = uint64_t { 0 };
+	auto bytes   = uint64_t { 0 };
+	auto skipped = uint64_t { 0 };
+	auto report  = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+	while (!interrupted)
+	{
+		if (options.slow)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		const auto result = ::recv(fd, buffer.data(), buffer.size(), 0);
+		if (result <= 0)
+			break;
+
+		input.insert(input.end(), buffer.data(), buffer.data() + result);
+		bytes += static_cast<uint64_t>(result);
+
+		auto offset = size_t { 0 };
+		while (input.size() - offset >= sizeof(chip8::MessageHeader))
+		{
+			auto header = chip8::MessageHeader();
+			std::memcpy(&header, input.data() + offset, sizeof(header));
+
+			if (input.size() - offset < sizeof(header) + header.size)
+				break;
+
+			const auto payload = input.data() + offset + sizeof(header);
+			offset += sizeof(header) + header.size;
+
+			auto number = uint32_t { 0 };
+			if (static_cast<chip8::MessageType>(header.type) != chip8::MessageType::kFrame || header.size < sizeof(number))
+				continue;
+
+			std::memcpy(&number, payload, sizeof(number));
+
+			if (header.flags & chip8::kKeyframe)
+				frame.fill(0u);
+			else
+				skipped += number - last - 1;
+
+			if (!chip8::apply_delta(payload + sizeof(number), header.size - sizeof(number), frame.data(), Packed::kRowSize, Packed::kRowCount))
+			{
+				std::cerr << "Malformed frame " << number << std::endl;
+				return 1;
+			}
+
+			last = number;
+			++frames;
+		}
+
+		input.erase(input.begin(), input.begin() + offset);
+
+		if (options.show)
+			write_all(renderer.render_frame(frame.data()));
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now >= report)
+		{
+			auto lit = 0u;
+			for (const auto byte : frame)
+				lit += static_cast<uint32_t>(__builtin_popcount(byte));
+
+			// Below the screen, where it doesn't scroll it.
+			if (options.show)
+				std::cout << "\x1b[" << renderer.get_line_count() + 1 << "H\x1b[K";
+
+			std::cout << "frame " << last << ", " << frames << " frames/s, " << bytes << " bytes/s, "
+			          << skipped << " skipped, " << lit << " pixels lit";
+
+			if (options.show)
+				std::cout << ", " << renderer.get_skipped_frame_count() << " frames not drawn" << std::flush;
+			else
+				std::cout << std::endl;
+
+			frames  = 0u;
+			bytes   = 0u;
+			skipped = 0u;
+			report  = now + std::chrono::seconds(1);
+		}
+	}
+
+	close(fd);
+
+	if (options.show)
+		write_all(chip8::TerminalRenderer::kLeave);
+
+	return 0;
+}
@@ -1,472 +1,222 @@
+#include "chip-8/chip.hpp"
+#include "chip-8/debugger.hpp"
 
-#include "chip-8/chip.h"
+namespace chip8
+{
 
-#include <cassert>
-#include <memory>
-#include <iterator>
-#include <random>
-#include <iostream>
+template class Chip<Chip8Spec>;
+template class Chip<SuperChipSpec>;
+template class Chip<XoChipSpec>;
 
-namespace chip8
+// The hooks are templates of their own, so these build the debugger on every spec.
+template class Chip<Chip8Spec,     DefaultQuirks<Chip8Spec>,     Debugger<Chip8Spec>>;
+template class Chip<SuperChipSpec, DefaultQuirks<SuperChipSpec>, Debugger<SuperChipSpec>>;
+template class Chip<XoChipSpec,    DefaultQuirks<XoChipSpec>,    Debugger<XoChipSpec>>;
+
+// The semantics of the opcodes, checked at compile time. Every program boots and runs in
+// constant evaluation, so a change that breaks an opcode breaks the build.
+namespace
 {
 
-struct Instruction
+using Chip8  = Chip<Chip8Spec>;
+using SChip  = Chip<SuperChipSpec>;
+using XoChip = Chip<XoChipSpec>;
+using VipChip = Chip<Chip8Spec, VipQuirks, NoHooks, FlatMemory<Chip8Spec>, VipTiming>;
+
+// Lays out opcodes (and data) big endian, as they are in memory.
+template <typename... Words>
+constexpr auto assemble (Words... words)
 {
-	union
+	const uint16_t values[] = { static_cast<uint16_t>(words)... };
+
+	auto program = std::array<uint8_t, sizeof...(words) * 2>();
+	for (auto i = 0u; i != sizeof...(words); ++i)
 	{
-		struct
-		{
-			uint8_t l8;
-			uint8_t r8;
-		};
-		uint16_t opcode;
-	};
-};
-
-Chip::Chip()
-	:
-	V_          (                    ),
-	PC_         (kProgramMemoryOffset),
-	I_          (0u                  ),
-	STACK_      (                    ),
-	MEM_        (                    ),
-	GFX_        (                    ),
-	KEY_        (0u                  ),
-	DELAY_TIMER_(0u                  ),
-	SOUND_TIMER_(0u                  )
-{
-	wipe_up_resources();
-	load_fontset();
-	load_program();
-}
+		program[i * 2 + 0] = static_cast<uint8_t>(values[i] >> 8);
+		program[i * 2 + 1] = static_cast<uint8_t>(values[i] & 0xFF);
+	}
 
-Chip::~Chip()
-{
+	return program;
 }
 
-void Chip::instruction_cycle()
+template <typename Machine, typename... Words>
+constexpr Machine run_for (uint32_t cycles, Words... words)
 {
-	const auto opcode = fetch();
-	decode_and_execute(opcode);
+	const auto program = assemble(words...);
 
-	if (DELAY_TIMER_ > 0)
-		DELAY_TIMER_--;
+	return Machine::boot(program.data(), program.size(), 1u, cycles);
 }
 
-void Chip::wipe_up_resources()
+// Runs as many cycles as there are words.
+template <typename Machine, typename... Words>
+constexpr Machine run (Words... words)
 {
-	  V_.fill(0u);
-	MEM_.fill(0u);
-	GFX_.fill(0u);
+	return run_for<Machine>(sizeof...(words), words...);
 }
 
-void Chip::load_fontset()
+// Runs timed frames, as many instructions as fit.
+template <typename Machine, typename... Words>
+constexpr Machine run_frames (uint32_t frames, Words... words)
 {
-	constexpr auto kFontset = std::array<uint8_t, 80>
-	{
-		0xF0, 0x90, 0x90, 0x90, 0xF0, //0
-		0x20, 0x60, 0x20, 0x20, 0x70, //1
-		0xF0, 0x10, 0xF0, 0x80, 0xF0, //2
-		0xF0, 0x10, 0xF0, 0x10, 0xF0, //3
-		0x90, 0x90, 0xF0, 0x10, 0x10, //4
-		0xF0, 0x80, 0xF0, 0x10, 0xF0, //5
-		0xF0, 0x80, 0xF0, 0x90, 0xF0, //6
-		0xF0, 0x10, 0x20, 0x40, 0x40, //7
-		0xF0, 0x90, 0xF0, 0x90, 0xF0, //8
-		0xF0, 0x90, 0xF0, 0x10, 0xF0, //9
-		0xF0, 0x90, 0xF0, 0x90, 0x90, //A
-		0xE0, 0x90, 0xE0, 0x90, 0xE0, //B
-		0xF0, 0x80, 0x80, 0x80, 0xF0, //C
-		0xE0, 0x90, 0x90, 0x90, 0xE0, //D
-		0xF0, 0x80, 0xF0, 0x80, 0xF0, //E
-		0xF0, 0x80, 0xF0, 0x80, 0x80  //F
-	};
-
-	std::uninitialized_copy(std::begin(kFontset),
-		                    std::end  (kFontset),
-		                    std::begin(MEM_    ) + kFontsetMemoryOffset);
-}
+	const auto program = assemble(words...);
 
-void Chip::load_program()
-{
-	constexpr auto kPong = std::array<uint8_t, 295>
-	{
-		0x22, 0xFC, 0x6B, 0x0C, 0x6C,
-		0x3F, 0x6D, 0x0C, 0xA2, 0xEA,
-		0xDA, 0xB6, 0xDC, 0xD6, 0x6E,
-		0x00, 0x22, 0xD4, 0x66, 0x03,
-		0x68, 0x02, 0x60, 0x60, 0xF0,
-		0x15, 0xF0, 0x07, 0x30, 0x00,
-		0x12, 0x1A, 0xC7, 0x17, 0x77,
-		0x08, 0x69, 0xFF, 0xA2, 0xF0,
-		0xD6, 0x71, 0xA2, 0xEA, 0xDA,
-		0xB6, 0xDC, 0xD6, 0x60, 0x01,
-		0xE0, 0xA1, 0x7B, 0xFE, 0x60,
-		0x04, 0xE0, 0xA1, 0x7B, 0x02,
-		0x60, 0x1F, 0x8B, 0x02, 0xDA,
-		0xB6, 0x60, 0x0C, 0xE0, 0xA1,
-		0x7D, 0xFE, 0x60, 0x0D, 0xE0,
-		0xA1, 0x7D, 0x02, 0x60, 0x1F,
-		0x8D, 0x02, 0xDC, 0xD6, 0xA2,
-		0xF0, 0xD6, 0x71, 0x86, 0x84,
-		0x87, 0x94, 0x60, 0x3F, 0x86,
-		0x02, 0x61, 0x1F, 0x87, 0x12,
-		0x46, 0x00, 0x12, 0x78, 0x46,
-		0x3F, 0x12, 0x82, 0x47, 0x1F,
-		0x69, 0xFF, 0x47, 0x00, 0x69,
-		0x01, 0xD6, 0x71, 0x12, 0x2A,
-		0x68, 0x02, 0x63, 0x01, 0x80,
-		0x70, 0x80, 0xB5, 0x12, 0x8A,
-		0x68, 0xFE, 0x63, 0x0A, 0x80,
-		0x70, 0x80, 0xD5, 0x3F, 0x01,
-		0x12, 0xA2, 0x61, 0x02, 0x80,
-		0x15, 0x3F, 0x01, 0x12, 0xBA,
-		0x80, 0x15, 0x3F, 0x01, 0x12,
-		0xC8, 0x80, 0x15, 0x3F, 0x01,
-		0x12, 0xC2, 0x60, 0x20, 0xF0,
-		0x18, 0x22, 0xD4, 0x8E, 0x34,
-		0x22, 0xD4, 0x66, 0x3E, 0x33,
-		0x01, 0x66, 0x03, 0x68, 0xFE,
-		0x33, 0x01, 0x68, 0x02, 0x12,
-		0x16, 0x79, 0xFF, 0x49, 0xFE,
-		0x69, 0xFF, 0x12, 0xC8, 0x79,
-		0x01, 0x49, 0x02, 0x69, 0x01,
-		0x60, 0x04, 0xF0, 0x18, 0x76,
-		0x01, 0x46, 0x40, 0x76, 0xFE,
-		0x12, 0x6C, 0xA2, 0xF2, 0xFE,
-		0x33, 0xF2, 0x65, 0xF1, 0x29,
-		0x64, 0x14, 0x65, 0x02, 0xD4,
-		0x55, 0x74, 0x15, 0xF2, 0x29,
-		0xD4, 0x55, 0x00, 0xEE, 0x80,
-		0x80, 0x80, 0x80, 0x80, 0x80,
-		0x80, 0x00, 0x00, 0x00, 0x00,
-		0x00, 0xC0, 0xC0, 0xC0, 0x00,
-		0xFF, 0x00, 0x6B, 0x20, 0x6C,
-		0x00, 0xA2, 0xF6, 0xDB, 0xC4,
-		0x7C, 0x04, 0x3C, 0x20, 0x13,
-		0x02, 0x6A, 0x00, 0x6B, 0x00,
-		0x6C, 0x1F, 0xA2, 0xFA, 0xDA,
-		0xB1, 0xDA, 0xC1, 0x7A, 0x08,
-		0x3A, 0x40, 0x13, 0x12, 0xA2,
-		0xF6, 0x6A, 0x00, 0x6B, 0x20,
-		0xDB, 0xA1, 0x00, 0xEE, 0x00
-	};
-	
-	std::uninitialized_copy(std::begin(kPong),
-		                    std::end  (kPong),
-		                    std::begin(MEM_ ) + kProgramMemoryOffset);
+	auto chip = Machine(program.data(), program.size(), 1u);
+	for (auto i = 0u; i != frames; ++i)
+		chip.run_frame(0u);
+
+	return chip;
 }
 
-uint16_t Chip::fetch()
+constexpr auto kAdd = run<Chip8>(0x6012, 0x70FF);
+static_assert(kAdd.get_v(0x0) == 0x11 && kAdd.get_v(0xF) == 0x0, "7xnn must wrap without a carry!!!");
+
+constexpr auto kOr = run<Chip8>(0x6F05, 0x600C, 0x610A, 0x8011);
+static_assert(kOr.get_v(0x0) == 0x0E && kOr.get_v(0xF) == 0x0, "8xy1 must reset VF on the COSMAC VIP!!!");
+
+constexpr auto kCarry = run<Chip8>(0x60FF, 0x6102, 0x8014);
+static_assert(kCarry.get_v(0x0) == 0x01 && kCarry.get_v(0xF) == 0x1, "8xy4 must carry!!!");
+
+constexpr auto kCarryToVF = run<Chip8>(0x6FFF, 0x6102, 0x8F14);
+static_assert(kCarryToVF.get_v(0xF) == 0x1, "8Fy4 must leave the carry in VF!!!");
+
+constexpr auto kSubtractEqual = run<Chip8>(0x6005, 0x6105, 0x8015);
+static_assert(kSubtractEqual.get_v(0x0) == 0x00 && kSubtractEqual.get_v(0xF) == 0x1, "8xy5 of equal values mustn't borrow!!!");
+
+constexpr auto kBorrow = run<Chip8>(0x6003, 0x6105, 0x8015);
+static_assert(kBorrow.get_v(0x0) == 0xFE && kBorrow.get_v(0xF) == 0x0, "8xy5 must borrow!!!");
+
+constexpr auto kSubtractN = run<Chip8>(0x6003, 0x6105, 0x8017);
+static_assert(kSubtractN.get_v(0x0) == 0x02 && kSubtractN.get_v(0xF) == 0x1, "8xy7 must subtract VX from VY!!!");
+
+constexpr auto kBorrowToVF = run<Chip8>(0x6F05, 0x6103, 0x8F17);
+static_assert(kBorrowToVF.get_v(0xF) == 0x0, "8Fy7 must leave the borrow in VF!!!");
+
+constexpr auto kShiftRight = run<Chip8>(0x6105, 0x8016);
+static_assert(kShiftRight.get_v(0x0) == 0x02 && kShiftRight.get_v(0xF) == 0x1, "8xy6 must shift VY on the COSMAC VIP!!!");
+
+constexpr auto kShiftLeft = run<Chip8>(0x6181, 0x801E);
+static_assert(kShiftLeft.get_v(0x0) == 0x02 && kShiftLeft.get_v(0xF) == 0x1, "8xyE must shift VY on the COSMAC VIP!!!");
+
+constexpr auto kAddToI = run<Chip8>(0xA100, 0x6005, 0xF01E);
+static_assert(kAddToI.get_i() == 0x105 && kAddToI.get_v(0x0) == 0x05, "Fx1E must add VX to I!!!");
+
+constexpr auto kFont = run<Chip8>(0x600A, 0xF029);
+static_assert(kFont.get_i() == kFontsetMemoryOffset + 0xA * 5, "Fx29 must point I to the glyph!!!");
+
+constexpr auto kDecimal = run<Chip8>(0x60FB, 0xA300, 0xF033);
+static_assert(kDecimal.get_memory()[0x300] == 2 && kDecimal.get_memory()[0x301] == 5 && kDecimal.get_memory()[0x302] == 1,
+              "Fx33 must store the decimal digits!!!");
+
+constexpr auto kStore = run<Chip8>(0xA300, 0x6001, 0x6102, 0xF155);
+static_assert(kStore.get_memory()[0x300] == 1 && kStore.get_memory()[0x301] == 2 && kStore.get_i() == 0x302,
+              "Fx55 must store and increment I on the COSMAC VIP!!!");
+
+constexpr auto kLoad = run_for<Chip8>(2, 0xA206, 0xF165, 0x1204, 0x1234);
+static_assert(kLoad.get_v(0x0) == 0x12 && kLoad.get_v(0x1) == 0x34 && kLoad.get_i() == 0x208,
+              "Fx65 must load and increment I on the COSMAC VIP!!!");
+
+constexpr auto kCall = run_for<Chip8>(3, 0x2206, 0x6007, 0x1204, 0x00EE);
+static_assert(kCall.get_pc() == 0x204 && kCall.get_sp() == 0 && kCall.get_v(0x0) == 0x07, "2nnn and 00EE must return after the call!!!");
+
+constexpr auto kUnderflow = run<Chip8>(0x00EE);
+static_assert(kUnderflow.get_fault() == Fault::kStackUnderflow && kUnderflow.get_pc() == 0x200, "00EE must fault on an empty stack!!!");
+
+constexpr auto kSkip = run_for<Chip8>(3, 0x6005, 0x3005, 0x6101, 0x6202);
+static_assert(kSkip.get_v(0x1) == 0x00 && kSkip.get_v(0x2) == 0x02, "3xnn must skip!!!");
+
+constexpr auto kSkipEqual = run_for<Chip8>(4, 0x6005, 0x6105, 0x5010, 0x6201, 0x6302);
+static_assert(kSkipEqual.get_v(0x2) == 0x00 && kSkipEqual.get_v(0x3) == 0x02, "5xy0 must skip!!!");
+
+constexpr auto kJump = run<Chip8>(0x6002, 0xB300);
+static_assert(kJump.get_pc() == 0x302, "Bnnn must add V0 on the COSMAC VIP!!!");
+
+constexpr auto kDraw = run_for<Chip8>(2, 0xA208, 0xD001, 0xD001, 0x1206, 0x8000);
+static_assert(kDraw.get_pixel(0) == 1 && kDraw.get_pixel(1) == 0 && kDraw.get_v(0xF) == 0, "Dxyn must draw!!!");
+
+constexpr auto kErase = run_for<Chip8>(3, 0xA208, 0xD001, 0xD001, 0x1206, 0x8000);
+static_assert(kErase.get_pixel(0) == 0 && kErase.get_v(0xF) == 1, "Dxyn must erase and collide!!!");
+
+constexpr auto kClear = run_for<Chip8>(3, 0xA206, 0xD001, 0x00E0, 0x8000);
+static_assert(kClear.get_pixel(0) == 0, "00E0 must clear!!!");
+
+constexpr auto kDelay = run<Chip8>(0x6009, 0xF015, 0xF007);
+static_assert(kDelay.get_v(0x0) == 8 && kDelay.get_delay_timer() == 7, "The delay timer must count down an instruction!!!");
+
+constexpr auto kRandom = run<Chip8>(0x60FF, 0xC00F);
+static_assert(kRandom.get_v(0x0) <= 0x0F, "Cxnn must mask!!!");
+
+constexpr auto kUnknown = run<Chip8>(0x5001);
+static_assert(kUnknown.get_fault() == Fault::kUnknownOpcode && kUnknown.is_halted(), "Unknown opcodes must fault!!!");
+
+constexpr auto kKeyWait = []
 {
-	return Instruction { MEM_[PC_ + 1], MEM_[PC_ + 0] }.opcode;
-}
+	auto chip = run<Chip8>(0xF00A);
+	const auto waited = chip.get_pc() == 0x200;
 
-void Chip::decode_and_execute(uint16_t opcode)
+	chip.set_key(0x5);
+	chip.instruction_cycle();
+
+	return waited && chip.get_pc() == 0x202 && chip.get_v(0x0) == 0x5;
+}();
+static_assert(kKeyWait, "Fx0A must wait for a key!!!");
+
+constexpr auto kKeySkip = []
 {
+	const auto program = assemble(0x6007, 0xE09E, 0x6101, 0x6202);
 
-#define X   ((opcode & 0x0F00) >> 8)
-#define Y   ((opcode & 0x00F0) >> 4)
-#define N   ((opcode & 0x000F) >> 0)
-#define NN  ((opcode & 0x00FF) >> 0)
-#define NNN ((opcode & 0x0FFF) >> 0)
+	auto chip = Chip8(program.data(), program.size(), 1u);
+	chip.set_key(0x7);
+	for (auto i = 0u; i != 3; ++i)
+		chip.instruction_cycle();
 
-	switch (opcode & 0xF000)
-	{
-	case 0x0000:
-		switch (opcode & 0x000F)
-		{
-		case 0x0000:
-			// Clears the screen.
-			GFX_.fill(0);
-			V_[0xF] = 1;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x000E:
-			// Returns from a subroutine.
-			PC_ = STACK_.top();
-			STACK_.pop();
-			PC_ += sizeof(opcode);
-			break;
-
-		default:
-			assert(false && "Unknown opcode!!!");
-		}
-		break;
-
-	case 0x1000:
-		// Jumps to address NNN.
-		PC_ = NNN;
-		break;
-
-	case 0x2000:
-		// Calls subroutine at NNN.
-		STACK_.push(PC_);
-		PC_ = NNN;
-		break;
-
-	case 0x3000:
-		// Skips the next instruction if VX equals NN.
-		// (Usually the next instruction is a jump to skip a code block)
-		PC_ += (V_[X] == NN) ? sizeof(opcode) * 2 : sizeof(opcode);
-		break;
-			
-	case 0x4000:
-		// Skips the next instruction if VX doesn't equal NN.
-		// (Usually the next instruction is a jump to skip a code block)
-		PC_ += (V_[X] != NN) ? sizeof(opcode) * 2 : sizeof(opcode);
-		break;
-
-	case 0x5000:
-		// Skips the next instruction if VX equals VY.
-		// (Usually the next instruction is a jump to skip a code block)
-		PC_ += (V_[X] == V_[Y]) ? sizeof(opcode) * 2 : sizeof(opcode);
-		break;
-
-	case 0x6000:
-		// Sets VX to NN.
-		V_[X] = NN;
-		PC_ += sizeof(opcode);
-		break;
-
-	case 0x7000:
-		// Adds NN to VX. (Carry flag is not changed)
-		V_[X] += NN;
-		PC_ += sizeof(opcode);
-		break;
-
-	case 0x8000:
-		switch (opcode & 0x00F)
-		{
-		case 0x000:
-			// Sets VX to the value of VY.
-			V_[X] = V_[Y];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x001:
-			// Sets VX to VX or VY. (Bitwise OR operation)
-			V_[X] |= V_[Y];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x002:
-			// Sets VX to VX and VY. (Bitwise AND operation)
-			V_[X] &= V_[Y];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x003:
-			// Sets VX to VX xor VY.
-			V_[X] ^= V_[Y];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x004:
-			// Adds VY to VX.
-			// VF is set to 1 when there's a carry, and to 0 when there isn't.
-			V_[0XF] = (V_[X] > 0xFF - V_[Y]) ? 1 : 0;
-			V_[X] += V_[Y];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x005:
-			// VY is subtracted from VX.
-			// VF is set to 0 when there's a borrow, and 1 when there isn't.
-			V_[0XF] = (V_[X] > V_[Y]) ? 1 : 0;
-			V_[X] -= V_[Y];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x006:
-			// Shifts VY right by one and stores the result to VX(VY remains unchanged).
-			// VF is set to the value of the least significant bit of VY before the shift.
-			V_[0xF] = V_[Y] & 0x1; // TODO CHECK
-			V_[X] = V_[Y] >> 1;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x007:
-			// Sets VX to VY minus VX.
-			// VF is set to 0 when there's a borrow, and 1 when there isn't.
-			V_[0xF] = (V_[Y] > V_[X]) ? 1 : 0;
-			V_[X] = V_[Y] - V_[X];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x00E:
-			// Shifts VY left by one and copies the result to VX.
-			// VF is set to the value of the most significant bit of VY before the shift.
-			V_[0xF] = V_[Y] & 0x1;
-			V_[X] = V_[Y] = V_[Y] << 1;
-			PC_ += sizeof(opcode);
-
-		default:
-			assert(false && "Unknown opcode!!!");
-			break;
-		}
-		break;
-
-	case 0x9000:
-		// Skips the next instruction if VX doesn't equal VY.
-		// (Usually the next instruction is a jump to skip a code block)
-		PC_ += (V_[X] != V_[Y]) ? sizeof(opcode) + sizeof(opcode) : sizeof(opcode);
-		break;
-
-	case 0xA000:
-		// Sets I to the address NNN.
-		I_ = NNN;
-		PC_ += sizeof(opcode);
-		break;
-
-	case 0xB000:
-		// Jumps to the address NNN plus V0.
-		PC_ = NNN + V_[0x0];
-		break;
-
-	case 0xC000:
-		// Sets VX to the result of a bitwise and operation on a random number (Typically: 0 to 255) and NN.
-		V_[X] = (std::random_device()() % 255) & NN;
-		PC_ += sizeof(opcode);
-		break;
-
-	case 0xD000:
-		// Draws a sprite at coordinate (VX, VY) that has a width of 8 pixels and a height of N pixels.
-		// Each row of 8 pixels is read as bit-coded starting from memory location I;
-		// I value doesnt change after the execution of this instruction.
-		// As described above, VF is set to 1 if any screen pixels are flipped from set to unset
-		// when the sprite is drawn, and to 0 if that doesnt happen
-		V_[0xF] = 0;
-		for (auto h = 0u; h != N; ++h)
-		{
-			for (auto shift = 0; shift != 8; ++shift)
-			{
-				auto x = V_[X] + 7 - shift;
-				auto y = V_[Y] + h;
-
-				auto before = GFX_[y * kScreenWidth + x];
-				GFX_[y * kScreenWidth + x] ^= MEM_[I_ + h] & (0x1 << shift);
-
-				if (0 == before && 1 == GFX_[y * kScreenWidth + x])
-				{
-					V_[0xF] = 1;
-				}
-			}
-		}
-		PC_ += sizeof(opcode);
-		break;
-
-	case 0xE000:
-		switch (opcode & 0x00FF)
-		{
-		case 0x009E:
-			// Skips the next instruction if the key stored in VX is pressed.
-			// (Usually the next instruction is a jump to skip a code block)
-			PC_ += (KEY_ == V_[X]) ? sizeof(opcode) + sizeof(opcode) : sizeof(opcode);
-			break;
-
-		case 0x00A1:
-			// Skips the next instruction if the key stored in VX isn't pressed.
-			// (Usually the next instruction is a jump to skip a code block)
-			PC_ += (KEY_ != V_[X]) ? sizeof(opcode) + sizeof(opcode) : sizeof(opcode);
-			break;
-
-		default:
-			assert(false && "Unknown opcode!!!");
-		}
-		break;
-
-	case 0xF000:
-		switch (opcode & 0x00FF)
-		{
-		case 0x0007:
-			// Sets VX to the value of the delay timer.
-			V_[X] = DELAY_TIMER_;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x000A:
-			// A key press is awaited, and then stored in VX.
-			// (Blocking Operation. All instruction halted until next key event)
-			std::cin >> KEY_;
-			V_[X] = KEY_;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x0015:
-			// Sets the delay timer to VX.
-			DELAY_TIMER_ = V_[X];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x0018:
-			// Sets the sound timer to VX.
-			SOUND_TIMER_ = V_[X];
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x001E:
-			// Adds VX to I.
-			V_[X] += I_;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x0029:
-			// Sets I to the location of the sprite for the character in VX.
-			// Characters 0-F (in hexadecimal) are represented by a 4x5 font.
-			I_ = V_[X] + kFontsetMemoryOffset;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x0033:
-			// Stores the binary - coded decimal representation of VX,
-			// with the most significant of three digits at the address in I,
-			// the middle digit at I plus 1, and the least significant digit at I plus 2. 
-			// (In other words, take the decimal representation of VX, 
-			// place the hundreds digit in memory at location in I, 
-			// the tens digit at location I + 1, and the ones digit at location I + 2.)
-			MEM_[I_ + 0] = V_[X] / 100;
-			MEM_[I_ + 1] = V_[X] / 10 % 10;
-			MEM_[I_ + 2] = V_[X] % 100 % 10;
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x0055:
-			// Stores V0 to VX (including VX) in memory starting at address I.
-			// I is increased by 1 for each value written.
-			for (auto i = 0x0; i != X; ++i)
-			{
-				MEM_[I_++] = V_[i];
-			}
-			PC_ += sizeof(opcode);
-			break;
-
-		case 0x0065:
-			// Fills V0 to VX (including VX) with values from memory starting at address I.
-			// I is increased by 1 for each value written.
-			for (auto i = 0x0; i != X; ++i)
-			{
-				V_[i] = MEM_[I_++];
-			}
-			PC_ += sizeof(opcode);
-			break;
-
-		default:
-			assert(false && "Unknown opcode!!!");
-		}
-		break;
-
-	default:
-		assert(false && "Unknown opcode!!!");
-	}
+	return chip.get_v(0x1) == 0x0 && chip.get_v(0x2) == 0x2;
+}();
+static_assert(kKeySkip, "Ex9E must skip while the key is held!!!");
+
+constexpr auto kSuperShift = run<SChip>(0x6005, 0x6140, 0x8016);
+static_assert(kSuperShift.get_v(0x0) == 0x02 && kSuperShift.get_v(0xF) == 0x1, "8xy6 must shift VX on SUPER-CHIP!!!");
+
+constexpr auto kSuperStore = run<SChip>(0xA300, 0xF155);
+static_assert(kSuperStore.get_i() == 0x300, "Fx55 must keep I on SUPER-CHIP!!!");
+
+constexpr auto kSuperJump = run<SChip>(0x6102, 0xB120);
+static_assert(kSuperJump.get_pc() == 0x122, "BxNN must add VX on SUPER-CHIP!!!");
+
+constexpr auto kHiRes = run<SChip>(0x00FF);
+static_assert(kHiRes.is_hires(), "00FF must switch to hi-res!!!");
+
+constexpr auto kLongI = run<XoChip>(0xF000, 0x1234);
+static_assert(kLongI.get_i() == 0x1234 && kLongI.get_pc() == 0x204, "F000 NNNN must load a 16 bit I!!!");
+
+constexpr auto kSkipLong = run_for<XoChip>(2, 0x3000, 0xF000, 0x1234, 0x6001);
+static_assert(kSkipLong.get_v(0x0) == 0x01, "Skips must step over F000 NNNN!!!");
 
-#undef NNN
-#undef NN
-#undef N
-#undef Y
-#undef X
+constexpr auto kStoreRange = run<XoChip>(0xA300, 0x6001, 0x6102, 0x5012);
+static_assert(kStoreRange.get_memory()[0x300] == 1 && kStoreRange.get_memory()[0x301] == 2 && kStoreRange.get_i() == 0x300,
+              "5xy2 must store the range and keep I!!!");
+
+// 7xnn and 1nnn cost 50 and 52 cycles, so 26 of each fit a frame with 38 cycles run over.
+constexpr auto kTimedFrame = run_frames<VipChip>(1, 0x7001, 0x1200);
+static_assert(kTimedFrame.get_v(0x0) == 26 && kTimedFrame.get_cycle_debt() == 38, "A timed frame must run what fits its cycles!!!");
+
+constexpr auto kTimedDebt = run_frames<VipChip>(2, 0x7001, 0x1200);
+static_assert(kTimedDebt.get_v(0x0) == 52 && kTimedDebt.get_cycle_debt() == 24, "A timed frame must pay the cycles run over!!!");
+
+constexpr auto kDisplayWait = run_frames<VipChip>(1, 0xA206, 0xD001, 0x1204, 0x8000);
+static_assert(kDisplayWait.get_pc() == 0x202 && kDisplayWait.get_pixel(0) == 0, "Dxyn must wait for the vertical blank!!!");
+
+constexpr auto kDrawAfterWait = run_frames<VipChip>(2, 0xA206, 0xD001, 0x1204, 0x8000);
+static_assert(kDrawAfterWait.get_pixel(0) == 1, "Dxyn must draw first in the next frame!!!");
+
+constexpr auto kTimedTimer = run_frames<VipChip>(1, 0x6009, 0xF015, 0x1204);
+static_assert(kTimedTimer.get_delay_timer() == 8, "A timed delay timer must count down a frame!!!");
+
+// Pong, booted and run up to its first key check with the paddles, the ball and the score
+// drawn, which is a machine a caller could start from with a copy.
+constexpr auto kPongBoot = Chip8::boot(kPong.data(), kPong.size(), 1u, 213u);
+static_assert(kPongBoot.get_pc() == 0x232 && kPongBoot.get_i() == 0x2EA && kPongBoot.get_fault() == Fault::kNone,
+              "Pong must boot at compile time!!!");
 
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,101 @@
+#include <chip-8/frame-delta.h>
+
+#include <algorithm>
+
+namespace chip8
+{
+
+namespace
+{
+
+constexpr auto kMaxCount = 0xFFu;
+
+}
+
+uint32_t encode_delta (const uint8_t* previous, const uint8_t* current, uint32_t row_size, uint32_t row_count, std::vector<uint8_t>& out)
+{
+	auto changed = 0u;
+	for (auto row = 0u; row != row_count; ++row)
+	{
+		const auto lhs = previous + row * row_size;
+		const auto rhs = current  + row * row_size;
+
+		if (std::memcmp(lhs, rhs, row_size) == 0)
+			continue;
+
+		out.push_back(static_cast<uint8_t>(row >> 0));
+		out.push_back(static_cast<uint8_t>(row >> 8));
+
+		auto x = 0u;
+		while (x != row_size)
+		{
+			auto skip = 0u;
+			while (x != row_size && skip != kMaxCount && lhs[x] == rhs[x])
+			{
+				++skip;
+				++x;
+			}
+
+			auto count = 0u;
+			while (x + count != row_size && count != kMaxCount && lhs[x + count] != rhs[x + count])
+				++count;
+
+			// The zeros up to the end of the row need no pair.
+			if (0 == count && x == row_size)
+				break;
+
+			out.push_back(static_cast<uint8_t>(skip ));
+			out.push_back(static_cast<uint8_t>(count));
+			for (auto i = 0u; i != count; ++i, ++x)
+				out.push_back(lhs[x] ^ rhs[x]);
+		}
+
+		out.push_back(0u);
+		out.push_back(0u);
+
+		++changed;
+	}
+
+	return changed;
+}
+
+bool apply_delta (const uint8_t* delta, size_t size, uint8_t* frame, uint32_t row_size, uint32_t row_count)
+{
+	auto offset = size_t { 0 };
+	while (offset != size)
+	{
+		if (size - offset < 2)
+			return false;
+
+		const auto row = static_cast<uint32_t>(delta[offset] | delta[offset + 1] << 8);
+		offset += 2;
+
+		if (row >= row_count)
+			return false;
+
+		auto x = 0u;
+		for (;;)
+		{
+			if (size - offset < 2)
+				return false;
+
+			const auto skip  = delta[offset + 0];
+			const auto count = delta[offset + 1];
+			offset += 2;
+
+			if (0 == skip && 0 == count)
+				break;
+
+			x += skip;
+			if (x + count > row_size || size - offset < count)
+				return false;
+
+			for (auto i = 0u; i != count; ++i)
+				frame[row * row_size + x++] ^= delta[offset++];
+		}
+	}
+
+	return true;
+}
+
+}  // namespace chip8
@@ -0,0 +1,355 @@
+#include "chip-8/frame-ring.h"
+
+#include <cstring>
+#include <new>
+
+#include "chip-8/chip.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+namespace chip8
+{
+
+namespace
+{
+
+constexpr char kMagic[8] = "C8RING";
+
+// Slots take whole cache lines, so a reader of one doesn't slow the writer of the next.
+constexpr auto kSlotAlignment = 64u;
+
+// A reader gives up after this many torn reads in a row, which takes a writer that laps
+// the ring while the reader copies one frame.
+constexpr auto kMaxAttempts = 16u;
+
+constexpr uint32_t align (uint32_t size) noexcept
+{
+	return (size + kSlotAlignment - 1) / kSlotAlignment * kSlotAlignment;
+}
+
+constexpr auto kSlotsOffset = align(sizeof(FrameRingHeader));
+
+template <typename Slot, typename Header>
+Slot* get_slot (Header* header, uint64_t index) noexcept
+{
+	using Byte = std::conditional_t<std::is_const_v<Header>, const uint8_t, uint8_t>;
+
+	const auto base = reinterpret_cast<Byte*>(header) + kSlotsOffset;
+
+	return reinterpret_cast<Slot*>(base + index % header->slot_count * header->slot_size);
+}
+
+// Maps shared memory under a name: size bytes of a new one, or all of an existing one read
+// only, whose size is returned in size.
+void* map_shared (const std::string& name, bool create, uint64_t& size, void*& mapping)
+{
+
+#ifdef _WIN32
+
+	if (create)
+	{
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		                             static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), name.c_str());
+		if (nullptr == mapping)
+			return nullptr;
+
+		return MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	}
+
+	mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+	if (nullptr == mapping)
+		return nullptr;
+
+	const auto address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	auto information = MEMORY_BASIC_INFORMATION { };
+	if (nullptr != address && 0 != VirtualQuery(address, &information, sizeof(information)))
+		size = static_cast<uint64_t>(information.RegionSize);
+
+	return address;
+
+#else
+
+	mapping = nullptr;
+
+	// A ring left by a writer that died is replaced, not reused: its readers may still read it.
+	if (create)
+		shm_unlink(name.c_str());
+
+	const auto fd = create ? shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644) : shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return nullptr;
+
+	auto address = MAP_FAILED;
+	if (create)
+	{
+		if (0 == ftruncate(fd, static_cast<off_t>(size)))
+			address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	else
+	{
+		struct stat status;
+		if (0 == fstat(fd, &status) && status.st_size > 0)
+		{
+			size    = static_cast<uint64_t>(status.st_size);
+			address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		}
+	}
+
+	::close(fd);
+
+	if (MAP_FAILED == address && create)
+		shm_unlink(name.c_str());
+
+	return MAP_FAILED != address ? address : nullptr;
+
+#endif
+
+}
+
+void unmap_shared (const void* address, [[maybe_unused]] uint64_t size, [[maybe_unused]] void* mapping)
+{
+
+#ifdef _WIN32
+
+	if (nullptr != address)
+		UnmapViewOfFile(address);
+	if (nullptr != mapping)
+		CloseHandle(mapping);
+
+#else
+
+	if (nullptr != address)
+		munmap(const_cast<void*>(address), size);
+
+#endif
+
+}
+
+}
+
+FrameRingWriter::FrameRingWriter ()
+	:
+	name_       (       ),
+	header_     (nullptr),
+	size_       (0u     ),
+	mapping_    (nullptr),
+	slot_       (nullptr),
+	key_        (kNoKey ),
+	sound_timer_(0u     ),
+	frame_count_(0u     )
+{
+}
+
+FrameRingWriter::~FrameRingWriter ()
+{
+	close();
+}
+
+bool FrameRingWriter::open (const std::string& name, uint32_t screen_width, uint32_t screen_height, uint32_t plane_count,
+                            uint32_t slot_count)
+{
+	assert(screen_width % 8 == 0 && "A row must pack into whole bytes!!!");
+	assert(slot_count >= 2 && "The writer needs a slot besides the one read!!!");
+
+	close();
+
+	const auto frame_size = screen_width / 8 * screen_height * plane_count;
+	const auto slot_size  = align(sizeof(FrameSlot) + frame_size);
+
+	size_ = kSlotsOffset + uint64_t { slot_size } * slot_count;
+
+	const auto address = map_shared(name, true, size_, mapping_);
+	if (nullptr == address)
+	{
+		close();
+		return false;
+	}
+
+	name_   = name;
+	header_ = new (address) FrameRingHeader();
+
+	header_->version       = kFrameRingVersion;
+	header_->slot_count    = slot_count;
+	header_->slot_size     = slot_size;
+	header_->frame_size    = frame_size;
+	header_->screen_width  = static_cast<uint16_t>(screen_width);
+	header_->screen_height = static_cast<uint16_t>(screen_height);
+	header_->plane_count   = plane_count;
+
+	for (auto i = 0u; i != slot_count; ++i)
+		new (get_slot<FrameSlot>(header_, i)) FrameSlot();
+
+	// The magic goes last, so a reader never takes a half written header for a ring.
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+
+	frame_count_ = 0u;
+
+	return true;
+}
+
+void FrameRingWriter::close ()
+{
+	unmap_shared(header_, size_, mapping_);
+
+#ifndef _WIN32
+
+	if (nullptr != header_)
+		shm_unlink(name_.c_str());
+
+#endif
+
+	name_.clear();
+
+	header_  = nullptr;
+	size_    = 0u;
+	mapping_ = nullptr;
+	slot_    = nullptr;
+}
+
+void FrameRingWriter::set_key (uint8_t key)
+{
+	key_ = key;
+}
+
+void FrameRingWriter::set_sound_timer (uint8_t value)
+{
+	sound_timer_ = value;
+}
+
+void FrameRingWriter::publish_frame (const uint8_t* frame)
+{
+	std::memcpy(begin_frame(), frame, header_->frame_size);
+	end_frame();
+}
+
+uint8_t* FrameRingWriter::begin_frame ()
+{
+	assert(is_open() && "The ring isn't open!!!");
+
+	slot_ = get_slot<FrameSlot>(header_, frame_count_);
+
+	// Odd while the slot is written. The fence keeps the writes below after the store.
+	slot_->sequence.store(slot_->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot_->key         = key_;
+	slot_->sound_timer = sound_timer_;
+	slot_->number      = frame_count_;
+
+	return reinterpret_cast<uint8_t*>(slot_ + 1);
+}
+
+void FrameRingWriter::end_frame ()
+{
+	slot_->sequence.store(slot_->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+	header_->published.store(++frame_count_, std::memory_order_release);
+}
+
+FrameRingReader::FrameRingReader ()
+	:
+	header_     (nullptr),
+	size_       (0u     ),
+	mapping_    (nullptr),
+	number_     (0u     ),
+	key_        (kNoKey ),
+	sound_timer_(0u     ),
+	retry_count_(0u     )
+{
+}
+
+FrameRingReader::~FrameRingReader ()
+{
+	close();
+}
+
+bool FrameRingReader::open (const std::string& name)
+{
+	close();
+
+	const auto address = map_shared(name, false, size_, mapping_);
+	if (nullptr == address)
+	{
+		close();
+		return false;
+	}
+
+	header_ = static_cast<const FrameRingHeader*>(address);
+
+	const auto valid = size_ >= kSlotsOffset                                                    &&
+	                   0 == std::memcmp(header_->magic, kMagic, sizeof(kMagic))                 &&
+	                   kFrameRingVersion == header_->version                                    &&
+	                   0 != header_->slot_count                                                 &&
+	                   header_->slot_size >= sizeof(FrameSlot) + header_->frame_size            &&
+	                   size_ >= kSlotsOffset + uint64_t { header_->slot_size } * header_->slot_count;
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (!valid)
+		close();
+
+	return is_open();
+}
+
+void FrameRingReader::close ()
+{
+	unmap_shared(header_, size_, mapping_);
+
+	header_  = nullptr;
+	size_    = 0u;
+	mapping_ = nullptr;
+}
+
+bool FrameRingReader::read_latest (uint8_t* frame)
+{
+	assert(is_open() && "The ring isn't open!!!");
+
+	for (auto attempt = 0u; attempt != kMaxAttempts; ++attempt)
+	{
+		const auto published = header_->published.load(std::memory_order_acquire);
+		if (0 == published)
+			return false;
+
+		const auto slot   = get_slot<const FrameSlot>(header_, published - 1);
+		const auto before = slot->sequence.load(std::memory_order_acquire);
+
+		const auto number      = slot->number;
+		const auto key         = slot->key;
+		const auto sound_timer = slot->sound_timer;
+		std::memcpy(frame, slot + 1, header_->frame_size);
+
+		// Keeps the copy above before the load below.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const auto after = slot->sequence.load(std::memory_order_relaxed);
+
+		// The slot may hold a newer frame than published said, from a writer that lapped the
+		// ring, which is as good.
+		if (0 == (before & 0x1) && before == after && number >= published - 1)
+		{
+			number_      = number;
+			key_         = key;
+			sound_timer_ = sound_timer;
+
+			return true;
+		}
+
+		++retry_count_;
+	}
+
+	return false;
+}
+
+}  // namespace chip8
@@ -0,0 +1,125 @@
+#include "chip-8/frame-sink.h"
+
+#include <cstring>
+
+namespace chip8
+{
+
+namespace
+{
+
+uint32_t get_row_size (uint32_t width, PixelFormat format)
+{
+	switch (format)
+	{
+	case PixelFormat::kMono1:
+		return width / 8;
+	case PixelFormat::kIndex8:
+		return width;
+	case PixelFormat::kRgb24:
+		return width * 3;
+	case PixelFormat::kBgra32:
+		return width * 4;
+	}
+
+	return 0u;
+}
+
+}
+
+FrameSink::FrameSink (uint32_t screen_width, uint32_t screen_height, PixelFormat format, void* data, uint32_t stride)
+	:
+	width_  (screen_width                                             ),
+	height_ (screen_height                                            ),
+	format_ (format                                                   ),
+	data_   (static_cast<uint8_t*>(data)                              ),
+	stride_ (0 != stride ? stride : get_row_size(screen_width, format)),
+	palette_{ 0x000000u, 0xFFFFFFu, 0xFF4040u, 0xFFD040u              },
+	shown_  (screen_width * screen_height                             ),
+	valid_  (false                                                    )
+{
+	assert(screen_width % 8 == 0 && "A row must pack into whole bytes!!!");
+	assert(stride_ >= get_row_size(screen_width, format) && "The rows overlap!!!");
+}
+
+void FrameSink::invalidate ()
+{
+	valid_ = false;
+}
+
+void FrameSink::set_palette (const Palette& palette)
+{
+	palette_ = palette;
+}
+
+uint32_t FrameSink::write_pixels (const uint8_t* pixels)
+{
+	auto count = 0u;
+
+	for (auto y = 0u; y != height_; ++y)
+	{
+		const auto row   = pixels + y * width_;
+		const auto shown = shown_.data() + y * width_;
+
+		if (valid_ && 0 == std::memcmp(row, shown, width_))
+			continue;
+
+		write_row(row, data_ + static_cast<size_t>(y) * stride_);
+		std::memcpy(shown, row, width_);
+
+		++count;
+	}
+
+	valid_ = true;
+
+	return count;
+}
+
+void FrameSink::write_row (const uint8_t* pixels, uint8_t* target) const
+{
+	switch (format_)
+	{
+	case PixelFormat::kMono1:
+		for (auto x = 0u; x != width_; x += 8)
+		{
+			auto eight = uint64_t { 0 };
+			std::memcpy(&eight, pixels + x, sizeof(eight));
+
+			// Folds the second plane into the first, then gathers the first plane bits of
+			// the 8 pixels, the first one into the top bit.
+			eight = (eight | eight >> 1) & 0x0101010101010101ull;
+
+			*target++ = static_cast<uint8_t>(eight * 0x8040201008040201ull >> 56);
+		}
+		break;
+
+	case PixelFormat::kIndex8:
+		std::memcpy(target, pixels, width_);
+		break;
+
+	case PixelFormat::kRgb24:
+		for (auto x = 0u; x != width_; ++x)
+		{
+			const auto color = palette_[pixels[x] & 0x3];
+
+			*target++ = static_cast<uint8_t>(color >> 16);
+			*target++ = static_cast<uint8_t>(color >>  8);
+			*target++ = static_cast<uint8_t>(color >>  0);
+		}
+		break;
+
+	case PixelFormat::kBgra32:
+		for (auto x = 0u; x != width_; ++x)
+		{
+			const auto color = palette_[pixels[x] & 0x3];
+
+			*target++ = static_cast<uint8_t>(color >>  0);
+			*target++ = static_cast<uint8_t>(color >>  8);
+			*target++ = static_cast<uint8_t>(color >> 16);
+			*target++ = 0xFF;
+		}
+		break;
+	}
+}
+
+}  // namespace chip8
@@ -0,0 +1,104 @@
+#include "chip-8/mapped-file.h"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+namespace chip8
+{
+
+MappedFile::MappedFile ()
+	:
+	data_   (nullptr),
+	size_   (0u     ),
+	file_   (nullptr),
+	mapping_(nullptr)
+{
+}
+
+MappedFile::~MappedFile ()
+{
+	close();
+}
+
+bool MappedFile::open (const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+
+	const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+		return false;
+
+	file_ = file;
+
+	auto size = LARGE_INTEGER { };
+	GetFileSizeEx(file_, &size);
+	size_ = static_cast<uint64_t>(size.QuadPart);
+
+	mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (nullptr != mapping_)
+		data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+
+#else
+
+	const auto fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(fd, &status) == 0 && status.st_size > 0)
+	{
+		size_ = static_cast<uint64_t>(status.st_size);
+
+		const auto address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+		if (MAP_FAILED != address)
+			data_ = static_cast<const uint8_t*>(address);
+	}
+
+	::close(fd);
+
+#endif
+
+	if (nullptr == data_)
+		close();
+
+	return is_open();
+}
+
+void MappedFile::close ()
+{
+
+#ifdef _WIN32
+
+	if (nullptr != data_)
+		UnmapViewOfFile(data_);
+	if (nullptr != mapping_)
+		CloseHandle(mapping_);
+	if (nullptr != file_)
+		CloseHandle(file_);
+
+#else
+
+	if (nullptr != data_)
+		munmap(const_cast<uint8_t*>(data_), size_);
+
+#endif
+
+	data_    = nullptr;
+	size_    = 0u;
+	mapping_ = nullptr;
+	file_    = nullptr;
+}
+
+}  // namespace chip8
@@ -0,0 +1,530 @@
+#include "chip-8/movie.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace chip8
+{
+
+namespace
+{
+
+constexpr char     kHeaderMagic[8] = { 'C', '8', 'M', 'O', 'V', 'I', 'E', '\0' };
+constexpr char     kFooterMagic[8] = { 'C', '8', 'M', 'V', 'E', 'N', 'D', '\0' };
+constexpr uint32_t kVersion        = 1u;
+
+struct FileHeader
+{
+	char     magic[8];
+	uint32_t version;
+	uint16_t screen_width;
+	uint16_t screen_height;
+	uint32_t plane_count;
+	uint32_t keyframe_interval;
+};
+
+// The key and the sound timer are the ones before the events of the chunk.
+struct ChunkHeader
+{
+	uint64_t first;
+	uint32_t count;
+	uint32_t payload_size;
+	uint8_t  key;
+	uint8_t  sound_timer;
+	uint8_t  reserved[6];
+};
+
+// Follows the chunk index at the end of a finished movie.
+struct FileFooter
+{
+	uint64_t index_offset;
+	uint64_t chunk_count;
+	uint64_t frame_count;
+	char     magic[8];
+};
+
+// The payload of a chunk is a sequence of events, each a tag followed by its operands.
+enum Event : uint8_t
+{
+	kFrame      = 0x0,  // The size of the delta (varint), the delta.
+	kOlderFrame = 0x1,  // As kFrame, against the frame before the one before.
+	kRepeat     = 0x2,  // The number of frames equal to the one before (varint).
+	kKey        = 0x3,  // The key held.
+	kSoundTimer = 0x4   // The sound timer.
+};
+
+void write_varint (uint64_t value, std::vector<uint8_t>& output)
+{
+	while (value >= 0x80)
+	{
+		output.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+
+	output.push_back(static_cast<uint8_t>(value));
+}
+
+bool read_varint (const uint8_t* data, uint64_t end, uint64_t& offset, uint64_t& value)
+{
+	value = 0u;
+	for (auto shift = 0u; shift < 64; shift += 7)
+	{
+		if (offset == end)
+			return false;
+
+		const auto byte = data[offset++];
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+		if (0 == (byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+// The XOR of two frames as (zeros to skip, bytes that follow, the bytes) runs, with varint
+// counts. The zeros up to the end need no run. A single zero between two runs costs less
+// inside a run than as a new one, so runs go over it.
+void encode (const uint8_t* previous, const uint8_t* current, size_t size, std::vector<uint8_t>& output)
+{
+	auto x = size_t { 0 };
+	for (;;)
+	{
+		auto skip = size_t { 0 };
+		while (x != size && previous[x] == current[x])
+		{
+			++skip;
+			++x;
+		}
+
+		if (x == size)
+			break;
+
+		auto count = size_t { 0 };
+		while (x + count != size &&
+		       (previous[x + count] != current[x + count] ||
+		        (x + count + 1 != size && previous[x + count + 1] != current[x + count + 1])))
+			++count;
+
+		write_varint(skip,  output);
+		write_varint(count, output);
+		for (auto i = size_t { 0 }; i != count; ++i, ++x)
+			output.push_back(previous[x] ^ current[x]);
+	}
+}
+
+bool decode (const uint8_t* data, uint64_t offset, uint64_t end, std::vector<uint8_t>& frame)
+{
+	auto x = uint64_t { 0 };
+	while (offset != end)
+	{
+		auto skip  = uint64_t { 0 };
+		auto count = uint64_t { 0 };
+		if (!read_varint(data, end, offset, skip) || !read_varint(data, end, offset, count))
+			return false;
+
+		x += skip;
+		if (x + count > frame.size() || end - offset < count)
+			return false;
+
+		for (auto i = uint64_t { 0 }; i != count; ++i)
+			frame[x++] ^= data[offset++];
+	}
+
+	return true;
+}
+
+}
+
+MovieWriter::MovieWriter (const std::string& path, uint32_t screen_width, uint32_t screen_height, uint32_t plane_count,
+                          uint32_t keyframe_interval)
+	:
+	file_             (path, std::ios::binary | std::ios::trunc          ),
+	is_open_          (false                                            ),
+	keyframe_interval_(keyframe_interval                                ),
+	previous_         (screen_width / 8 * screen_height * plane_count, 0u),
+	older_            (previous_.size()                                 ),
+	current_          (previous_.size()                                 ),
+	delta_            (                                                 ),
+	older_delta_      (                                                 ),
+	payload_          (                                                 ),
+	chunk_frame_count_(0u                                               ),
+	repeat_count_     (0u                                               ),
+	key_              (kNoKey                                           ),
+	sound_timer_      (0u                                               ),
+	chunk_key_        (kNoKey                                           ),
+	chunk_sound_timer_(0u                                               ),
+	frame_count_      (0u                                               ),
+	offsets_          (                                                 )
+{
+	assert(screen_width % 8 == 0 && "A row must pack into whole bytes!!!");
+	assert(keyframe_interval > 0 && "A chunk needs at least one frame!!!");
+
+	if (!file_)
+		return;
+
+	auto header = FileHeader { };
+	std::memcpy(header.magic, kHeaderMagic, sizeof(kHeaderMagic));
+	header.version           = kVersion;
+	header.screen_width      = static_cast<uint16_t>(screen_width);
+	header.screen_height     = static_cast<uint16_t>(screen_height);
+	header.plane_count       = plane_count;
+	header.keyframe_interval = keyframe_interval;
+
+	file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	is_open_ = static_cast<bool>(file_);
+}
+
+MovieWriter::~MovieWriter ()
+{
+	close();
+}
+
+void MovieWriter::set_key (uint8_t key)
+{
+	if (key == key_)
+		return;
+
+	flush_repeats();
+	payload_.push_back(kKey);
+	payload_.push_back(key);
+
+	key_ = key;
+}
+
+void MovieWriter::set_sound_timer (uint8_t value)
+{
+	if (value == sound_timer_)
+		return;
+
+	flush_repeats();
+	payload_.push_back(kSoundTimer);
+	payload_.push_back(value);
+
+	sound_timer_ = value;
+}
+
+void MovieWriter::append_frame (const uint8_t* frame)
+{
+	++frame_count_;
+
+	if (!is_open_)
+		return;
+
+	// The first frame of a chunk is against a blank screen.
+	if (0 == chunk_frame_count_)
+	{
+		std::fill(previous_.begin(), previous_.end(), uint8_t { 0 });
+		std::fill(older_.begin(),    older_.end(),    uint8_t { 0 });
+	}
+
+	if (0 != chunk_frame_count_ && std::memcmp(previous_.data(), frame, previous_.size()) == 0)
+	{
+		++repeat_count_;
+		std::memcpy(older_.data(), previous_.data(), older_.size());
+	}
+	else
+	{
+		flush_repeats();
+
+		// A sprite is drawn by erasing and drawing it again, and a frame can come in between,
+		// so the frame before the one before is often closer.
+		delta_.clear();
+		encode(previous_.data(), frame, previous_.size(), delta_);
+
+		older_delta_.clear();
+		encode(older_.data(), frame, older_.size(), older_delta_);
+
+		const auto older = older_delta_.size() < delta_.size();
+		const auto& delta = older ? older_delta_ : delta_;
+
+		// The delta goes after its size, which is known once it's encoded.
+		payload_.push_back(older ? kOlderFrame : kFrame);
+		write_varint(delta.size(), payload_);
+		payload_.insert(payload_.end(), delta.begin(), delta.end());
+
+		std::swap(older_, previous_);
+		std::memcpy(previous_.data(), frame, previous_.size());
+	}
+
+	if (++chunk_frame_count_ == keyframe_interval_)
+		write_chunk();
+}
+
+void MovieWriter::close ()
+{
+	if (!is_open_)
+		return;
+
+	write_chunk();
+
+	auto footer = FileFooter { };
+	footer.index_offset = static_cast<uint64_t>(file_.tellp());
+	footer.chunk_count  = offsets_.size();
+	footer.frame_count  = frame_count_;
+	std::memcpy(footer.magic, kFooterMagic, sizeof(kFooterMagic));
+
+	file_.write(reinterpret_cast<const char*>(offsets_.data()), offsets_.size() * sizeof(uint64_t));
+	file_.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+	file_.close();
+
+	is_open_ = false;
+}
+
+void MovieWriter::flush_repeats ()
+{
+	if (0 == repeat_count_)
+		return;
+
+	payload_.push_back(kRepeat);
+	write_varint(repeat_count_, payload_);
+
+	repeat_count_ = 0u;
+}
+
+void MovieWriter::write_chunk ()
+{
+	// The events after the last frame precede no frame.
+	if (0 == chunk_frame_count_)
+		return;
+
+	flush_repeats();
+
+	auto header = ChunkHeader { };
+	header.first        = frame_count_ - chunk_frame_count_;
+	header.count        = chunk_frame_count_;
+	header.payload_size = static_cast<uint32_t>(payload_.size());
+	header.key          = chunk_key_;
+	header.sound_timer  = chunk_sound_timer_;
+
+	offsets_.push_back(static_cast<uint64_t>(file_.tellp()));
+	file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file_.write(reinterpret_cast<const char*>(payload_.data()), payload_.size());
+
+	payload_.clear();
+	chunk_frame_count_ = 0u;
+	chunk_key_         = key_;
+	chunk_sound_timer_ = sound_timer_;
+}
+
+MovieReader::MovieReader (const std::string& path)
+	:
+	file_             (             ),
+	screen_width_     (0u           ),
+	screen_height_    (0u           ),
+	plane_count_      (0u           ),
+	keyframe_interval_(0u           ),
+	frame_count_      (0u           ),
+	chunks_           (             ),
+	frame_            (             ),
+	older_            (             ),
+	key_              (kNoKey       ),
+	sound_timer_      (0u           ),
+	chunk_            (~size_t { 0 }),
+	offset_           (0u           ),
+	next_             (0u           ),
+	repeat_count_     (0u           )
+{
+	if (!file_.open(path))
+		return;
+
+	auto header = FileHeader { };
+	if (file_.get_size() < sizeof(header))
+	{
+		file_.close();
+		return;
+	}
+
+	std::memcpy(&header, file_.get_data(), sizeof(header));
+	if (std::memcmp(header.magic, kHeaderMagic, sizeof(kHeaderMagic)) != 0 ||
+		header.version != kVersion || header.screen_width % 8 != 0 || 0 == header.keyframe_interval)
+	{
+		file_.close();
+		return;
+	}
+
+	screen_width_      = header.screen_width;
+	screen_height_     = header.screen_height;
+	plane_count_       = header.plane_count;
+	keyframe_interval_ = header.keyframe_interval;
+
+	frame_.resize(screen_width_ / 8 * screen_height_ * plane_count_);
+	older_.resize(frame_.size());
+
+	// A movie without the index (e.g. the recording process crashed) is still readable chunk by chunk.
+	if (!read_index())
+		scan_chunks();
+}
+
+bool MovieReader::seek (uint64_t index)
+{
+	if (index >= frame_count_)
+		return false;
+
+	// Every chunk but the last holds keyframe_interval frames, so this is a direct lookup.
+	const auto chunk = static_cast<size_t>(index / keyframe_interval_);
+	if (chunk != chunk_ || index + 1 < next_)
+		rewind(chunk);
+
+	while (next_ <= index)
+	{
+		if (!step())
+		{
+			chunk_ = ~size_t { 0 };
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MovieReader::read_index ()
+{
+	const auto data = file_.get_data();
+	const auto size = file_.get_size();
+
+	auto footer = FileFooter { };
+	if (size < sizeof(FileHeader) + sizeof(footer))
+		return false;
+
+	// Checked before the sum of the index's size, which a crafted count overflows.
+	std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+	if (std::memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) != 0 ||
+		footer.index_offset < sizeof(FileHeader) || footer.index_offset > size - sizeof(footer) ||
+		footer.chunk_count > (size - sizeof(footer) - sizeof(FileHeader)) / sizeof(uint64_t) ||
+		footer.index_offset + footer.chunk_count * sizeof(uint64_t) + sizeof(footer) != size)
+		return false;
+
+	chunks_.clear();
+	for (auto i = uint64_t { 0 }; i != footer.chunk_count; ++i)
+	{
+		auto offset = uint64_t { 0 };
+		std::memcpy(&offset, data + footer.index_offset + i * sizeof(uint64_t), sizeof(offset));
+
+		if (!add_chunk(offset, footer.index_offset))
+			return false;
+	}
+
+	frame_count_ = footer.frame_count;
+
+	return chunks_.empty() ? 0 == frame_count_ : chunks_.back().first + chunks_.back().count == frame_count_;
+}
+
+bool MovieReader::scan_chunks ()
+{
+	chunks_.clear();
+
+	for (auto offset = uint64_t { sizeof(FileHeader) }; add_chunk(offset, file_.get_size()); )
+		offset = chunks_.back().offset + sizeof(ChunkHeader) + chunks_.back().payload_size;
+
+	frame_count_ = chunks_.empty() ? 0u : chunks_.back().first + chunks_.back().count;
+
+	return !chunks_.empty();
+}
+
+bool MovieReader::add_chunk (uint64_t offset, uint64_t end)
+{
+	auto header = ChunkHeader { };
+	if (offset < sizeof(FileHeader) || offset > end || end - offset < sizeof(header))
+		return false;
+
+	std::memcpy(&header, file_.get_data() + offset, sizeof(header));
+
+	// The direct lookup of seek needs every chunk but the last one full.
+	const auto first = static_cast<uint64_t>(chunks_.size()) * keyframe_interval_;
+	if (header.payload_size > end - offset - sizeof(header) || header.first != first ||
+		0 == header.count || header.count > keyframe_interval_ ||
+		(!chunks_.empty() && chunks_.back().count != keyframe_interval_))
+		return false;
+
+	chunks_.push_back(Chunk { offset, header.first, header.count, header.payload_size, header.key, header.sound_timer });
+
+	return true;
+}
+
+void MovieReader::rewind (size_t chunk)
+{
+	const auto& header = chunks_[chunk];
+
+	chunk_        = chunk;
+	offset_       = header.offset + sizeof(ChunkHeader);
+	next_         = header.first;
+	repeat_count_ = 0u;
+	key_          = header.key;
+	sound_timer_  = header.sound_timer;
+
+	std::fill(frame_.begin(), frame_.end(), uint8_t { 0 });
+	std::fill(older_.begin(), older_.end(), uint8_t { 0 });
+}
+
+bool MovieReader::step ()
+{
+	if (0 != repeat_count_)
+	{
+		--repeat_count_;
+		++next_;
+		return true;
+	}
+
+	const auto  data  = file_.get_data();
+	const auto& chunk = chunks_[chunk_];
+	const auto  end   = chunk.offset + sizeof(ChunkHeader) + chunk.payload_size;
+
+	while (offset_ != end)
+	{
+		const auto event = data[offset_++];
+
+		auto value = uint64_t { 0 };
+		switch (event)
+		{
+			case kFrame:
+			case kOlderFrame:
+				if (!read_varint(data, end, offset_, value) || end - offset_ < value)
+					return false;
+
+				// The frame before becomes the older one, and the older one the base of the delta.
+				if (kOlderFrame == event)
+					std::swap(frame_, older_);
+				else
+					older_ = frame_;
+
+				if (!decode(data, offset_, offset_ + value, frame_))
+					return false;
+
+				offset_ += value;
+				++next_;
+				return true;
+
+			case kRepeat:
+				if (!read_varint(data, end, offset_, value) || 0 == value)
+					return false;
+
+				older_        = frame_;
+				repeat_count_ = static_cast<uint32_t>(value - 1);
+				++next_;
+				return true;
+
+			case kKey:
+				if (offset_ == end)
+					return false;
+
+				key_ = data[offset_++];
+				break;
+
+			case kSoundTimer:
+				if (offset_ == end)
+					return false;
+
+				sound_timer_ = data[offset_++];
+				break;
+
+			default:
+				return false;
+		}
+	}
+
+	return false;
+}
+
+}  // namespace chip8
@@ -0,0 +1,190 @@
+#include "chip-8/perf-counters.h"
+
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#endif
+
+namespace chip8
+{
+
+namespace
+{
+
+#ifdef __linux__
+
+struct EventConfig
+{
+	uint32_t type;
+	uint64_t config;
+};
+
+constexpr auto kEventConfigs = std::array<EventConfig, PerfCounters::kCounterCount>
+{
+	EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES   },
+	EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	EventConfig { PERF_TYPE_HW_CACHE,
+	              PERF_COUNT_HW_CACHE_L1D                        |
+	              PERF_COUNT_HW_CACHE_OP_READ            << 8    |
+	              PERF_COUNT_HW_CACHE_RESULT_MISS        << 16   }
+};
+
+int open_event (const EventConfig& config, int group_fd)
+{
+	auto attr = perf_event_attr();
+	std::memset(&attr, 0, sizeof(attr));
+
+	attr.size           = sizeof(attr);
+	attr.type           = config.type;
+	attr.config         = config.config;
+	attr.disabled       = group_fd == -1 ? 1 : 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+#endif
+
+}
+
+PerfCounters::PerfCounters ()
+	:
+	fds_     (  ),
+	group_fd_(-1),
+	error_   (  )
+{
+	fds_.fill(-1);
+
+#ifdef __linux__
+
+	// The first counter that opens leads the group, so all of them count over the same time.
+	for (auto i = 0u; i != kCounterCount; ++i)
+	{
+		fds_[i] = open_event(kEventConfigs[i], group_fd_);
+
+		if (-1 == fds_[i])
+		{
+			if (error_.empty())
+				error_ = std::string("perf_event_open failed for ") + get_name(static_cast<Counter>(i)) + ": " + std::strerror(errno);
+			continue;
+		}
+
+		if (-1 == group_fd_)
+			group_fd_ = fds_[i];
+	}
+
+	if (-1 != group_fd_)
+		error_.clear();
+
+#else
+
+	error_ = "perf_event is only available on Linux";
+
+#endif
+
+}
+
+PerfCounters::~PerfCounters ()
+{
+
+#ifdef __linux__
+
+	for (const auto fd : fds_)
+	{
+		if (-1 != fd)
+			close(fd);
+	}
+
+#endif
+
+}
+
+void PerfCounters::enable ()
+{
+
+#ifdef __linux__
+
+	if (is_available())
+	{
+		ioctl(group_fd_, PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP);
+		ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+#endif
+
+}
+
+void PerfCounters::disable ()
+{
+
+#ifdef __linux__
+
+	if (is_available())
+		ioctl(group_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+#endif
+
+}
+
+PerfCounters::Values PerfCounters::read () const
+{
+	auto values = Values();
+	values.fill(0u);
+
+#ifdef __linux__
+
+	if (!is_available())
+		return values;
+
+	// { nr, { value, id } * nr }, the values come in the order the counters were opened.
+	auto buffer = std::array<uint64_t, 1 + kCounterCount * 2>();
+	if (::read(group_fd_, buffer.data(), sizeof(buffer)) <= 0)
+		return values;
+
+	auto index = 1u;
+	for (auto i = 0u; i != kCounterCount && index < 1 + buffer[0] * 2; ++i)
+	{
+		if (-1 == fds_[i])
+			continue;
+
+		values[i] = buffer[index];
+		index += 2;
+	}
+
+#endif
+
+	return values;
+}
+
+const char* PerfCounters::get_name (Counter counter) noexcept
+{
+	switch (counter)
+	{
+	case kCycles:
+		return "cycles";
+
+	case kInstructions:
+		return "instructions";
+
+	case kBranchMisses:
+		return "branch_misses";
+
+	case kL1DMisses:
+		return "l1d_misses";
+
+	default:
+		return "unknown";
+	}
+}
+
+}
@@ -0,0 +1,43 @@
+#include "chip-8/rom-file.h"
+
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace chip8
+{
+
+RomError load_rom (const std::string& path, size_t min_size, size_t max_size, std::vector<uint8_t>& rom)
+{
+	auto file = std::ifstream(path, std::ios::binary);
+	if (!file)
+		return RomError::kOpen;
+
+	auto content = std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (file.bad())
+		return RomError::kOpen;
+
+	if (content.size() < min_size || content.size() > max_size)
+		return RomError::kSize;
+
+	rom = std::move(content);
+
+	return RomError::kNone;
+}
+
+const char* get_message (RomError error) noexcept
+{
+	switch (error)
+	{
+	case RomError::kOpen:
+		return "Fail to open the ROM";
+
+	case RomError::kSize:
+		return "Invalid ROM size";
+
+	default:
+		return "No error";
+	}
+}
+
+}  // namespace chip8
@@ -0,0 +1,224 @@
+#include "chip-8/terminal-renderer.h"
+
+#include <algorithm>
+
+namespace chip8
+{
+
+namespace
+{
+
+// A cell or a color that isn't known to be on the terminal.
+constexpr auto kUnknown = uint8_t { 0xFF };
+
+// Indexed by the upper pixel and the lower pixel times 2.
+constexpr const char* kGlyphs[4] = { " ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88" };
+
+// The ANSI color of a pixel value: none, the first plane white, the second red, both yellow.
+// 9 is the terminal's default.
+constexpr char kColors[4] = { '9', '7', '1', '3' };
+
+// The burst the budget keeps, in seconds of output.
+constexpr auto kMaxBudget = 0.25;
+
+void append_number (uint32_t value, std::string& output)
+{
+	char digits[10];
+	auto count = 0u;
+	do
+	{
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+	while (0 != value);
+
+	while (0 != count)
+		output += digits[--count];
+}
+
+}
+
+TerminalRenderer::TerminalRenderer (uint32_t screen_width, uint32_t screen_height, uint32_t plane_count, uint32_t bytes_per_second)
+	:
+	width_              (screen_width                                  ),
+	line_count_         (screen_height / 2                             ),
+	plane_count_        (plane_count                                   ),
+	bytes_per_second_   (bytes_per_second                              ),
+	frame_              (screen_width / 8 * screen_height * plane_count),
+	cells_              (screen_width * line_count_                    ),
+	shown_              (cells_.size(), 0u                             ),
+	output_             (                                              ),
+	cursor_line_        (0u                                            ),
+	cursor_column_      (0u                                            ),
+	foreground_         (kUnknown                                      ),
+	background_         (kUnknown                                      ),
+	budget_             (0.0                                           ),
+	time_               (Clock::now()                                  ),
+	skipped_frame_count_(0u                                            )
+{
+	assert(screen_width % 8 == 0 && "A row must pack into whole bytes!!!");
+	assert(screen_height % 2 == 0 && "A line shows two rows!!!");
+	assert(plane_count <= 2 && "A cell has colors for two planes!!!");
+}
+
+void TerminalRenderer::invalidate ()
+{
+	std::fill(shown_.begin(), shown_.end(), kUnknown);
+}
+
+const std::string& TerminalRenderer::render_frame (const uint8_t* frame)
+{
+	output_.clear();
+
+	if (0 != bytes_per_second_)
+	{
+		const auto now = Clock::now();
+
+		budget_ += std::chrono::duration<double>(now - time_).count() * bytes_per_second_;
+		budget_  = std::min(budget_, kMaxBudget * bytes_per_second_);
+		time_    = now;
+
+		// The frame that overdrew the budget was let through whole, so it's paid back first.
+		if (budget_ < 0.0)
+		{
+			++skipped_frame_count_;
+			return output_;
+		}
+	}
+
+	read_cells(frame);
+
+	// Other output may have moved the cursor or changed the colors since the last render.
+	cursor_line_ = ~0u;
+	foreground_  = kUnknown;
+	background_  = kUnknown;
+
+	for (auto line = 0u; line != line_count_; ++line)
+	{
+		const auto cells = cells_.data() + line * width_;
+		const auto shown = shown_.data() + line * width_;
+
+		for (auto column = 0u; column != width_; ++column)
+		{
+			if (cells[column] == shown[column])
+				continue;
+
+			// The cell right after the one written is where the cursor already is, and an
+			// unchanged cell in between costs less written again than a cursor move.
+			if (line != cursor_line_ || column != cursor_column_)
+			{
+				if (line == cursor_line_ && column == cursor_column_ + 1)
+					write_cell(cells[cursor_column_]);
+				else
+					move_cursor(line, column);
+			}
+
+			write_cell(cells[column]);
+			shown[column] = cells[column];
+		}
+	}
+
+	if (kUnknown != foreground_ || kUnknown != background_)
+		output_ += "\x1b[0m";
+
+	budget_ -= static_cast<double>(output_.size());
+
+	return output_;
+}
+
+void TerminalRenderer::read_cells (const uint8_t* frame)
+{
+	const auto row_size  = width_ / 8;
+	const auto rows      = line_count_ * 2;
+	const auto data_size = row_size * rows;
+
+	std::fill(cells_.begin(), cells_.end(), uint8_t { 0 });
+
+	for (auto plane = 0u; plane != plane_count_; ++plane)
+	{
+		for (auto line = 0u; line != line_count_; ++line)
+		{
+			const auto upper = frame + plane * data_size + (line * 2 + 0) * row_size;
+			const auto lower = frame + plane * data_size + (line * 2 + 1) * row_size;
+			const auto cells = cells_.data() + line * width_;
+
+			for (auto x = 0u; x != width_; ++x)
+			{
+				const auto shift  = 7 - x % 8;
+				const auto top    = (upper[x / 8] >> shift) & 0x1;
+				const auto bottom = (lower[x / 8] >> shift) & 0x1;
+
+				cells[x] |= static_cast<uint8_t>((top | bottom << 2) << plane);
+			}
+		}
+	}
+}
+
+void TerminalRenderer::move_cursor (uint32_t line, uint32_t column)
+{
+	if (line == cursor_line_ && column > cursor_column_)
+	{
+		output_ += "\x1b[";
+		if (column - cursor_column_ != 1)
+			append_number(column - cursor_column_, output_);
+		output_ += 'C';
+	}
+	else
+	{
+		output_ += "\x1b[";
+		append_number(line + 1, output_);
+		if (0 != column)
+		{
+			output_ += ';';
+			append_number(column + 1, output_);
+		}
+		output_ += 'H';
+	}
+
+	cursor_line_   = line;
+	cursor_column_ = column;
+}
+
+void TerminalRenderer::write_cell (uint8_t cell)
+{
+	const auto top    = cell & 0x3;
+	const auto bottom = cell >> 2;
+
+	if (1 == plane_count_)
+	{
+		output_ += kGlyphs[top | bottom << 1];
+	}
+	else
+	{
+		// A cell of one color is a space, which needs no foreground.
+		const auto foreground = top == bottom ? foreground_ : static_cast<uint8_t>(top);
+		const auto background = static_cast<uint8_t>(bottom);
+
+		if (foreground != foreground_ || background != background_)
+		{
+			output_ += "\x1b[";
+			if (foreground != foreground_)
+			{
+				output_ += '3';
+				output_ += kColors[foreground];
+			}
+			if (foreground != foreground_ && background != background_)
+				output_ += ';';
+			if (background != background_)
+			{
+				output_ += '4';
+				output_ += kColors[background];
+			}
+			output_ += 'm';
+
+			foreground_ = foreground;
+			background_ = background;
+		}
+
+		output_ += kGlyphs[top == bottom ? 0 : 1];
+	}
+
+	++cursor_column_;
+}
+
+}  // namespace chip8
@@ -0,0 +1,430 @@
+#include "chip-8/trace.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace chip8
+{
+
+namespace
+{
+
+constexpr char     kHeaderMagic[8] = { 'C', '8', 'T', 'R', 'A', 'C', 'E', '\0' };
+constexpr char     kFooterMagic[8] = { 'C', '8', 'T', 'R', 'E', 'N', 'D', '\0' };
+constexpr uint32_t kVersion        = 1u;
+constexpr uint32_t kCompressed     = 0x1u;
+
+struct FileHeader
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t records_per_block;
+	uint32_t flags;
+};
+
+struct BlockHeader
+{
+	uint64_t first;
+	uint32_t count;
+	uint32_t payload_size;
+};
+
+// Follows the block index at the end of a finished trace.
+struct FileFooter
+{
+	uint64_t index_offset;
+	uint64_t block_count;
+	uint64_t record_count;
+	char     magic[8];
+};
+
+// Returns a bit for each byte of the word that isn't zero, the lowest for the first byte.
+uint32_t get_nonzero_bytes (uint64_t word)
+{
+	// Sets the high bit of every byte that isn't zero, then gathers those into the top byte.
+	const auto high = (((word & 0x7F7F7F7F7F7F7F7Full) + 0x7F7F7F7F7F7F7F7Full) | word) & 0x8080808080808080ull;
+
+	return static_cast<uint32_t>(((high >> 7) * 0x0102040810204080ull) >> 56);
+}
+
+// Returns the index of the lowest set bit, of bits that aren't zero.
+uint32_t get_lowest_bit (uint32_t bits)
+{
+#if defined(_MSC_VER)
+	auto index = 0ul;
+	_BitScanForward(&index, bits);
+
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(bits));
+#endif
+}
+
+// Every record is XORed with the previous one of the block, which leaves mostly zero bytes.
+// Each 16 bytes delta is stored as a 16 bit mask of the non zero bytes followed by them.
+void encode (const TraceRecord* records, size_t count, std::vector<uint8_t>& output)
+{
+	static_assert(sizeof(TraceRecord) == 2 * sizeof(uint64_t), "A record must be two words!!!");
+
+	// Sized for the worst case up front, so the bytes are stored without growing it.
+	output.resize(count * (2 + sizeof(TraceRecord)));
+
+	auto previous = std::array<uint64_t, 2>();
+	auto out      = output.data();
+
+	for (auto i = 0u; i != count; ++i)
+	{
+		auto current = std::array<uint64_t, 2>();
+		std::memcpy(current.data(), &records[i], sizeof(TraceRecord));
+
+		const auto delta = std::array<uint64_t, 2> { current[0] ^ previous[0], current[1] ^ previous[1] };
+		const auto mask  = get_nonzero_bytes(delta[0]) | get_nonzero_bytes(delta[1]) << 8;
+
+		auto bytes = std::array<uint8_t, sizeof(TraceRecord)>();
+		std::memcpy(bytes.data(), delta.data(), sizeof(TraceRecord));
+
+		*out++ = static_cast<uint8_t>(mask >> 0);
+		*out++ = static_cast<uint8_t>(mask >> 8);
+
+		// Visits the set bits of the mask only, mostly a few.
+		for (auto bits = mask; 0 != bits; bits &= bits - 1)
+			*out++ = bytes[get_lowest_bit(bits)];
+
+		previous = current;
+	}
+
+	output.resize(static_cast<size_t>(out - output.data()));
+}
+
+// Returns false if the input ends before the count records do.
+bool decode (const uint8_t* input, const uint8_t* end, size_t count, std::vector<TraceRecord>& records)
+{
+	auto previous = std::array<uint8_t, sizeof(TraceRecord)>();
+
+	records.resize(count);
+	for (auto i = 0u; i != count; ++i)
+	{
+		if (end - input < 2)
+			return false;
+
+		const auto mask = static_cast<uint16_t>(input[0] | input[1] << 8);
+		input += 2;
+
+		for (auto j = 0u; j != sizeof(TraceRecord); ++j)
+		{
+			if (0 == (mask & (0x1 << j)))
+				continue;
+
+			if (input == end)
+				return false;
+
+			previous[j] ^= *input++;
+		}
+
+		std::memcpy(&records[i], previous.data(), sizeof(TraceRecord));
+	}
+
+	return true;
+}
+
+}
+
+TraceWriter::TraceWriter (const std::string& path, bool compressed, uint32_t records_per_block)
+	:
+	file_      (path, std::ios::binary | std::ios::trunc),
+	is_open_   (false                                  ),
+	compressed_(compressed                             ),
+	front_     (records_per_block                      ),
+	back_      (records_per_block                      ),
+	count_     (0u                                     ),
+	back_count_(0u                                     ),
+	submitted_ (0u                                     ),
+	offsets_   (                                       ),
+	mutex_     (                                       ),
+	condition_ (                                       ),
+	stop_      (false                                  ),
+	thread_    (                                       )
+{
+	assert(records_per_block > 0 && "A block needs at least one record!!!");
+
+	if (!file_)
+		return;
+
+	auto header = FileHeader { };
+	std::memcpy(header.magic, kHeaderMagic, sizeof(kHeaderMagic));
+	header.version           = kVersion;
+	header.record_size       = sizeof(TraceRecord);
+	header.records_per_block = records_per_block;
+	header.flags             = compressed_ ? kCompressed : 0u;
+
+	file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	is_open_ = static_cast<bool>(file_);
+	thread_  = std::thread(&TraceWriter::write_blocks, this);
+}
+
+TraceWriter::~TraceWriter ()
+{
+	if (!is_open_)
+		return;
+
+	if (count_ != 0)
+		submit();
+
+	{
+		auto lock = std::unique_lock<std::mutex>(mutex_);
+		stop_ = true;
+	}
+	condition_.notify_all();
+	thread_.join();
+
+	write_footer();
+}
+
+void TraceWriter::submit ()
+{
+	if (!is_open_)
+	{
+		submitted_ += count_;
+		count_      = 0;
+		return;
+	}
+
+	// Waits for the writer thread to finish the previous buffer, then hands over this one.
+	{
+		auto lock = std::unique_lock<std::mutex>(mutex_);
+		condition_.wait(lock, [this] { return 0 == back_count_; });
+
+		std::swap(front_, back_);
+		back_count_ = count_;
+	}
+	condition_.notify_all();
+
+	submitted_ += count_;
+	count_      = 0;
+}
+
+void TraceWriter::write_blocks ()
+{
+	auto first   = uint64_t { 0 };
+	auto payload = std::vector<uint8_t>();
+
+	while (true)
+	{
+		auto lock = std::unique_lock<std::mutex>(mutex_);
+		condition_.wait(lock, [this] { return 0 != back_count_ || stop_; });
+
+		if (0 == back_count_)
+			break;
+
+		const auto count = back_count_;
+		lock.unlock();
+
+		// Only this thread touches back_ until back_count_ is reset.
+		auto data = reinterpret_cast<const char*>(back_.data());
+		auto size = count * sizeof(TraceRecord);
+
+		if (compressed_)
+		{
+			payload.clear();
+			encode(back_.data(), count, payload);
+
+			data = reinterpret_cast<const char*>(payload.data());
+			size = payload.size();
+		}
+
+		const auto header = BlockHeader { first, static_cast<uint32_t>(count), static_cast<uint32_t>(size) };
+
+		offsets_.push_back(static_cast<uint64_t>(file_.tellp()));
+		file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file_.write(data, size);
+
+		first += count;
+
+		lock.lock();
+		back_count_ = 0;
+		lock.unlock();
+		condition_.notify_all();
+	}
+}
+
+void TraceWriter::write_footer ()
+{
+	auto footer = FileFooter { };
+	footer.index_offset = static_cast<uint64_t>(file_.tellp());
+	footer.block_count  = offsets_.size();
+	footer.record_count = submitted_;
+	std::memcpy(footer.magic, kFooterMagic, sizeof(kFooterMagic));
+
+	file_.write(reinterpret_cast<const char*>(offsets_.data()), offsets_.size() * sizeof(uint64_t));
+	file_.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+	file_.flush();
+}
+
+TraceReader::TraceReader (const std::string& path)
+	:
+	file_             (       ),
+	data_             (nullptr),
+	size_             (0u     ),
+	compressed_       (false  ),
+	records_per_block_(0u     ),
+	record_count_     (0u     ),
+	blocks_           (       ),
+	cache_            (       ),
+	cached_block_     (~size_t { 0 })
+{
+	if (!file_.open(path))
+		return;
+
+	data_ = file_.get_data();
+	size_ = file_.get_size();
+
+	auto header = FileHeader { };
+	if (size_ < sizeof(header))
+	{
+		unmap();
+		return;
+	}
+
+	std::memcpy(&header, data_, sizeof(header));
+	if (std::memcmp(header.magic, kHeaderMagic, sizeof(kHeaderMagic)) != 0 ||
+		header.version != kVersion || header.record_size != sizeof(TraceRecord) || 0 == header.records_per_block)
+	{
+		unmap();
+		return;
+	}
+
+	compressed_        = 0 != (header.flags & kCompressed);
+	records_per_block_ = header.records_per_block;
+
+	// A trace without the footer (e.g. the recording process crashed) is still readable block by block.
+	if (!read_index())
+		scan_blocks();
+}
+
+TraceReader::~TraceReader ()
+{
+	unmap();
+}
+
+bool TraceReader::read (uint64_t index, TraceRecord& record)
+{
+	assert(index < record_count_ && "The index is out of the trace!!!");
+
+	const auto& block  = find_block(index);
+	const auto  offset = index - block.first;
+	const auto  data   = data_ + block.offset + sizeof(BlockHeader);
+
+	if (!compressed_)
+	{
+		std::memcpy(&record, data + offset * sizeof(TraceRecord), sizeof(TraceRecord));
+		return true;
+	}
+
+	// A compressed block is decoded as a whole, so sequential reads decode it once.
+	const auto block_index = static_cast<size_t>(&block - blocks_.data());
+	if (block_index != cached_block_)
+	{
+		cached_block_ = ~size_t { 0 };
+		if (!decode(data, data + block.payload_size, block.count, cache_))
+			return false;
+
+		cached_block_ = block_index;
+	}
+
+	record = cache_[offset];
+
+	return true;
+}
+
+bool TraceReader::read_index ()
+{
+	auto footer = FileFooter { };
+	if (size_ < sizeof(FileHeader) + sizeof(footer))
+		return false;
+
+	std::memcpy(&footer, data_ + size_ - sizeof(footer), sizeof(footer));
+	if (std::memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) != 0 ||
+		footer.index_offset > size_ - sizeof(footer) ||
+		footer.block_count != (size_ - sizeof(footer) - footer.index_offset) / sizeof(uint64_t) ||
+		footer.index_offset + footer.block_count * sizeof(uint64_t) + sizeof(footer) != size_)
+		return false;
+
+	blocks_.clear();
+	record_count_ = 0;
+
+	for (auto i = uint64_t { 0 }; i != footer.block_count; ++i)
+	{
+		auto offset = uint64_t { 0 };
+		std::memcpy(&offset, data_ + footer.index_offset + i * sizeof(uint64_t), sizeof(offset));
+
+		if (!add_block(offset, footer.index_offset))
+			return false;
+	}
+
+	return record_count_ == footer.record_count;
+}
+
+bool TraceReader::scan_blocks ()
+{
+	blocks_.clear();
+	record_count_ = 0;
+
+	// Stops at the first block that is cut off or corrupt, and keeps the ones before it.
+	for (auto offset = uint64_t { sizeof(FileHeader) }; add_block(offset, size_); )
+		offset += sizeof(BlockHeader) + blocks_.back().payload_size;
+
+	return !blocks_.empty();
+}
+
+bool TraceReader::add_block (uint64_t offset, uint64_t end)
+{
+	if (offset < sizeof(FileHeader) || offset > end || end - offset < sizeof(BlockHeader))
+		return false;
+
+	auto header = BlockHeader { };
+	std::memcpy(&header, data_ + offset, sizeof(header));
+
+	if (header.payload_size > end - offset - sizeof(header))
+		return false;
+
+	// The blocks follow each other, and all but the last are full, which find_block relies on.
+	if (0 == header.count || header.count > records_per_block_ || header.first != record_count_ ||
+		(!blocks_.empty() && blocks_.back().count != records_per_block_))
+		return false;
+
+	// A compressed record takes its 2 bytes of mask and up to a byte for every byte of it.
+	const auto count = uint64_t { header.count };
+	if (compressed_ ? header.payload_size < count * 2 || header.payload_size > count * (2 + sizeof(TraceRecord)) :
+	                  header.payload_size != count * sizeof(TraceRecord))
+		return false;
+
+	blocks_.push_back(Block { offset, header.first, header.count, header.payload_size });
+	record_count_ += header.count;
+
+	return true;
+}
+
+void TraceReader::unmap ()
+{
+	file_.close();
+
+	data_ = nullptr;
+	size_ = 0u;
+}
+
+const TraceReader::Block& TraceReader::find_block (uint64_t index) const
+{
+	// Every block but the last holds records_per_block records, so this is a direct lookup.
+	const auto guess = std::min<uint64_t>(index / records_per_block_, blocks_.size() - 1);
+
+	return blocks_[static_cast<size_t>(guess)];
+}
+
+}
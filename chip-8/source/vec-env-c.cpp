@@ -0,0 +1,139 @@
+#include "chip-8/vec-env-c.h"
+
+#include <new>
+#include <vector>
+#include <thread>
+
+#include "chip-8/chip.hpp"
+#include "chip-8/vec-env.hpp"
+
+namespace
+{
+
+using Machine = chip8::Chip<chip8::Chip8Spec>;
+
+static_assert(CHIP8_NO_KEY == chip8::kNoKey, "The C action of no key isn't kNoKey!!!");
+static_assert(CHIP8_EPISODE_TERMINATED == static_cast<int>(chip8::EpisodeEnd::kTerminated) &&
+              CHIP8_EPISODE_TRUNCATED  == static_cast<int>(chip8::EpisodeEnd::kTruncated), "The C episode ends aren't EpisodeEnd!!!");
+
+}
+
+struct chip8_vec_env
+{
+	chip8_vec_env (const uint8_t* program, size_t size, uint32_t env_count, uint32_t cycles_per_frame,
+	               chip8::ObservationFormat format, uint32_t thread_count)
+		:
+		pool   (thread_count                                            ),
+		envs   (pool, program, size, env_count, cycles_per_frame, format),
+		actions(env_count                                               )
+	{
+	}
+
+	utl::ThreadPool        pool;
+	chip8::VecEnv<Machine> envs;
+	std::vector<uint8_t>   actions;  // The actions of a step, checked.
+};
+
+chip8_vec_env* chip8_vec_env_create (const uint8_t* program, size_t size, uint32_t env_count,
+                                     uint32_t cycles_per_frame, int observation_format, uint32_t thread_count)
+{
+	if (nullptr == program || 0 == size || size > chip8::Chip8Spec::kDRamSize - chip8::kProgramMemoryOffset)
+		return nullptr;
+
+	if (0 == env_count || 0 == cycles_per_frame)
+		return nullptr;
+
+	if (CHIP8_OBSERVATION_PACKED != observation_format && CHIP8_OBSERVATION_BYTES != observation_format)
+		return nullptr;
+
+	const auto format = CHIP8_OBSERVATION_PACKED == observation_format ? chip8::ObservationFormat::kPacked :
+	                                                                     chip8::ObservationFormat::kBytes;
+
+	// Exceptions don't cross the C interface.
+	try
+	{
+		return new chip8_vec_env(program, size, env_count, cycles_per_frame, format,
+		                         0 != thread_count ? thread_count : std::thread::hardware_concurrency());
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void chip8_vec_env_destroy (chip8_vec_env* envs)
+{
+	delete envs;
+}
+
+void chip8_vec_env_set_reward (chip8_vec_env* envs, chip8_reward_hook hook, void* user_data)
+{
+	if (nullptr == hook)
+	{
+		envs->envs.set_reward(nullptr);
+		return;
+	}
+
+	envs->envs.set_reward([hook, user_data](const Machine& machine)
+	{
+		return hook(machine.get_registers().data(), machine.get_memory().data(), user_data);
+	});
+}
+
+void chip8_vec_env_set_done (chip8_vec_env* envs, chip8_done_hook hook, void* user_data)
+{
+	if (nullptr == hook)
+	{
+		envs->envs.set_done(nullptr);
+		return;
+	}
+
+	envs->envs.set_done([hook, user_data](const Machine& machine)
+	{
+		return 0 != hook(machine.get_registers().data(), machine.get_memory().data(), user_data);
+	});
+}
+
+void chip8_vec_env_set_max_frames (chip8_vec_env* envs, uint32_t frames)
+{
+	envs->envs.set_max_frames(frames);
+}
+
+void chip8_vec_env_reset (chip8_vec_env* envs, uint32_t seed)
+{
+	envs->envs.reset(seed);
+}
+
+void chip8_vec_env_step (chip8_vec_env* envs, const uint8_t* actions)
+{
+	// The actions come from outside, so a bad one holds no key rather than tripping set_key.
+	for (auto i = size_t { 0 }; i != envs->actions.size(); ++i)
+		envs->actions[i] = actions[i] < chip8::kKeyRegisterCount ? actions[i] : chip8::kNoKey;
+
+	envs->envs.step(envs->actions.data());
+}
+
+size_t chip8_vec_env_get_env_count (const chip8_vec_env* envs)
+{
+	return envs->envs.get_env_count();
+}
+
+size_t chip8_vec_env_get_observation_size (const chip8_vec_env* envs)
+{
+	return envs->envs.get_observation_size();
+}
+
+const uint8_t* chip8_vec_env_get_observations (const chip8_vec_env* envs)
+{
+	return envs->envs.get_observations();
+}
+
+const double* chip8_vec_env_get_rewards (const chip8_vec_env* envs)
+{
+	return envs->envs.get_rewards();
+}
+
+const uint8_t* chip8_vec_env_get_ends (const chip8_vec_env* envs)
+{
+	return reinterpret_cast<const uint8_t*>(envs->envs.get_ends());
+}
@@ -0,0 +1,134 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PLT_FRAME_SCHEDULER_H
+#define PLT_FRAME_SCHEDULER_H
+
+#ifdef PLATFORM_WIN32
+
+#include <windows.h>
+
+#endif
+
+#include <cstdint>
+#include <chrono>
+#include <util/histogram.h>
+#include <util/noncopyable.h>
+
+namespace plt
+{
+
+// Paces a loop at a fixed frame rate from a high resolution timer.
+//
+// wait() sleeps until the next frame is due and returns how many frames are due. After a
+// stall up to max_catch_up frames are returned at once, so the caller catches up without
+// spiraling, and the frames beyond that are dropped. Frames are scheduled from the start
+// time rather than the previous wake up, so the rate doesn't drift.
+//
+// The timer is a timerfd waited on with epoll on Linux and a high resolution waitable timer
+// on Win32, which also wakes up for window messages.
+class FrameScheduler : private utl::Noncopyable
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	FrameScheduler (uint32_t rate = 60, uint32_t max_catch_up = 4);
+
+	~FrameScheduler ();
+
+	// Returns the number of frames to run, which is 0 if woken up for something else.
+	uint32_t wait ();
+
+	// Schedules the next frame a period from now, e.g. after the loop was paused.
+	void restart ();
+
+	// The time between wake ups with due frames, in milliseconds.
+	inline const auto& get_frame_time_histogram () const noexcept
+	{
+		return frame_time_histogram_;
+	}
+
+	// How late the wake ups were against the schedule, in milliseconds.
+	inline const auto& get_jitter_histogram () const noexcept
+	{
+		return jitter_histogram_;
+	}
+
+	inline auto get_frame_count () const noexcept
+	{
+		return frame_count_;
+	}
+
+	inline auto get_dropped_frame_count () const noexcept
+	{
+		return dropped_frame_count_;
+	}
+
+	inline auto get_period () const noexcept
+	{
+		return period_;
+	}
+
+#ifdef PLATFORM_LINUX
+
+	// Readable when a frame is due, for callers with their own epoll loop.
+	inline auto get_timer_fd () const noexcept
+	{
+		return timer_fd_;
+	}
+
+#endif
+
+private:
+	void arm ();
+
+	bool sleep ();
+
+private:
+	Clock::duration   period_;
+	uint32_t          max_catch_up_;
+	Clock::time_point start_;
+	Clock::time_point last_wake_;
+	uint64_t          scheduled_;
+	uint64_t          frame_count_;
+	uint64_t          dropped_frame_count_;
+	utl::Histogram    frame_time_histogram_;
+	utl::Histogram    jitter_histogram_;
+
+#ifdef PLATFORM_LINUX
+
+	int               timer_fd_;
+	int               epoll_fd_;
+
+#endif
+
+#ifdef PLATFORM_WIN32
+
+	HANDLE            timer_;
+
+#endif
+
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PLT_HUD_H
+#define PLT_HUD_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <util/vec.hpp>
+
+namespace plt
+{
+
+class Pixmap;
+
+// Text drawn over a pixmap, e.g. performance numbers.
+//
+// The text is laid out with stb_easy_font, whose glyphs are made of axis aligned quads.
+// set_text rasterizes the quads into runs of pixels per row only when the text changes,
+// so draw does nothing but fill the cached runs into the pixmap.
+class Hud
+{
+	struct Span
+	{
+		int32_t y;
+		int32_t x0, x1;
+		uint8_t color;
+	};
+
+public:
+	Hud (const utl::Vec2<int32_t>& origin = { 4, 4 }, uint32_t scale = 1);
+
+	// Lays the text out again if it differs from the current one. Lines are split by '\n'.
+	void set_text (const char* text);
+
+	// Fills the text, with a shadow to be readable on any background, into a 24 bit pixmap.
+	void draw (Pixmap& pixmap) const;
+
+	inline const std::string& get_text () const noexcept
+	{
+		return text_;
+	}
+
+private:
+	utl::Vec2<int32_t>   origin_;
+	int32_t              scale_;
+	std::string          text_;
+	std::vector<float>   vertices_;
+	std::vector<uint8_t> mask_;
+	std::vector<Span>    spans_;
+};
+
+}
+
+#endif
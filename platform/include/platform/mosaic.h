@@ -0,0 +1,122 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PLT_MOSAIC_H
+#define PLT_MOSAIC_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <util/vec.hpp>
+
+namespace plt
+{
+
+class Pixmap;
+
+// Many screens tiled into one pixmap, e.g. every machine of a sweep.
+//
+//   auto mosaic = Mosaic({ 1280, 720 });
+//   for (auto i = 0u; i != count; ++i)
+//       mosaic.add_tile({ 64, 32 });
+//   mosaic.layout();
+//
+//   // Every frame.
+//   for (auto i = 0u; i != count; ++i)
+//       mosaic.draw_tile(pixmap, i, chips[i].get_frame_generation(), chips[i].get_vram().data());
+//
+// layout packs the tiles with stb_rect_pack at the largest integer scale that fits them
+// all. A tile is drawn only when its generation differs from the one drawn before, and
+// then only the rows that differ from the ones drawn: a row is expanded to the scale once
+// and copied to the rows it covers. So the pixmap has to keep what was drawn into it.
+class Mosaic
+{
+	struct Tile
+	{
+		utl::Vec2<uint32_t>  screen_size;
+		utl::Vec2<uint32_t>  origin;
+		bool                 shown;
+		uint64_t             generation;
+		bool                 drawn;
+		std::vector<uint8_t> pixels;
+	};
+
+public:
+	// The colors of the pixel values, which hold a bit a plane.
+	using Palette = std::array<utl::Vec3<uint8_t>, 4>;
+
+	explicit Mosaic (const utl::Vec2<uint32_t>& size, uint32_t gap = 1);
+
+	// Adds a tile for a screen of a size and returns its index. Takes effect on layout.
+	uint32_t add_tile (const utl::Vec2<uint32_t>& screen_size);
+
+	// Places the tiles, which are all drawn again. Returns false if they don't all fit at
+	// scale 1, and then the ones that don't aren't shown.
+	bool layout ();
+
+	void set_palette (const Palette& palette);
+
+	// Fills the pixmap with the background and makes every tile draw again.
+	void clear (Pixmap& pixmap);
+
+	// Draws the screen of a tile, a byte a pixel, unless its generation was drawn already.
+	void draw_tile (Pixmap& pixmap, uint32_t index, uint64_t generation, const uint8_t* pixels);
+
+	inline uint32_t get_scale () const noexcept
+	{
+		return scale_;
+	}
+
+	inline uint32_t get_tile_count () const noexcept
+	{
+		return static_cast<uint32_t>(tiles_.size());
+	}
+
+	// The rows drawn since the last call, to see what the mosaic costs.
+	uint64_t take_drawn_row_count () noexcept
+	{
+		const auto count = drawn_row_count_;
+		drawn_row_count_ = 0u;
+
+		return count;
+	}
+
+private:
+	bool pack (uint32_t scale);
+
+	// Makes the pixels a pixel value expands to at the scale.
+	void expand_palette ();
+
+private:
+	utl::Vec2<uint32_t>  size_;
+	uint32_t             gap_;
+	uint32_t             scale_;
+	Palette              palette_;
+	std::vector<uint8_t> expanded_;
+	std::vector<uint8_t> row_;
+	std::vector<Tile>    tiles_;
+	uint64_t             drawn_row_count_;
+};
+
+}
+
+#endif
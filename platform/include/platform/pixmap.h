@@ -24,6 +24,7 @@
 #define PLT_PIXMAP_H
 
 #include <cstdint>
+#include <vector>
 #include <util/vec.hpp>
 
 #ifdef PLATFORM_WIN32
@@ -42,7 +43,7 @@ public:
 
 	~Pixmap ();
 
-	void update (uint32_t size, void* data);
+	void update (uint32_t size, const void* data);
 
 	inline auto get_size() const noexcept
 	{
@@ -66,6 +67,14 @@ public:
 		return dib_ptr_;
 	}
 
+#else
+
+	// The 24 bit RGB pixels, which is all a pixmap is without a window system.
+	inline auto get_dib_ptr() noexcept
+	{
+		return static_cast<void*>(data_.data());
+	}
+
 #endif
 
 private:
@@ -77,6 +86,10 @@ private:
 	HBITMAP             bitmap_;
 	void*               dib_ptr_;
 
+#else
+
+	std::vector<uint8_t> data_;
+
 #endif
 
 };
@@ -0,0 +1,95 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PLT_PRESENT_CACHE_H
+#define PLT_PRESENT_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace plt
+{
+
+// The images presented lately, keyed by a hash of what they were made from, e.g. the
+// packed framebuffer of a machine.
+//
+// A still screen (a menu, a pause, a wait on the delay timer) presents the same image frame
+// after frame, so converting and scaling it again is wasted; with the cache it's a copy.
+//
+//   auto image = cache.find(hash);
+//   if (nullptr == image)
+//   {
+//       image = cache.insert(hash);
+//       // Scale the screen into image.
+//   }
+//
+// The images have one size. The least recently used one is replaced when the cache is full;
+// with a few images a linear search over the hashes is faster than any index.
+class PresentCache
+{
+	struct Entry
+	{
+		uint64_t hash;
+		uint64_t used;
+	};
+
+public:
+	PresentCache (uint32_t image_size, uint32_t capacity = 16u);
+
+	// Returns the image cached for the hash, which becomes the most recently used, or nullptr.
+	const uint8_t* find (uint64_t hash);
+
+	// Returns the storage of the least recently used image for the caller to fill, now cached
+	// for the hash.
+	uint8_t* insert (uint64_t hash);
+
+	// Forgets every image, e.g. when the output size or the palette changes.
+	void clear ();
+
+	inline auto get_image_size () const noexcept
+	{
+		return image_size_;
+	}
+
+	inline auto get_hit_count () const noexcept
+	{
+		return hit_count_;
+	}
+
+	inline auto get_miss_count () const noexcept
+	{
+		return miss_count_;
+	}
+
+private:
+	uint32_t             image_size_;
+	std::vector<Entry>   entries_;
+	std::vector<uint8_t> images_;
+	uint64_t             time_;
+	uint64_t             hit_count_;
+	uint64_t             miss_count_;
+};
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PLT_RESIZER_H
+#define PLT_RESIZER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <util/vec.hpp>
+#include <util/noncopyable.h>
+
+namespace plt
+{
+
+// Scales images with stb_image_resize, as stbir_resize_uint8 does.
+//
+// stb_image_resize allocates its working memory on every call. Here it's given the memory
+// kept from the resize before instead, which only grows when the sizes do, so scaling frame
+// after frame doesn't allocate.
+class Resizer : private utl::Noncopyable
+{
+public:
+	Resizer ();
+
+	// Scales an image of channels bytes a pixel, with rows of no padding, into output.
+	// Returns false if stb_image_resize fails.
+	bool resize (const uint8_t* input, const utl::Vec2<uint32_t>& input_size,
+	             uint8_t* output, const utl::Vec2<uint32_t>& output_size, uint32_t channels);
+
+	// The working memory stb_image_resize asks for. Called by it through STBIR_MALLOC.
+	void* allocate (size_t size);
+
+private:
+	std::vector<uint8_t> memory_;
+};
+
+}
+
+#endif
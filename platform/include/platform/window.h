@@ -34,6 +34,7 @@
 #include <util/vec.hpp>
 #include <util/signal.hpp>
 #include <util/singleton-factory.hpp>
+#include <platform/frame-scheduler.h>
 
 namespace plt
 {
@@ -46,13 +47,27 @@ class Window
 
 	using MsgSignalType = utl::Signal<void (void)>;
 
+	// The key and whether it went down. Keys are virtual key codes, which are the ASCII
+	// codes for the digits and the uppercase letters.
+	using KeySignalType = utl::Signal<void (uint32_t, bool)>;
+
 public:
 	~Window();
 
+	// Runs the frame loop until the window is closed. Every due frame emits the update
+	// signal, then the render signal is emitted once, so late frames are caught up
+	// without drawing each of them. The loop sleeps while no frame is due.
 	void receivce_msgs();
 
+	void close ();
+
 	void draw (Pixmap const& pixmap);
 
+	inline auto& update_signal() noexcept
+	{
+		return update_signal_;
+	}
+
 	inline auto& render_signal() noexcept
 	{
 		return render_signal_;
@@ -63,6 +78,11 @@ public:
 		return resize_signal_;
 	}
 
+	inline auto& key_signal() noexcept
+	{
+		return key_signal_;
+	}
+
 	inline const std::string& get_title() const noexcept
 	{
 		return title_;
@@ -73,6 +93,11 @@ public:
 		return size_;
 	}
 
+	inline const FrameScheduler& get_scheduler() const noexcept
+	{
+		return scheduler_;
+	}
+
 #ifdef PLATFORM_WIN32
 
 	inline auto get_wnd() const noexcept
@@ -90,10 +115,16 @@ public:
 private:
 	Window(const std::string& title, const utl::Vec2<uint32_t>& size);
 
+	bool dispatch_msgs ();
+
 	std::string            title_;
 	utl::Vec2<uint32_t>    size_;
+	MsgSignalType          update_signal_;
 	MsgSignalType          render_signal_;
 	MsgSignalType          resize_signal_;
+	KeySignalType          key_signal_;
+	FrameScheduler         scheduler_;
+	bool                   closed_;
 
 #ifdef PLATFORM_WIN32
 
@@ -42,12 +42,14 @@ HINSTANCE get_current_instance ()
 }
 
 Display::Display ()
-	:
+
 #ifdef PLATFORM_WIN32
 
+	:
 	instance_(get_current_instance())
 
 #endif
+
 {
 }
 
@@ -0,0 +1,263 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "platform/frame-scheduler.h"
+
+#include <cassert>
+#include <algorithm>
+
+#if defined(PLATFORM_LINUX)
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#elif !defined(PLATFORM_WIN32)
+
+#include <thread>
+
+#endif
+
+namespace plt
+{
+
+namespace
+{
+
+constexpr auto kFrameTimeBucketWidth = 0.1;  // ms
+constexpr auto kFrameTimeBucketCount = 500u;
+constexpr auto kJitterBucketWidth    = 0.05; // ms
+constexpr auto kJitterBucketCount    = 200u;
+
+FrameScheduler::Clock::duration to_period (uint32_t rate)
+{
+	return std::chrono::duration_cast<FrameScheduler::Clock::duration>(std::chrono::seconds(1)) / rate;
+}
+
+template <typename Duration>
+double to_milliseconds (Duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+FrameScheduler::FrameScheduler (uint32_t rate, uint32_t max_catch_up)
+	:
+	period_              (to_period(rate)                          ),
+	max_catch_up_        (max_catch_up                             ),
+	start_               (Clock::now()                             ),
+	last_wake_           (start_                                   ),
+	scheduled_           (0u                                       ),
+	frame_count_         (0u                                       ),
+	dropped_frame_count_ (0u                                       ),
+	frame_time_histogram_(kFrameTimeBucketWidth, kFrameTimeBucketCount),
+	jitter_histogram_    (kJitterBucketWidth, kJitterBucketCount   )
+
+#ifdef PLATFORM_LINUX
+
+	,
+	timer_fd_            (-1                                       ),
+	epoll_fd_            (-1                                       )
+
+#endif
+
+#ifdef PLATFORM_WIN32
+
+	,
+	timer_               (NULL                                     )
+
+#endif
+
+{
+	assert
+	(
+		rate > 0 && max_catch_up > 0 && "Invalid frame rate!!!"
+	);
+
+#ifdef PLATFORM_LINUX
+
+	timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	assert
+	(
+		-1 != timer_fd_ && "Fail to create the timerfd!!!"
+	);
+
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	assert
+	(
+		-1 != epoll_fd_ && "Fail to create the epoll!!!"
+	);
+
+	auto event = epoll_event { };
+	event.events  = EPOLLIN;
+	event.data.fd = timer_fd_;
+
+	[[maybe_unused]] const auto result = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event);
+	assert
+	(
+		0 == result && "Fail to add the timerfd to the epoll!!!"
+	);
+
+#endif
+
+#ifdef PLATFORM_WIN32
+
+	// High resolution timers exist since Windows 10 1803, older ones tick at the timer resolution.
+	timer_ = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (NULL == timer_)
+		timer_ = CreateWaitableTimer(NULL, FALSE, NULL);
+	assert
+	(
+		NULL != timer_ && "Fail to create the waitable timer!!!"
+	);
+
+#endif
+
+	restart();
+}
+
+FrameScheduler::~FrameScheduler ()
+{
+
+#ifdef PLATFORM_LINUX
+
+	close(epoll_fd_);
+	close(timer_fd_);
+
+#endif
+
+#ifdef PLATFORM_WIN32
+
+	CloseHandle(timer_);
+
+#endif
+
+}
+
+uint32_t FrameScheduler::wait ()
+{
+	const auto woken = sleep();
+	const auto now   = Clock::now();
+	const auto due   = static_cast<uint64_t>((now - start_) / period_);
+
+	if (!woken || due <= scheduled_)
+		return 0;
+
+	const auto frames = static_cast<uint32_t>(std::min<uint64_t>(due - scheduled_, max_catch_up_));
+
+	dropped_frame_count_ += due - scheduled_ - frames;
+	frame_count_         += frames;
+	scheduled_            = due;
+
+	frame_time_histogram_.add(to_milliseconds(now - last_wake_));
+	jitter_histogram_.add(to_milliseconds(now - (start_ + period_ * due)));
+	last_wake_ = now;
+
+	return frames;
+}
+
+void FrameScheduler::restart ()
+{
+	start_     = Clock::now();
+	last_wake_ = start_;
+	scheduled_ = 0u;
+
+	arm();
+}
+
+void FrameScheduler::arm ()
+{
+
+#if defined(PLATFORM_LINUX)
+
+	// steady_clock is CLOCK_MONOTONIC, so the timer runs on the same schedule as start_.
+	const auto to_timespec = [] (Clock::duration duration)
+	{
+		const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+
+		return timespec
+		{
+			static_cast<time_t>(seconds.count()),
+			static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration - seconds).count())
+		};
+	};
+
+	const auto spec = itimerspec
+	{
+		to_timespec(period_),                              // it_interval
+		to_timespec((start_ + period_).time_since_epoch()) // it_value
+	};
+
+	[[maybe_unused]] const auto result = timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+	assert
+	(
+		0 == result && "Fail to arm the timerfd!!!"
+	);
+
+#elif defined(PLATFORM_WIN32)
+
+	// A relative due time in 100 ns units, negative by the convention of SetWaitableTimer.
+	const auto next  = start_ + period_ * (scheduled_ + 1);
+	const auto delay = std::max(next - Clock::now(), Clock::duration::zero());
+
+	auto due = LARGE_INTEGER { };
+	due.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count() / 100);
+
+	SetWaitableTimer(timer_, &due, 0, NULL, NULL, FALSE);
+
+#endif
+
+}
+
+bool FrameScheduler::sleep ()
+{
+
+#if defined(PLATFORM_LINUX)
+
+	auto event = epoll_event { };
+	if (epoll_wait(epoll_fd_, &event, 1, -1) <= 0)
+		return false;
+
+	// Only clears the timerfd, the due frames are counted from the clock.
+	auto expirations = uint64_t { 0 };
+	read(timer_fd_, &expirations, sizeof(expirations));
+
+	return true;
+
+#elif defined(PLATFORM_WIN32)
+
+	arm();
+
+	return WAIT_OBJECT_0 == MsgWaitForMultipleObjects(1, &timer_, FALSE, INFINITE, QS_ALLINPUT);
+
+#else
+
+	std::this_thread::sleep_until(start_ + period_ * (scheduled_ + 1));
+
+	return true;
+
+#endif
+
+}
+
+}
@@ -0,0 +1,168 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <platform/hud.h>
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <platform/pixmap.h>
+
+// The spacing is left as is, so stb_easy_font_spacing is never called.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+
+#include <stb/stb_easy_font.h>
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace plt
+{
+
+namespace
+{
+
+// stb_easy_font writes 4 vertices a quad, each x, y, z and a 4 byte color.
+constexpr auto kVertexSize = 4u;
+constexpr auto kQuadSize   = 4u * kVertexSize;
+
+// It needs about 270 bytes a character.
+constexpr auto kBytesPerCharacter = 270u;
+
+// What the mask holds for a pixel.
+constexpr uint8_t kEmpty  = 0u;
+constexpr uint8_t kShadow = 1u;
+constexpr uint8_t kText   = 2u;
+
+constexpr uint8_t kColors[] = { 0x00, 0x00, 0xFF };
+
+}
+
+Hud::Hud (const utl::Vec2<int32_t>& origin, uint32_t scale)
+	:
+	origin_  (origin                     ),
+	scale_   (static_cast<int32_t>(scale)),
+	text_    (                           ),
+	vertices_(                           ),
+	mask_    (                           ),
+	spans_   (                           )
+{
+	assert(scale != 0 && "The scale must be positive!!!");
+}
+
+void Hud::set_text (const char* text)
+{
+	if (text_ == text)
+		return;
+
+	text_ = text;
+
+	// stb_easy_font takes a mutable string, and only knows printable ASCII.
+	auto buffer = std::vector<char>(text_.begin(), text_.end());
+	for (auto& c : buffer)
+	{
+		if ('\n' != c && (c < 32 || c > 126))
+			c = '?';
+	}
+	buffer.push_back('\0');
+
+	vertices_.resize(buffer.size() * kBytesPerCharacter / sizeof(float));
+
+	const auto quad_count = stb_easy_font_print(0.0f, 0.0f, buffer.data(), nullptr,
+	                                            vertices_.data(),
+	                                            static_cast<int>(vertices_.size() * sizeof(float)));
+
+	// The quads overlap and are a few pixels each, so they're merged in a mask of the text's
+	// bounds (plus the shadow) and the mask is stored as runs.
+	const auto width  = (stb_easy_font_width (buffer.data()) + 1) * scale_;
+	const auto height = (stb_easy_font_height(buffer.data()) + 1) * scale_;
+
+	mask_.assign(width * height, kEmpty);
+
+	const auto fill = [&](int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t value)
+	{
+		for (auto y = y0; y < std::min(y1, height); ++y)
+		{
+			for (auto x = x0; x < std::min(x1, width); ++x)
+				mask_[y * width + x] = std::max(mask_[y * width + x], value);
+		}
+	};
+
+	for (auto i = 0; i != quad_count; ++i)
+	{
+		// The first and the third vertex are the opposite corners.
+		const auto quad = vertices_.data() + i * kQuadSize;
+		const auto x0   = static_cast<int32_t>(quad[0                ]) * scale_;
+		const auto y0   = static_cast<int32_t>(quad[1                ]) * scale_;
+		const auto x1   = static_cast<int32_t>(quad[2 * kVertexSize    ]) * scale_;
+		const auto y1   = static_cast<int32_t>(quad[2 * kVertexSize + 1]) * scale_;
+
+		fill(x0 + scale_, y0 + scale_, x1 + scale_, y1 + scale_, kShadow);
+		fill(x0,          y0,          x1,          y1,          kText  );
+	}
+
+	spans_.clear();
+	for (auto y = 0; y != height; ++y)
+	{
+		const auto row = mask_.data() + y * width;
+
+		for (auto x = 0; x != width;)
+		{
+			const auto value = row[x];
+
+			auto end = x + 1;
+			while (end != width && row[end] == value)
+				++end;
+
+			if (kEmpty != value)
+				spans_.push_back({ origin_.y + y, origin_.x + x, origin_.x + end, kColors[value] });
+
+			x = end;
+		}
+	}
+}
+
+void Hud::draw (Pixmap& pixmap) const
+{
+	const auto size   = pixmap.get_size();
+	const auto pixels = static_cast<uint8_t*>(pixmap.get_dib_ptr());
+	const auto width  = static_cast<int32_t>(size.width);
+	const auto height = static_cast<int32_t>(size.height);
+
+	for (const auto& span : spans_)
+	{
+		if (span.y < 0 || span.y >= height)
+			continue;
+
+		const auto x0 = std::max(span.x0, 0);
+		const auto x1 = std::min(span.x1, width);
+
+		if (x0 < x1)
+			std::memset(pixels + (span.y * width + x0) * 3, span.color, (x1 - x0) * 3);
+	}
+}
+
+}
@@ -0,0 +1,219 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define STB_RECT_PACK_IMPLEMENTATION
+
+#include <platform/mosaic.h>
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <stb/stb_rect_pack.h>
+#include <platform/pixmap.h>
+
+namespace plt
+{
+
+namespace
+{
+
+// Between the tiles, to tell them apart from the black of the screens.
+constexpr uint8_t kGapColor = 0x30;
+
+}
+
+Mosaic::Mosaic (const utl::Vec2<uint32_t>& size, uint32_t gap)
+	:
+	size_           (size),
+	gap_            (gap ),
+	scale_          (0u  ),
+	palette_        {    },
+	expanded_       (    ),
+	row_            (    ),
+	tiles_          (    ),
+	drawn_row_count_(0u  )
+{
+	// None, the first plane, the second plane and both.
+	palette_[0] = { 0x00, 0x00, 0x00 };
+	palette_[1] = { 0xFF, 0xFF, 0xFF };
+	palette_[2] = { 0xFF, 0x40, 0x40 };
+	palette_[3] = { 0xFF, 0xD0, 0x40 };
+}
+
+uint32_t Mosaic::add_tile (const utl::Vec2<uint32_t>& screen_size)
+{
+	tiles_.push_back({ screen_size, { 0, 0 }, false, 0u, false, std::vector<uint8_t>(screen_size.width * screen_size.height) });
+
+	return static_cast<uint32_t>(tiles_.size() - 1);
+}
+
+bool Mosaic::layout ()
+{
+	scale_ = 0u;
+	if (tiles_.empty())
+		return true;
+
+	auto max_scale = ~0u;
+	auto max_width = 0u;
+	for (const auto& tile : tiles_)
+	{
+		max_scale = std::min({ max_scale, size_.width / tile.screen_size.width, size_.height / tile.screen_size.height });
+		max_width = std::max(max_width, tile.screen_size.width);
+	}
+
+	// A smaller scale fits whatever a larger one does, so the first that fits is the largest.
+	// At scale 1 the tiles that fit are shown even if not all do.
+	auto fits = false;
+	for (auto scale = std::max(max_scale, 1u); scale != 0 && !fits; --scale)
+	{
+		fits   = pack(scale);
+		scale_ = scale;
+	}
+
+	row_.resize(max_width * scale_ * 3);
+	expand_palette();
+
+	for (auto& tile : tiles_)
+		tile.drawn = false;
+
+	return fits;
+}
+
+void Mosaic::set_palette (const Palette& palette)
+{
+	palette_ = palette;
+	expand_palette();
+
+	for (auto& tile : tiles_)
+		tile.drawn = false;
+}
+
+void Mosaic::clear (Pixmap& pixmap)
+{
+	assert(pixmap.get_size().width == size_.width && pixmap.get_size().height == size_.height && "The pixmap isn't the mosaic's size!!!");
+
+	std::memset(pixmap.get_dib_ptr(), kGapColor, size_.width * size_.height * 3);
+
+	for (auto& tile : tiles_)
+		tile.drawn = false;
+}
+
+void Mosaic::draw_tile (Pixmap& pixmap, uint32_t index, uint64_t generation, const uint8_t* pixels)
+{
+	assert(index < tiles_.size() && "The tile doesn't exist!!!");
+	assert(pixmap.get_size().width == size_.width && pixmap.get_size().height == size_.height && "The pixmap isn't the mosaic's size!!!");
+
+	auto& tile = tiles_[index];
+	if (!tile.shown || (tile.drawn && tile.generation == generation))
+		return;
+
+	const auto width      = tile.screen_size.width;
+	const auto pixel_size = scale_ * 3;
+	const auto row_size   = width * pixel_size;
+	const auto stride     = size_.width * 3;
+	const auto target     = static_cast<uint8_t*>(pixmap.get_dib_ptr()) + tile.origin.y * stride + tile.origin.x * 3;
+
+	for (auto y = 0u; y != tile.screen_size.height; ++y)
+	{
+		const auto source = pixels + y * width;
+		const auto drawn  = tile.pixels.data() + y * width;
+
+		if (tile.drawn && std::memcmp(source, drawn, width) == 0)
+			continue;
+
+		std::memcpy(drawn, source, width);
+
+		// A run of a color is its first pixel copied onto the rest, doubling what's copied.
+		for (auto x = 0u; x != width; )
+		{
+			const auto value = source[x] & 0x3;
+
+			auto end = x + 1;
+			while (end != width && (source[end] & 0x3) == value)
+				++end;
+
+			const auto run  = row_.data() + x * pixel_size;
+			const auto size = (end - x) * pixel_size;
+
+			std::memcpy(run, expanded_.data() + value * pixel_size, pixel_size);
+			for (auto filled = pixel_size; filled < size; filled *= 2)
+				std::memcpy(run + filled, run, std::min(filled, size - filled));
+
+			x = end;
+		}
+
+		for (auto i = 0u; i != scale_; ++i)
+			std::memcpy(target + (y * scale_ + i) * stride, row_.data(), row_size);
+
+		++drawn_row_count_;
+	}
+
+	tile.generation = generation;
+	tile.drawn      = true;
+}
+
+bool Mosaic::pack (uint32_t scale)
+{
+	// The gap is to the right and below every tile, so the target is larger by one gap.
+	const auto width  = static_cast<int>(size_.width  + gap_);
+	const auto height = static_cast<int>(size_.height + gap_);
+
+	auto context = stbrp_context { };
+	auto nodes   = std::vector<stbrp_node>(width);
+	stbrp_init_target(&context, width, height, nodes.data(), width);
+
+	auto rects = std::vector<stbrp_rect>(tiles_.size());
+	for (auto i = 0u; i != tiles_.size(); ++i)
+	{
+		rects[i].id = static_cast<int>(i);
+		rects[i].w  = static_cast<stbrp_coord>(tiles_[i].screen_size.width  * scale + gap_);
+		rects[i].h  = static_cast<stbrp_coord>(tiles_[i].screen_size.height * scale + gap_);
+	}
+
+	const auto fits = 0 != stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size()));
+
+	for (auto i = 0u; i != tiles_.size(); ++i)
+	{
+		tiles_[i].origin = { rects[i].x, rects[i].y };
+		tiles_[i].shown  = 0 != rects[i].was_packed;
+	}
+
+	return fits;
+}
+
+void Mosaic::expand_palette ()
+{
+	const auto pixel_size = scale_ * 3;
+
+	expanded_.resize(palette_.size() * pixel_size);
+	for (auto i = 0u; i != palette_.size(); ++i)
+	{
+		for (auto j = 0u; j != scale_; ++j)
+		{
+			expanded_[i * pixel_size + j * 3 + 0] = palette_[i].x;
+			expanded_[i * pixel_size + j * 3 + 1] = palette_[i].y;
+			expanded_[i * pixel_size + j * 3 + 2] = palette_[i].z;
+		}
+	}
+}
+
+}
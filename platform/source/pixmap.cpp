@@ -22,6 +22,7 @@
 
 #include <platform/pixmap.h>
 
+#include <cstring>
 #include <util/singleton.hpp>
 #include <platform/window.h>
 
@@ -31,10 +32,23 @@ namespace plt
 Pixmap::Pixmap (const utl::Vec2<uint32_t> size)
 	:
 	size_   (size),
-	bitmap_ (NULL),
+
+#ifdef PLATFORM_WIN32
+
 	dc_     (NULL),
+	bitmap_ (NULL),
 	dib_ptr_(NULL)
+
+#else
+
+	data_   (size.width * size.height * 3)
+
+#endif
+
 {
+
+#ifdef PLATFORM_WIN32
+
 	dc_ = CreateCompatibleDC(utl::Singleton<plt::Window>::get().get_dc());
 
 	const auto bitmap_info = BITMAPINFO
@@ -51,17 +65,36 @@ Pixmap::Pixmap (const utl::Vec2<uint32_t> size)
 	};
 
 	bitmap_ = CreateDIBSection(dc_, &bitmap_info, DIB_RGB_COLORS, &dib_ptr_, nullptr, 0);
+
+#endif
+
 }
 
 Pixmap::~Pixmap ()
 {
+
+#ifdef PLATFORM_WIN32
+
 	DeleteObject(bitmap_);
 	DeleteDC(dc_);
+
+#endif
+
 }
 
-void Pixmap::update (uint32_t size, void* data)
+void Pixmap::update (uint32_t size, const void* data)
 {
+
+#ifdef PLATFORM_WIN32
+
 	memcpy(dib_ptr_, data, size);
+
+#else
+
+	memcpy(data_.data(), data, size);
+
+#endif
+
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <platform/present-cache.h>
+
+#include <cassert>
+
+namespace plt
+{
+
+namespace
+{
+
+// When an entry was used last. An entry never used is older than every other.
+constexpr auto kNeverUsed = uint64_t { 0 };
+
+}
+
+PresentCache::PresentCache (uint32_t image_size, uint32_t capacity)
+	:
+	image_size_(image_size                                ),
+	entries_   (capacity, Entry { 0u, kNeverUsed }        ),
+	images_    (static_cast<size_t>(image_size) * capacity),
+	time_      (kNeverUsed                                ),
+	hit_count_ (0u                                        ),
+	miss_count_(0u                                        )
+{
+	assert(capacity != 0 && "The cache must hold an image!!!");
+}
+
+const uint8_t* PresentCache::find (uint64_t hash)
+{
+	for (auto i = 0u; i != entries_.size(); ++i)
+	{
+		auto& entry = entries_[i];
+		if (kNeverUsed != entry.used && hash == entry.hash)
+		{
+			entry.used = ++time_;
+			++hit_count_;
+
+			return images_.data() + static_cast<size_t>(image_size_) * i;
+		}
+	}
+
+	++miss_count_;
+
+	return nullptr;
+}
+
+uint8_t* PresentCache::insert (uint64_t hash)
+{
+	auto oldest = 0u;
+	for (auto i = 1u; i != entries_.size(); ++i)
+	{
+		if (entries_[i].used < entries_[oldest].used)
+			oldest = i;
+	}
+
+	entries_[oldest] = Entry { hash, ++time_ };
+
+	return images_.data() + static_cast<size_t>(image_size_) * oldest;
+}
+
+void PresentCache::clear ()
+{
+	for (auto& entry : entries_)
+		entry.used = kNeverUsed;
+}
+
+}
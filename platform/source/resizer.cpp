@@ -0,0 +1,70 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <platform/resizer.h>
+
+// The working memory comes from the Resizer passed as the context, and stays with it.
+#define STBIR_MALLOC(size, context) (static_cast<plt::Resizer*>(context)->allocate(size))
+#define STBIR_FREE(ptr, context)    ((void)(ptr), (void)(context))
+
+#include <stb/stb_image_resize.h>
+
+namespace plt
+{
+
+Resizer::Resizer ()
+	:
+	memory_()
+{
+}
+
+bool Resizer::resize (const uint8_t* input, const utl::Vec2<uint32_t>& input_size,
+                      uint8_t* output, const utl::Vec2<uint32_t>& output_size, uint32_t channels)
+{
+	const auto result = stbir_resize_uint8_generic(input,
+	                                               static_cast<int>(input_size.width),
+	                                               static_cast<int>(input_size.height),
+	                                               static_cast<int>(input_size.width * channels),
+	                                               output,
+	                                               static_cast<int>(output_size.width),
+	                                               static_cast<int>(output_size.height),
+	                                               static_cast<int>(output_size.width * channels),
+	                                               static_cast<int>(channels),
+	                                               STBIR_ALPHA_CHANNEL_NONE,
+	                                               0,
+	                                               STBIR_EDGE_CLAMP,
+	                                               STBIR_FILTER_DEFAULT,
+	                                               STBIR_COLORSPACE_LINEAR,
+	                                               this);
+
+	return 0 != result;
+}
+
+void* Resizer::allocate (size_t size)
+{
+	if (memory_.size() < size)
+		memory_.resize(size);
+
+	return memory_.data();
+}
+
+}
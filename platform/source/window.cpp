@@ -23,7 +23,9 @@
 #include "platform/window.h"
 
 #include <cassert>
+#include <csignal>
 #include <cstdlib>
+#include <util/tracing.h>
 
 #include "platform/display.h"
 #include "platform/pixmap.h"
@@ -45,9 +47,12 @@ LRESULT CALLBACK wnd_proc (HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
 	{
 	case WM_DESTROY:
 		PostQuitMessage(0);
+		return 0;
 
 	case WM_PAINT:
-		windowPtr->render_signal().emit();
+		// Frames are drawn by the frame loop. An invalid region left as is makes Windows
+		// send WM_PAINT over and over, which used to spin the message loop.
+		ValidateRect(wnd, NULL);
 		return 0;
 
 	case WM_SIZE:
@@ -60,6 +65,14 @@ LRESULT CALLBACK wnd_proc (HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
 			const auto result = PostMessage(wnd, WM_CLOSE, 0, 0);
 			assert(result != 0);
 		}
+		else
+		{
+			windowPtr->key_signal().emit(static_cast<uint32_t>(wparam), true);
+		}
+		return 0;
+
+	case WM_KEYUP:
+		windowPtr->key_signal().emit(static_cast<uint32_t>(wparam), false);
 		return 0;
 
 	default:
@@ -122,6 +135,16 @@ std::string generate_class_name ()
 	return encode_to_utf8(class_name);
 }
 
+#else
+
+// Without a window system nothing closes the window but this, on SIGINT or SIGTERM.
+volatile std::sig_atomic_t interrupted = 0;
+
+void interrupt (int)
+{
+	interrupted = 1;
+}
+
 #endif
 
 }
@@ -141,18 +164,98 @@ Window::~Window ()
 
 void Window::receivce_msgs ()
 {
+
+#ifdef PLATFORM_WIN32
+
 	ShowWindow(wnd_, SW_SHOW);
 
+#else
+
+	interrupted = 0;
+
+	const auto previous_int  = std::signal(SIGINT,  interrupt);
+	const auto previous_term = std::signal(SIGTERM, interrupt);
+
+#endif
+
+	closed_ = false;
+	scheduler_.restart();
+
+	while (dispatch_msgs())
+	{
+		auto frames = 0u;
+		{
+			UTL_TRACE_SCOPE("platform", "wait");
+			frames = scheduler_.wait();
+		}
+
+		if (0 == frames)
+			continue;
+
+		for (auto i = 0u; i != frames; ++i)
+		{
+			UTL_TRACE_SCOPE("platform", "update");
+			update_signal_.emit();
+		}
+
+		UTL_TRACE_SCOPE("platform", "render");
+		render_signal_.emit();
+	}
+
+#ifndef PLATFORM_WIN32
+
+	std::signal(SIGINT,  previous_int);
+	std::signal(SIGTERM, previous_term);
+
+#endif
+
+}
+
+void Window::close ()
+{
+
+#ifdef PLATFORM_WIN32
+
+	[[maybe_unused]] const auto result = PostMessage(wnd_, WM_CLOSE, 0, 0);
+	assert(result != 0);
+
+#else
+
+	closed_ = true;
+
+#endif
+
+}
+
+bool Window::dispatch_msgs ()
+{
+
+#ifdef PLATFORM_WIN32
+
 	MSG msg;
-	while (GetMessage(&msg, NULL, 0, 0))
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 	{
+		if (WM_QUIT == msg.message)
+			return false;
+
 		TranslateMessage(&msg);
 		DispatchMessage(&msg);
 	}
+
+	return true;
+
+#else
+
+	// There's nothing to dispatch without a window system (headless).
+	return !closed_ && !interrupted;
+
+#endif
+
 }
 
-void Window::draw (Pixmap const& pixmap)
+void Window::draw ([[maybe_unused]] Pixmap const& pixmap)
 {
+	UTL_TRACE_SCOPE("platform", "present");
 
 #ifdef PLATFORM_WIN32
 
@@ -167,11 +270,16 @@ Window::Window (const std::string& title, const utl::Vec2<uint32_t>& size)
 	:
 	title_        (title                ),
 	size_         (size                 ),
+	update_signal_(                     ),
 	render_signal_(                     ),
 	resize_signal_(                     ),
+	key_signal_   (                     ),
+	scheduler_    (                     ),
+	closed_       (false                )
 
 #ifdef PLATFORM_WIN32
 
+	,
 	class_name_   (generate_class_name()),
 	atom_         (NULL                 ),
 	wnd_          (NULL                 ),
@@ -0,0 +1,346 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef UTL_ALLOCATION_COUNTER_H
+#define UTL_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <atomic>
+
+#include "noncopyable.h"
+#include "nonmovable.h"
+
+namespace utl
+{
+
+// Counts heap allocations and bytes by subsystem, to prove a loop doesn't allocate.
+//
+//   {
+//       UTL_ALLOCATION_SCOPE("chip-8");
+//       ...
+//   }
+//   const auto counts = utl::AllocationCounter::get_counts(utl::AllocationCounter::get_subsystem("chip-8"));
+//
+// Counting is a build mode: with UTL_COUNT_ALLOCATIONS defined (the UTIL_COUNT_ALLOCATIONS
+// CMake option) the one source file of a program that defines
+// UTL_ALLOCATION_COUNTER_IMPLEMENTATION before including this header replaces the global
+// operator new and delete. Otherwise nothing is counted and the scopes compile away.
+//
+// Allocations outside of any scope are counted under "other". Only operator new is seen,
+// not malloc, e.g. of stb_image_resize.
+class AllocationCounter : private Noncopyable, private Nonmovable
+{
+public:
+	static constexpr auto kMaxSubsystemCount = 16u;
+
+	// The subsystem of the allocations outside of any scope.
+	static constexpr auto kOther = 0u;
+
+	struct Counts
+	{
+		uint64_t allocations;
+		uint64_t bytes;
+	};
+
+	static constexpr bool is_enabled () noexcept
+	{
+
+#ifdef UTL_COUNT_ALLOCATIONS
+
+		return true;
+
+#else
+
+		return false;
+
+#endif
+
+	}
+
+	// Finds the subsystem by name, adding it the first time. When every slot is taken the
+	// allocations go to "other".
+	static uint32_t get_subsystem (const char* name) noexcept
+	{
+		for (auto i = kOther + 1; i != kMaxSubsystemCount; ++i)
+		{
+			auto current = slots_[i].name.load(std::memory_order_acquire);
+			if (nullptr == current && slots_[i].name.compare_exchange_strong(current, name, std::memory_order_acq_rel))
+				return i;
+
+			if (0 == std::strcmp(current, name))
+				return i;
+		}
+
+		return kOther;
+	}
+
+	static const char* get_name (uint32_t subsystem) noexcept
+	{
+		return kOther == subsystem ? "other" : slots_[subsystem].name.load(std::memory_order_acquire);
+	}
+
+	static Counts get_counts (uint32_t subsystem) noexcept
+	{
+		return Counts {
+			slots_[subsystem].allocations.load(std::memory_order_relaxed),
+			slots_[subsystem].bytes      .load(std::memory_order_relaxed)
+		};
+	}
+
+	static Counts get_total () noexcept
+	{
+		auto total = Counts { 0u, 0u };
+		for (auto i = 0u; i != kMaxSubsystemCount; ++i)
+		{
+			const auto counts = get_counts(i);
+
+			total.allocations += counts.allocations;
+			total.bytes       += counts.bytes;
+		}
+
+		return total;
+	}
+
+	// The subsystem the calling thread allocates for.
+	static uint32_t& current () noexcept
+	{
+		thread_local uint32_t subsystem = kOther;
+		return subsystem;
+	}
+
+	static void record (size_t size) noexcept
+	{
+		auto& slot = slots_[current()];
+
+		slot.allocations.fetch_add(1u,   std::memory_order_relaxed);
+		slot.bytes      .fetch_add(size, std::memory_order_relaxed);
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<const char*> name;
+		std::atomic<uint64_t>    allocations;
+		std::atomic<uint64_t>    bytes;
+	};
+
+	static inline std::array<Slot, kMaxSubsystemCount> slots_ = {};
+};
+
+// Counts the allocations of its lifetime on the calling thread for a subsystem.
+class AllocationScope : private Noncopyable, private Nonmovable
+{
+public:
+	explicit AllocationScope (uint32_t subsystem) noexcept
+		:
+		previous_(AllocationCounter::current())
+	{
+		AllocationCounter::current() = subsystem;
+	}
+
+	~AllocationScope () noexcept
+	{
+		AllocationCounter::current() = previous_;
+	}
+
+private:
+	uint32_t previous_;
+};
+
+}
+
+#define UTL_ALLOCATION_CONCAT_IMPL(a, b) a##b
+#define UTL_ALLOCATION_CONCAT(a, b)      UTL_ALLOCATION_CONCAT_IMPL(a, b)
+
+#ifdef UTL_COUNT_ALLOCATIONS
+
+// The subsystem is looked up once per scope site.
+#define UTL_ALLOCATION_SUBSYSTEM UTL_ALLOCATION_CONCAT(utl_allocation_subsystem_, __LINE__)
+#define UTL_ALLOCATION_SCOPE(name)                                                             \
+	static const auto UTL_ALLOCATION_SUBSYSTEM = utl::AllocationCounter::get_subsystem(name); \
+	const utl::AllocationScope UTL_ALLOCATION_CONCAT(utl_allocation_scope_, __LINE__)(UTL_ALLOCATION_SUBSYSTEM)
+
+#else
+
+#define UTL_ALLOCATION_SCOPE(name)
+
+#endif
+
+#endif
+
+#if defined(UTL_ALLOCATION_COUNTER_IMPLEMENTATION) && defined(UTL_COUNT_ALLOCATIONS) && !defined(UTL_ALLOCATION_COUNTER_IMPLEMENTED)
+#define UTL_ALLOCATION_COUNTER_IMPLEMENTED
+
+#include <cstdlib>
+#include <new>
+
+namespace utl
+{
+namespace detail
+{
+
+inline void* counted_allocate (size_t size) noexcept
+{
+	utl::AllocationCounter::record(size);
+	return std::malloc(0 == size ? 1 : size);
+}
+
+inline void* counted_allocate (size_t size, std::align_val_t alignment) noexcept
+{
+	utl::AllocationCounter::record(size);
+
+	const auto align = static_cast<size_t>(alignment);
+
+#ifdef _WIN32
+
+	return _aligned_malloc(0 == size ? 1 : size, align);
+
+#else
+
+	// aligned_alloc wants a multiple of the alignment.
+	return std::aligned_alloc(align, ((0 == size ? 1 : size) + align - 1) / align * align);
+
+#endif
+
+}
+
+inline void counted_free (void* pointer, std::align_val_t) noexcept
+{
+
+#ifdef _WIN32
+
+	_aligned_free(pointer);
+
+#else
+
+	std::free(pointer);
+
+#endif
+
+}
+
+}
+}
+
+void* operator new (size_t size)
+{
+	const auto pointer = utl::detail::counted_allocate(size);
+	if (nullptr == pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[] (size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new (size_t size, const std::nothrow_t&) noexcept
+{
+	return utl::detail::counted_allocate(size);
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept
+{
+	return utl::detail::counted_allocate(size);
+}
+
+void* operator new (size_t size, std::align_val_t alignment)
+{
+	const auto pointer = utl::detail::counted_allocate(size, alignment);
+	if (nullptr == pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[] (size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return utl::detail::counted_allocate(size, alignment);
+}
+
+void* operator new[] (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return utl::detail::counted_allocate(size, alignment);
+}
+
+// GCC sees free() of what the operator new above returns, which is what it allocated with.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete (void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[] (void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete (void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[] (void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete (void* pointer, std::align_val_t alignment) noexcept
+{
+	utl::detail::counted_free(pointer, alignment);
+}
+
+void operator delete[] (void* pointer, std::align_val_t alignment) noexcept
+{
+	utl::detail::counted_free(pointer, alignment);
+}
+
+void operator delete (void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+	utl::detail::counted_free(pointer, alignment);
+}
+
+void operator delete[] (void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+	utl::detail::counted_free(pointer, alignment);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef UTL_HISTOGRAM_H
+#define UTL_HISTOGRAM_H
+
+#include <cstdint>
+#include <cassert>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+namespace utl
+{
+
+// Counts samples in buckets of a fixed width starting at zero.
+// The last bucket also counts every sample above the range.
+class Histogram
+{
+public:
+	Histogram (double bucket_width, uint32_t bucket_count)
+		:
+		bucket_width_(bucket_width                         ),
+		buckets_     (bucket_count, 0u                     ),
+		count_       (0u                                   ),
+		sum_         (0.0                                  ),
+		min_         (std::numeric_limits<double>::max()   ),
+		max_         (std::numeric_limits<double>::lowest())
+	{
+		assert
+		(
+			bucket_width > 0.0 && bucket_count > 0 && "Invalid histogram!!!"
+		);
+	}
+
+	void add (double sample) noexcept
+	{
+		const auto index = sample <= 0.0 ? 0u : static_cast<size_t>(sample / bucket_width_);
+
+		buckets_[std::min(index, buckets_.size() - 1)]++;
+
+		count_++;
+		sum_ += sample;
+		min_  = std::min(min_, sample);
+		max_  = std::max(max_, sample);
+	}
+
+	void clear () noexcept
+	{
+		std::fill(std::begin(buckets_), std::end(buckets_), 0u);
+
+		count_ = 0u;
+		sum_   = 0.0;
+		min_   = std::numeric_limits<double>::max();
+		max_   = std::numeric_limits<double>::lowest();
+	}
+
+	// Returns the upper edge of the bucket holding the given fraction (0 to 1) of the samples.
+	double get_percentile (double fraction) const noexcept
+	{
+		if (0 == count_)
+			return 0.0;
+
+		const auto target = static_cast<uint64_t>(fraction * (count_ - 1)) + 1;
+
+		auto count = uint64_t { 0 };
+		for (auto i = 0u; i != buckets_.size(); ++i)
+		{
+			count += buckets_[i];
+			if (count >= target)
+				return std::min((i + 1) * bucket_width_, max_);
+		}
+
+		return max_;
+	}
+
+	inline auto get_count () const noexcept
+	{
+		return count_;
+	}
+
+	inline auto get_mean () const noexcept
+	{
+		return count_ ? sum_ / count_ : 0.0;
+	}
+
+	inline auto get_min () const noexcept
+	{
+		return count_ ? min_ : 0.0;
+	}
+
+	inline auto get_max () const noexcept
+	{
+		return count_ ? max_ : 0.0;
+	}
+
+	inline auto get_bucket_width () const noexcept
+	{
+		return bucket_width_;
+	}
+
+	inline const auto& get_buckets () const noexcept
+	{
+		return buckets_;
+	}
+
+private:
+	double                bucket_width_;
+	std::vector<uint64_t> buckets_;
+	uint64_t              count_;
+	double                sum_;
+	double                min_;
+	double                max_;
+};
+
+}
+
+#endif
@@ -35,7 +35,7 @@ namespace utl
 template <typename Class>
 class Singleton : private Noncopyable, private Nonmovable
 {
-	template <typename Class>
+	template <typename>
 	friend class SingletonFactory;
 
 public:
@@ -0,0 +1,164 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef UTL_THREAD_POOL_H
+#define UTL_THREAD_POOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "noncopyable.h"
+#include "nonmovable.h"
+
+namespace utl
+{
+
+// Worker threads that run the iterations of a loop.
+//
+//   auto pool = utl::ThreadPool();
+//   pool.parallel_for(states.size(), [&](size_t i) { expand(states[i]); });
+//
+// parallel_for hands out the iterations one at a time from an atomic counter, runs them
+// on the workers and the calling thread, and returns when every one is done. One loop
+// runs at a time.
+class ThreadPool : private Noncopyable, private Nonmovable
+{
+public:
+	// The calling thread works too, so a pool of one thread has no workers.
+	explicit ThreadPool (uint32_t thread_count = std::thread::hardware_concurrency())
+		:
+		workers_   (       ),
+		mutex_     (       ),
+		start_     (       ),
+		done_      (       ),
+		job_       (nullptr),
+		count_     (0u     ),
+		next_      (0u     ),
+		finished_  (0u     ),
+		generation_(0u     ),
+		busy_      (0u     ),
+		stopped_   (false  )
+	{
+		for (auto i = 1u; i < thread_count; ++i)
+			workers_.emplace_back([this]() { work(); });
+	}
+
+	~ThreadPool ()
+	{
+		{
+			const auto lock = std::lock_guard<std::mutex>(mutex_);
+			stopped_ = true;
+		}
+		start_.notify_all();
+
+		for (auto& worker : workers_)
+			worker.join();
+	}
+
+	uint32_t get_thread_count () const noexcept
+	{
+		return static_cast<uint32_t>(workers_.size()) + 1u;
+	}
+
+	void parallel_for (size_t count, const std::function<void (size_t)>& job)
+	{
+		if (0 == count)
+			return;
+
+		{
+			const auto lock = std::lock_guard<std::mutex>(mutex_);
+
+			job_   = &job;
+			count_ = count;
+			next_.store(0u, std::memory_order_relaxed);
+			finished_.store(0u, std::memory_order_relaxed);
+			++generation_;
+		}
+		start_.notify_all();
+
+		run();
+
+		// The job lives on the caller's stack, so every worker must be out of it.
+		auto lock = std::unique_lock<std::mutex>(mutex_);
+		done_.wait(lock, [this]() { return finished_.load(std::memory_order_acquire) == count_ && 0 == busy_; });
+		job_ = nullptr;
+	}
+
+private:
+	void work ()
+	{
+		auto generation = uint64_t { 0 };
+		for (;;)
+		{
+			{
+				auto lock = std::unique_lock<std::mutex>(mutex_);
+				start_.wait(lock, [&]() { return stopped_ || generation != generation_; });
+
+				if (stopped_)
+					return;
+
+				generation = generation_;
+				++busy_;
+			}
+
+			run();
+
+			{
+				const auto lock = std::lock_guard<std::mutex>(mutex_);
+				--busy_;
+			}
+			done_.notify_one();
+		}
+	}
+
+	void run ()
+	{
+		for (auto i = next_.fetch_add(1u, std::memory_order_relaxed); i < count_; i = next_.fetch_add(1u, std::memory_order_relaxed))
+		{
+			(*job_)(i);
+			finished_.fetch_add(1u, std::memory_order_release);
+		}
+	}
+
+private:
+	std::vector<std::thread>            workers_;
+	std::mutex                          mutex_;
+	std::condition_variable             start_;
+	std::condition_variable             done_;
+	const std::function<void (size_t)>* job_;
+	size_t                              count_;
+	std::atomic<size_t>                 next_;
+	std::atomic<size_t>                 finished_;
+	uint64_t                            generation_;
+	uint32_t                            busy_;
+	bool                                stopped_;
+};
+
+}
+
+#endif
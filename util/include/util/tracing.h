@@ -0,0 +1,255 @@
+// MIT License
+// 
+// Copyright(c) 2018 Jang daemyung
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef UTL_TRACING_H
+#define UTL_TRACING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include "noncopyable.h"
+#include "nonmovable.h"
+
+namespace utl
+{
+
+// Collects timed spans into per thread buffers and exports them as Chrome trace events,
+// which chrome://tracing and Perfetto open.
+//
+//   utl::Tracing::enable(true);
+//   {
+//       UTL_TRACE_SCOPE("chip-8", "instruction_cycle");
+//       ...
+//   }
+//   utl::Tracing::write_json("session.json");
+//
+// A thread only ever appends to its own buffer, so recording takes no lock. A buffer is
+// allocated the first time its thread records and has a fixed capacity; spans beyond it
+// are dropped and counted. While tracing is disabled a scope costs one relaxed load.
+class Tracing : private Noncopyable, private Nonmovable
+{
+public:
+	static constexpr auto kSpanCapacity = size_t { 0x1 } << 16;
+
+	struct Span
+	{
+		const char* category;
+		const char* name;
+		uint64_t    begin; // ns
+		uint64_t    end;   // ns
+	};
+
+	static void enable (bool enabled) noexcept
+	{
+		enabled_.store(enabled, std::memory_order_relaxed);
+	}
+
+	static bool is_enabled () noexcept
+	{
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	static uint64_t now () noexcept
+	{
+		const auto time = std::chrono::steady_clock::now().time_since_epoch();
+
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+	}
+
+	// The category and the name must outlive the export, e.g. string literals.
+	static void record (const char* category, const char* name, uint64_t begin, uint64_t end)
+	{
+		auto& buffer = get_local_buffer();
+		const auto count = buffer.count.load(std::memory_order_relaxed);
+
+		if (count == kSpanCapacity)
+		{
+			buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		buffer.spans[count] = Span { category, name, begin, end };
+
+		// Publishes the span to write_json, which reads up to count.
+		buffer.count.store(count + 1, std::memory_order_release);
+	}
+
+	// Forgets the recorded spans. Call it while no thread records.
+	static void clear ()
+	{
+		const auto lock = std::lock_guard<std::mutex>(mutex_);
+
+		for (auto& buffer : buffers_)
+		{
+			buffer->count.store(0, std::memory_order_relaxed);
+			buffer->dropped.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	static uint64_t get_dropped_count ()
+	{
+		const auto lock = std::lock_guard<std::mutex>(mutex_);
+
+		auto dropped = uint64_t { 0 };
+		for (const auto& buffer : buffers_)
+			dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+		return dropped;
+	}
+
+	// Writes every recorded span as a complete ("X") event. It can run while other threads record.
+	static bool write_json (const std::string& path)
+	{
+		auto file = std::ofstream(path, std::ios::trunc);
+		if (!file)
+			return false;
+
+		const auto lock = std::lock_guard<std::mutex>(mutex_);
+
+		// Timestamps start from the first span, in microseconds.
+		auto origin = ~uint64_t { 0 };
+		for (const auto& buffer : buffers_)
+		{
+			const auto count = buffer->count.load(std::memory_order_acquire);
+			for (auto i = size_t { 0 }; i != count; ++i)
+				origin = std::min(origin, buffer->spans[i].begin);
+		}
+
+		file.setf(std::ios::fixed);
+		file.precision(3);
+
+		file << "{\"traceEvents\":[";
+
+		auto first = true;
+		for (const auto& buffer : buffers_)
+		{
+			const auto count = buffer->count.load(std::memory_order_acquire);
+			for (auto i = size_t { 0 }; i != count; ++i)
+			{
+				const auto& span = buffer->spans[i];
+
+				file << (first ? "\n" : ",\n")
+				     << "{\"cat\":\"" << span.category << "\",\"name\":\"" << span.name << "\",\"ph\":\"X\","
+				     << "\"ts\":"   << (span.begin - origin) / 1000.0 << ","
+				     << "\"dur\":"  << (span.end - span.begin) / 1000.0 << ","
+				     << "\"pid\":1,\"tid\":" << buffer->tid << "}";
+
+				first = false;
+			}
+		}
+
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		return static_cast<bool>(file);
+	}
+
+private:
+	struct Buffer
+	{
+		explicit Buffer (uint32_t id)
+			:
+			spans  (kSpanCapacity),
+			count  (0u           ),
+			dropped(0u           ),
+			tid    (id           )
+		{
+		}
+
+		std::vector<Span>     spans;
+		std::atomic<size_t>   count;
+		std::atomic<uint64_t> dropped;
+		uint32_t              tid;
+	};
+
+	static Buffer& get_local_buffer ()
+	{
+		// The registry shares the buffer, so its spans outlive the thread.
+		thread_local auto buffer = std::shared_ptr<Buffer>();
+
+		if (nullptr == buffer)
+		{
+			const auto lock = std::lock_guard<std::mutex>(mutex_);
+
+			buffer = std::make_shared<Buffer>(static_cast<uint32_t>(buffers_.size() + 1));
+			buffers_.push_back(buffer);
+		}
+
+		return *buffer;
+	}
+
+private:
+	inline static std::atomic<bool>                    enabled_ { false };
+	inline static std::mutex                           mutex_;
+	inline static std::vector<std::shared_ptr<Buffer>> buffers_;
+};
+
+// Records a span from its construction to its destruction, if tracing was enabled at both.
+class TraceScope : private Noncopyable, private Nonmovable
+{
+public:
+	TraceScope (const char* category, const char* name) noexcept
+		:
+		category_(category                                 ),
+		name_    (name                                     ),
+		begin_   (Tracing::is_enabled() ? Tracing::now() : 0)
+	{
+	}
+
+	~TraceScope ()
+	{
+		if (0 != begin_ && Tracing::is_enabled())
+			Tracing::record(category_, name_, begin_, Tracing::now());
+	}
+
+private:
+	const char* category_;
+	const char* name_;
+	uint64_t    begin_;
+};
+
+}
+
+#define UTL_TRACE_CONCAT_IMPL(a, b) a##b
+#define UTL_TRACE_CONCAT(a, b)      UTL_TRACE_CONCAT_IMPL(a, b)
+
+// Defining UTL_DISABLE_TRACING compiles the scopes away entirely.
+#ifdef UTL_DISABLE_TRACING
+
+#define UTL_TRACE_SCOPE(category, name)
+#define UTL_TRACE_FUNCTION(category)
+
+#else
+
+#define UTL_TRACE_SCOPE(category, name) const utl::TraceScope UTL_TRACE_CONCAT(utl_trace_scope_, __LINE__)(category, name)
+#define UTL_TRACE_FUNCTION(category)    UTL_TRACE_SCOPE(category, __func__)
+
+#endif
+
+#endif